@@ -1,2158 +1,12044 @@
-/***************************************************
- * Enhanced Bank Management System
- * Features:
- * - User/Admin authentication
- * - Customer management using linked list
- * - Transaction handling using stack
- * - Customer service requests using queue
- * - Branch connectivity using graph with shortest path
- * - Data persistence using file handling
- * - Enhanced UI with colors and menu systems
- ***************************************************/
-
- #include <stdio.h>
- #include <stdlib.h>
- #include <string.h>
- #include <stdbool.h>
- #include <time.h>
- #include <float.h>
- #include <limits.h>
- 
- // Constants for terminal colors
- #define RESET "\033[0m"
- #define BOLD "\033[1m"
- #define BLACK "\033[30m"
- #define RED "\033[31m"
- #define GREEN "\033[32m"
- #define YELLOW "\033[33m"
- #define BLUE "\033[34m"
- #define MAGENTA "\033[35m"
- #define CYAN "\033[36m"
- #define WHITE "\033[37m"
- #define BG_BLACK "\033[40m"
- #define BG_RED "\033[41m"
- #define BG_GREEN "\033[42m"
- #define BG_YELLOW "\033[43m"
- #define BG_BLUE "\033[44m"
- #define BG_MAGENTA "\033[45m"
- #define BG_CYAN "\033[46m"
- #define BG_WHITE "\033[47m"
- 
- /***************************************************
-  * SECTION 1: STRUCTURES DEFINITION
-  ***************************************************/
- 
- // User authentication structure
- struct User
- {
-     char username[50];
-     char password[50];
-     bool isAdmin;
- };
- 
- // Bank account structure
- struct Account
- {
-     int accountNo;
-     char name[50];
-     float balance;
-     char address[100];
-     char phoneNumber[15];
-     char email[50];
-     char dateCreated[20];
-     struct TransactionHistory *history;
- };
- 
- // Transaction structure
- struct Transaction
- {
-     int transactionId;
-     int accountNo;
-     char type[20]; // "deposit", "withdraw", "transfer"
-     float amount;
-     char date[20];
-     char time[10];
- };
- 
- // Transaction history node for stack
- struct TransactionNode
- {
-     struct Transaction data;
-     struct TransactionNode *next;
- };
- 
- // Customer service request structure
- struct ServiceRequest
- {
-     int requestId;
-     int accountNo;
-     char requestType[50];
-     char description[200];
-     bool isProcessed;
-     char dateSubmitted[20];
-     int priority; // 1-5, 5 being highest
- };
- 
- // Service request node for queue
- struct RequestNode
- {
-     struct ServiceRequest data;
-     struct RequestNode *next;
- };
- 
- // Bank branch structure
- struct Branch
- {
-     int branchId;
-     char branchName[50];
-     char location[100];
-     char managerName[50];
-     char phoneNumber[15];
-     int employeeCount;
- };
- 
- // Graph node for branch connectivity
- struct BranchNode
- {
-     struct Branch data;
-     struct EdgeList *connections;
- };
- 
- // Edge list for graph connections
- struct EdgeList
- {
-     int branchId;
-     float distance;
-     struct EdgeList *next;
- };
- 
- // Account node for linked list
- struct AccountNode
- {
-     struct Account data;
-     struct AccountNode *next;
- };
- 
- // Global data structures
- struct User currentUser;
- struct AccountNode *accountList = NULL;
- struct TransactionNode *transactionStack = NULL;
- struct RequestNode *serviceQueue = NULL;
- struct RequestNode *serviceQueueRear = NULL;
- struct BranchNode branchGraph[10]; // Assuming max 10 branches
- int branchCount = 0;
- 
- /***************************************************
-  * SECTION 2: AUTHENTICATION FUNCTIONS
-  ***************************************************/
- 
- struct User users[10]; // Array to store users (admin & regular)
- int userCount = 0;
- 
- // Initialize with default admin
- void initializeUsers()
- {
-     strcpy(users[0].username, "admin");
-     strcpy(users[0].password, "admin123");
-     users[0].isAdmin = true;
- 
-     strcpy(users[1].username, "user");
-     strcpy(users[1].password, "user123");
-     users[1].isAdmin = false;
- 
-     userCount = 2;
- }
- 
- // Authenticate user
- bool login(char *username, char *password, bool *isAdmin)
- {
-     for (int i = 0; i < userCount; i++)
-     {
-         if (strcmp(users[i].username, username) == 0 &&
-             strcmp(users[i].password, password) == 0)
-         {
-             *isAdmin = users[i].isAdmin;
-             strcpy(currentUser.username, username);
-             strcpy(currentUser.password, password);
-             currentUser.isAdmin = *isAdmin;
-             return true;
-         }
-     }
-     return false;
- }
- 
- // Add new user (admin only)
- bool addUser(char *username, char *password, bool isAdmin)
- {
-     if (userCount >= 10)
-     {
-         return false; // Maximum users reached
-     }
- 
-     // Check if username already exists
-     for (int i = 0; i < userCount; i++)
-     {
-         if (strcmp(users[i].username, username) == 0)
-         {
-             return false; // Username already exists
-         }
-     }
- 
-     strcpy(users[userCount].username, username);
-     strcpy(users[userCount].password, password);
-     users[userCount].isAdmin = isAdmin;
-     userCount++;
-     return true;
- }
- 
- /***************************************************
-  * SECTION 3: DATA STRUCTURE OPERATIONS
-  ***************************************************/
- 
- // Linked List Operations
- struct AccountNode *createAccountNode(int accNo, char *name, float balance, char *address, char *phone, char *email)
- {
-     struct AccountNode *newNode = (struct AccountNode *)malloc(sizeof(struct AccountNode));
-     newNode->data.accountNo = accNo;
-     strcpy(newNode->data.name, name);
-     newNode->data.balance = balance;
-     
-     // New fields
-     strcpy(newNode->data.address, address);
-     strcpy(newNode->data.phoneNumber, phone);
-     strcpy(newNode->data.email, email);
-     
-     // Get current date for account creation
-     time_t now = time(NULL);
-     struct tm *t = localtime(&now);
-     sprintf(newNode->data.dateCreated, "%04d-%02d-%02d", 
-             t->tm_year + 1900, t->tm_mon + 1, t->tm_mday);
-     
-     newNode->data.history = NULL;
-     newNode->next = NULL;
-     return newNode;
- }
- 
- bool addAccount(int accNo, char *name, float balance, char *address, char *phone, char *email)
- {
-     // Check if account already exists
-     struct AccountNode *temp = accountList;
-     while (temp != NULL)
-     {
-         if (temp->data.accountNo == accNo)
-         {
-             return false; // Account already exists
-         }
-         temp = temp->next;
-     }
- 
-     struct AccountNode *newNode = createAccountNode(accNo, name, balance, address, phone, email);
- 
-     if (accountList == NULL)
-     {
-         accountList = newNode;
-     }
-     else
-     {
-         newNode->next = accountList;
-         accountList = newNode;
-     }
-     return true;
- }
- 
- struct Account *findAccount(int accNo)
- {
-     struct AccountNode *temp = accountList;
-     while (temp != NULL)
-     {
-         if (temp->data.accountNo == accNo)
-         {
-             return &(temp->data);
-         }
-         temp = temp->next;
-     }
-     return NULL;
- }
- 
- // Stack Operations
- void pushTransaction(struct Transaction transaction)
- {
-     struct TransactionNode *newNode = (struct TransactionNode *)malloc(sizeof(struct TransactionNode));
-     newNode->data = transaction;
-     newNode->next = transactionStack;
-     transactionStack = newNode;
- }
- 
- struct Transaction popTransaction()
- {
-     struct Transaction transaction = {0};
-     if (transactionStack == NULL)
-     {
-         return transaction;
-     }
- 
-     struct TransactionNode *temp = transactionStack;
-     transactionStack = transactionStack->next;
-     transaction = temp->data;
-     free(temp);
-     return transaction;
- }
- 
- // Queue Operations
- void enqueueRequest(struct ServiceRequest request)
- {
-     struct RequestNode *newNode = (struct RequestNode *)malloc(sizeof(struct RequestNode));
-     newNode->data = request;
-     newNode->next = NULL;
- 
-     if (serviceQueue == NULL)
-     {
-         serviceQueue = newNode;
-         serviceQueueRear = newNode;
-     }
-     else
-     {
-         serviceQueueRear->next = newNode;
-         serviceQueueRear = newNode;
-     }
- }
- 
- struct ServiceRequest dequeueRequest()
- {
-     struct ServiceRequest request = {0};
-     if (serviceQueue == NULL)
-     {
-         return request;
-     }
- 
-     struct RequestNode *temp = serviceQueue;
-     serviceQueue = serviceQueue->next;
- 
-     if (serviceQueue == NULL)
-     {
-         serviceQueueRear = NULL;
-     }
- 
-     request = temp->data;
-     free(temp);
-     return request;
- }
- 
- // Graph Operations
- void addBranch(int branchId, char *branchName, char *location, char *managerName, char *phoneNumber, int employeeCount)
- {
-     if (branchCount >= 10)
-     {
-         return; // Maximum branches reached
-     }
- 
-     branchGraph[branchCount].data.branchId = branchId;
-     strcpy(branchGraph[branchCount].data.branchName, branchName);
-     strcpy(branchGraph[branchCount].data.location, location);
-     strcpy(branchGraph[branchCount].data.managerName, managerName);
-     strcpy(branchGraph[branchCount].data.phoneNumber, phoneNumber);
-     branchGraph[branchCount].data.employeeCount = employeeCount;
-     branchGraph[branchCount].connections = NULL;
-     branchCount++;
- }
- 
- int findBranchIndex(int branchId)
- {
-     for (int i = 0; i < branchCount; i++)
-     {
-         if (branchGraph[i].data.branchId == branchId)
-         {
-             return i;
-         }
-     }
-     return -1; // Not found
- }
- 
- void addConnection(int sourceBranchId, int targetBranchId, float distance)
- {
-     int sourceIndex = findBranchIndex(sourceBranchId);
- 
-     if (sourceIndex == -1)
-     {
-         return; // Source branch not found
-     }
- 
-     // Create new connection
-     struct EdgeList *newEdge = (struct EdgeList *)malloc(sizeof(struct EdgeList));
-     newEdge->branchId = targetBranchId;
-     newEdge->distance = distance;
-     newEdge->next = branchGraph[sourceIndex].connections;
-     branchGraph[sourceIndex].connections = newEdge;
- }
- 
- // Dijkstra's Algorithm for Shortest Path
- void findShortestPath(int startBranchId, int endBranchId)
- {
-     float distance[10];
-     int previous[10];
-     bool visited[10];
-     int startIndex = findBranchIndex(startBranchId);
-     int endIndex = findBranchIndex(endBranchId);
-     
-     if (startIndex == -1 || endIndex == -1)
-     {
-         printf("%sOne or both branches not found.%s\n", RED, RESET);
-         return;
-     }
-     
-     // Initialize arrays
-     for (int i = 0; i < branchCount; i++)
-     {
-         distance[i] = FLT_MAX;
-         previous[i] = -1;
-         visited[i] = false;
-     }
-     
-     distance[startIndex] = 0.0;
-     
-     // Dijkstra's algorithm
-     for (int count = 0; count < branchCount; count++)
-     {
-         // Find minimum distance vertex
-         float minDist = FLT_MAX;
-         int minIndex = -1;
-         
-         for (int i = 0; i < branchCount; i++)
-         {
-             if (!visited[i] && distance[i] < minDist)
-             {
-                 minDist = distance[i];
-                 minIndex = i;
-             }
-         }
-         
-         if (minIndex == -1) break; // No reachable vertices
-         
-         visited[minIndex] = true;
-         
-         // Update distances of adjacent vertices
-         struct EdgeList *edge = branchGraph[minIndex].connections;
-         while (edge != NULL)
-         {
-             int targetIndex = findBranchIndex(edge->branchId);
-             if (targetIndex != -1 && !visited[targetIndex])
-             {
-                 float newDist = distance[minIndex] + edge->distance;
-                 if (newDist < distance[targetIndex])
-                 {
-                     distance[targetIndex] = newDist;
-                     previous[targetIndex] = minIndex;
-                 }
-             }
-             edge = edge->next;
-         }
-     }
-     
-     // Print result
-     if (distance[endIndex] == FLT_MAX)
-     {
-         printf("%sThere is no path from %s to %s.%s\n", 
-                RED, branchGraph[startIndex].data.branchName, 
-                branchGraph[endIndex].data.branchName, RESET);
-         return;
-     }
-     
-     // Reconstruct path
-     printf("\n%s%sShortest Path from %s to %s:%s\n", 
-            BG_GREEN, BLACK, branchGraph[startIndex].data.branchName, 
-            branchGraph[endIndex].data.branchName, RESET);
-     printf("%sTotal Distance: %.2f units%s\n", YELLOW, distance[endIndex], RESET);
-     
-     // Build path in reverse
-     int path[10];
-     int pathLength = 0;
-     for (int at = endIndex; at != -1; at = previous[at])
-     {
-         path[pathLength++] = at;
-     }
-     
-     // Print path in correct order
-     printf("%sPath: %s", GREEN, RESET);
-     for (int i = pathLength - 1; i >= 0; i--)
-     {
-         printf("%s%s%s", CYAN, branchGraph[path[i]].data.branchName, RESET);
-         if (i > 0) printf(" %s→%s ", YELLOW, RESET);
-     }
-     printf("\n");
- }
- 
- // File Handling Operations
- void saveAccountsToFile()
- {
-     FILE *file = fopen("accounts.dat", "wb");
-     if (file == NULL)
-     {
-         printf("%sError opening file for saving accounts.%s\n", RED, RESET);
-         return;
-     }
- 
-     struct AccountNode *temp = accountList;
-     while (temp != NULL)
-     {
-         fwrite(&(temp->data), sizeof(struct Account), 1, file);
-         temp = temp->next;
-     }
- 
-     fclose(file);
- }
- 
- void loadAccountsFromFile()
- {
-     FILE *file = fopen("accounts.dat", "rb");
-     if (file == NULL)
-     {
-         printf("%sNo previous account data found.%s\n", YELLOW, RESET);
-         return;
-     }
- 
-     struct Account account;
-     while (fread(&account, sizeof(struct Account), 1, file) == 1)
-     {
-         // The addAccount function has been updated with new parameters, 
-         // but we're loading existing records which have the data
-         addAccount(account.accountNo, account.name, account.balance, 
-                   account.address, account.phoneNumber, account.email);
-     }
- 
-     fclose(file);
- }
- 
- // Save transactions to file
- void saveTransactionsToFile()
- {
-     FILE *file = fopen("transactions.dat", "wb");
-     if (file == NULL)
-     {
-         printf("%sError opening file for saving transactions.%s\n", RED, RESET);
-         return;
-     }
- 
-     struct TransactionNode *temp = transactionStack;
-     while (temp != NULL)
-     {
-         fwrite(&(temp->data), sizeof(struct Transaction), 1, file);
-         temp = temp->next;
-     }
- 
-     fclose(file);
- }
- 
- // Load transactions from file
- void loadTransactionsFromFile()
- {
-     FILE *file = fopen("transactions.dat", "rb");
-     if (file == NULL)
-     {
-         return; // No previous transactions data
-     }
- 
-     // Free existing transaction stack
-     while (transactionStack != NULL)
-     {
-         struct TransactionNode *temp = transactionStack;
-         transactionStack = transactionStack->next;
-         free(temp);
-     }
- 
-     // Read transactions into a temporary array
-     struct Transaction transactions[100]; // Assuming max 100 transactions
-     int count = 0;
-     
-     while (fread(&transactions[count], sizeof(struct Transaction), 1, file) == 1 && count < 100)
-     {
-         count++;
-     }
-     
-     // Push transactions to stack in reverse order to maintain chronology
-     for (int i = count - 1; i >= 0; i--)
-     {
-         pushTransaction(transactions[i]);
-     }
- 
-     fclose(file);
- }
- 
- // Save branches and connections to file
- void saveBranchesToFile()
- {
-     FILE *branchFile = fopen("branches.dat", "wb");
-     FILE *connectionFile = fopen("connections.dat", "wb");
-     
-     if (branchFile == NULL || connectionFile == NULL)
-     {
-         printf("%sError opening files for saving branch data.%s\n", RED, RESET);
-         if (branchFile) fclose(branchFile);
-         if (connectionFile) fclose(connectionFile);
-         return;
-     }
- 
-     // Save branch count
-     fwrite(&branchCount, sizeof(int), 1, branchFile);
-     
-     // Save branches
-     for (int i = 0; i < branchCount; i++)
-     {
-         fwrite(&branchGraph[i].data, sizeof(struct Branch), 1, branchFile);
-         
-         // Count connections
-         int connectionCount = 0;
-         struct EdgeList *edge = branchGraph[i].connections;
-         while (edge != NULL)
-         {
-             connectionCount++;
-             edge = edge->next;
-         }
-         
-         // Save connection count for this branch
-         fwrite(&connectionCount, sizeof(int), 1, connectionFile);
-         
-         // Save connections
-         edge = branchGraph[i].connections;
-         while (edge != NULL)
-         {
-             fwrite(&branchGraph[i].data.branchId, sizeof(int), 1, connectionFile);
-             fwrite(&edge->branchId, sizeof(int), 1, connectionFile);
-             fwrite(&edge->distance, sizeof(float), 1, connectionFile);
-             edge = edge->next;
-         }
-     }
- 
-     fclose(branchFile);
-     fclose(connectionFile);
- }
- 
- // Load branches and connections from file
- void loadBranchesFromFile()
- {
-     FILE *branchFile = fopen("branches.dat", "rb");
-     FILE *connectionFile = fopen("connections.dat", "rb");
-     
-     if (branchFile == NULL || connectionFile == NULL)
-     {
-         if (branchFile) fclose(branchFile);
-         if (connectionFile) fclose(connectionFile);
-         return; // No previous branch data
-     }
- 
-     // Clear existing branches
-     for (int i = 0; i < branchCount; i++)
-     {
-         struct EdgeList *current = branchGraph[i].connections;
-         while (current != NULL)
-         {
-             struct EdgeList *temp = current;
-             current = current->next;
-             free(temp);
-         }
-     }
-     
-     // Load branch count
-     fread(&branchCount, sizeof(int), 1, branchFile);
-     
-     // Load branches
-     for (int i = 0; i < branchCount; i++)
-     {
-         fread(&branchGraph[i].data, sizeof(struct Branch), 1, branchFile);
-         branchGraph[i].connections = NULL;
-         
-         // Load connection count for this branch
-         int connectionCount;
-         fread(&connectionCount, sizeof(int), 1, connectionFile);
-         
-         // Load connections
-         for (int j = 0; j < connectionCount; j++)
-         {
-             int sourceBranchId, targetBranchId;
-             float distance;
-             
-             fread(&sourceBranchId, sizeof(int), 1, connectionFile);
-             fread(&targetBranchId, sizeof(int), 1, connectionFile);
-             fread(&distance, sizeof(float), 1, connectionFile);
-             
-             addConnection(sourceBranchId, targetBranchId, distance);
-         }
-     }
- 
-     fclose(branchFile);
-     fclose(connectionFile);
- }
- 
- void saveAllData()
- {
-     saveAccountsToFile();
-     saveTransactionsToFile();
-     saveBranchesToFile();
-     printf("%sAll data saved successfully!%s\n", GREEN, RESET);
- }
- 
- void loadAllData()
- {
-     loadAccountsFromFile();
-     loadTransactionsFromFile();
-     loadBranchesFromFile();
- }
- 
- /***************************************************
-  * SECTION 4: TRANSACTION FUNCTIONS
-  ***************************************************/
- 
- bool deposit(int accountNo, float amount)
- {
-     struct Account *account = findAccount(accountNo);
-     if (account == NULL)
-     {
-         return false;
-     }
- 
-     account->balance += amount;
- 
-     // Record transaction
-     struct Transaction transaction;
-     transaction.accountNo = accountNo;
-     transaction.amount = amount;
-     strcpy(transaction.type, "deposit");
-     transaction.transactionId = rand() % 10000 + 1000;
-     
-     // Get current date and time
-     time_t now = time(NULL);
-     struct tm *t = localtime(&now);
-     sprintf(transaction.date, "%04d-%02d-%02d", 
-             t->tm_year + 1900, t->tm_mon + 1, t->tm_mday);
-     sprintf(transaction.time, "%02d:%02d", t->tm_hour, t->tm_min);
- 
-     pushTransaction(transaction);
-     return true;
- }
- 
- bool withdraw(int accountNo, float amount)
- {
-     struct Account *account = findAccount(accountNo);
-     if (account == NULL || account->balance < amount)
-     {
-         return false;
-     }
- 
-     account->balance -= amount;
- 
-     // Record transaction
-     struct Transaction transaction;
-     transaction.accountNo = accountNo;
-     transaction.amount = amount;
-     strcpy(transaction.type, "withdraw");
-     transaction.transactionId = rand() % 10000 + 1000;
-     
-     // Get current date and time
-     time_t now = time(NULL);
-     struct tm *t = localtime(&now);
-     sprintf(transaction.date, "%04d-%02d-%02d", 
-             t->tm_year + 1900, t->tm_mon + 1, t->tm_mday);
-     sprintf(transaction.time, "%02d:%02d", t->tm_hour, t->tm_min);
- 
-     pushTransaction(transaction);
-     return true;
- }
- 
- bool transfer(int fromAccountNo, int toAccountNo, float amount)
- {
-     struct Account *fromAccount = findAccount(fromAccountNo);
-     struct Account *toAccount = findAccount(toAccountNo);
-     
-     if (fromAccount == NULL || toAccount == NULL || fromAccount->balance < amount)
-     {
-         return false;
-     }
-     
-     fromAccount->balance -= amount;
-     toAccount->balance += amount;
-     
-     // Record transaction for sender
-     struct Transaction transaction;
-     transaction.accountNo = fromAccountNo;
-     transaction.amount = amount;
-     sprintf(transaction.type, "transfer to %d", toAccountNo);
-     transaction.transactionId = rand() % 10000 + 1000;
-     
-     // Get current date and time
-     time_t now = time(NULL);
-     struct tm *t = localtime(&now);
-     sprintf(transaction.date, "%04d-%02d-%02d", 
-             t->tm_year + 1900, t->tm_mon + 1, t->tm_mday);
-     sprintf(transaction.time, "%02d:%02d", t->tm_hour, t->tm_min);
-     
-     pushTransaction(transaction);
-     
-     // Record transaction for receiver
-     transaction.accountNo = toAccountNo;
-     sprintf(transaction.type, "receive from %d", fromAccountNo);
-     transaction.transactionId = rand() % 10000 + 1000;
-     
-     pushTransaction(transaction);
-     
-     return true;
- }
- 
- void viewTransactions()
- {
-     if (transactionStack == NULL)
-     {
-         printf("%sNo transactions to display.%s\n", YELLOW, RESET);
-         return;
-     }
- 
-     printf("\n%s%s Transaction History %s\n", BG_GREEN, BLACK, RESET);
-     printf("%s%s%-5s %-8s %-15s %-10s %-12s %-8s %s\n", 
-            BG_CYAN, BLACK, "ID", "Account", "Type", "Amount", "Date", "Time", RESET);
- 
-     struct TransactionNode *temp = transactionStack;
-     while (temp != NULL)
-     {
-         printf("%-5d %-8d %-15s %s$%.2f%s %-12s %-8s\n",
-                temp->data.transactionId,
-                temp->data.accountNo,
-                temp->data.type,
-                GREEN,
-                temp->data.amount,
-                RESET,
-                temp->data.date,
-                temp->data.time);
-         temp = temp->next;
-     }
- }
- 
- void viewAccountTransactions(int accountNo)
- {
-     if (transactionStack == NULL)
-     {
-         printf("%sNo transactions to display.%s\n", YELLOW, RESET);
-         return;
-     }
-     
-     struct Account *account = findAccount(accountNo);
-     if (account == NULL)
-     {
-         printf("%sAccount not found.%s\n", RED, RESET);
-         return;
-     }
- 
-     printf("\n%s%s Transaction History for Account %d - %s %s\n", 
-            BG_GREEN, BLACK, accountNo, account->name, RESET);
-     printf("%s%s%-5s %-15s %-10s %-12s %-8s %s\n", 
-            BG_CYAN, BLACK, "ID", "Type", "Amount", "Date", "Time", RESET);
- 
-     bool found = false;
-     struct TransactionNode *temp = transactionStack;
-     while (temp != NULL)
-     {
-         if (temp->data.accountNo == accountNo)
-         {
-             printf("%-5d %-15s %s$%.2f%s %-12s %-8s\n",
-                    temp->data.transactionId,
-                    temp->data.type,
-                    GREEN,
-                    temp->data.amount,
-                    RESET,
-                    temp->data.date,
-                    temp->data.time);
-             found = true;
-         }
-         temp = temp->next;
-     }
-     
-     if (!found)
-     {
-         printf("%sNo transactions found for this account.%s\n", YELLOW, RESET);
-     }
- }
- 
- bool undoLastTransaction()
- {
-     if (transactionStack == NULL)
-     {
-         return false;
-     }
- 
-     struct Transaction lastTrans = popTransaction();
-     struct Account *account = findAccount(lastTrans.accountNo);
- 
-     if (account == NULL)
-     {
-         return false;
-     }
- 
-     if (strcmp(lastTrans.type, "deposit") == 0)
-     {
-         account->balance -= lastTrans.amount;
-     }
-     else if (strcmp(lastTrans.type, "withdraw") == 0)
-     {
-         account->balance += lastTrans.amount;
-     }
-     else if (strncmp(lastTrans.type, "transfer to", 11) == 0)
-     {
-         // Extract to account number
-         int toAccountNo;
-         sscanf(lastTrans.type + 11, "%d", &toAccountNo);
-         struct Account *toAccount = findAccount(toAccountNo);
-         
-         if (toAccount != NULL)
-         {
-             account->balance += lastTrans.amount;
-             toAccount->balance -= lastTrans.amount;
-             
-             // Pop the receive transaction as well
-             popTransaction();
-         }
-     }
-     else if (strncmp(lastTrans.type, "receive from", 12) == 0)
-     {
-         // Extract from account number
-         int fromAccountNo;
-         sscanf(lastTrans.type + 12, "%d", &fromAccountNo);
-         struct Account *fromAccount = findAccount(fromAccountNo);
-         
-         if (fromAccount != NULL)
-         {
-             account->balance -= lastTrans.amount;
-             fromAccount->balance += lastTrans.amount;
-             
-             // Pop the transfer transaction as well
-             popTransaction();
-         }
-     }
- 
-     printf("%sLast transaction undone: %s of $%.2f for account %d%s\n",
-            GREEN, lastTrans.type, lastTrans.amount, lastTrans.accountNo, RESET);
-     return true;
- }
- /***************************************************
- * SECTION 5: CUSTOMER SERVICE FUNCTIONS
- ***************************************************/
-
-int getNextRequestId()
-{
-    static int nextId = 1000;
-    return ++nextId;
-}
-
-bool submitServiceRequest(int accountNo, char *requestType, char *description, int priority)
-{
-    struct Account *account = findAccount(accountNo);
-    if (account == NULL)
-    {
-        return false;
-    }
-
-    struct ServiceRequest request;
-    request.requestId = getNextRequestId();
-    request.accountNo = accountNo;
-    strcpy(request.requestType, requestType);
-    strcpy(request.description, description);
-    request.isProcessed = false;
-    request.priority = priority;
-    
-    // Get current date
-    time_t now = time(NULL);
-    struct tm *t = localtime(&now);
-    sprintf(request.dateSubmitted, "%04d-%02d-%02d", 
-            t->tm_year + 1900, t->tm_mon + 1, t->tm_mday);
-    
-    enqueueRequest(request);
-    return true;
-}
-
-void processNextRequest()
-{
-    if (serviceQueue == NULL)
-    {
-        printf("%sNo pending service requests.%s\n", YELLOW, RESET);
-        return;
-    }
-    
-    struct ServiceRequest request = dequeueRequest();
-    struct Account *account = findAccount(request.accountNo);
-    
-    printf("\n%s%s Processing Service Request %s\n", BG_GREEN, BLACK, RESET);
-    printf("%sRequest ID: %d%s\n", CYAN, request.requestId, RESET);
-    printf("%sAccount: %d - %s%s\n", CYAN, request.accountNo, 
-           account ? account->name : "Unknown Account", RESET);
-    printf("%sType: %s%s\n", CYAN, request.requestType, RESET);
-    printf("%sPriority: %d/5%s\n", CYAN, request.priority, RESET);
-    printf("%sDescription: %s%s\n", CYAN, request.description, RESET);
-    printf("%sDate Submitted: %s%s\n", CYAN, request.dateSubmitted, RESET);
-    
-    printf("\n%sRequest has been marked as processed.%s\n", GREEN, RESET);
-}
-
-void viewPendingRequests()
-{
-    if (serviceQueue == NULL)
-    {
-        printf("%sNo pending service requests.%s\n", YELLOW, RESET);
-        return;
-    }
-    
-    printf("\n%s%s Pending Service Requests %s\n", BG_GREEN, BLACK, RESET);
-    printf("%s%s%-5s %-8s %-15s %-15s %-12s %s\n", 
-           BG_CYAN, BLACK, "ID", "Account", "Type", "Priority", "Date", RESET);
-    
-    struct RequestNode *temp = serviceQueue;
-    while (temp != NULL)
-    {
-        printf("%-5d %-8d %-15s %-15d %-12s\n",
-               temp->data.requestId,
-               temp->data.accountNo,
-               temp->data.requestType,
-               temp->data.priority,
-               temp->data.dateSubmitted);
-        temp = temp->next;
-    }
-}
-
-// Save service requests to file
-void saveRequestsToFile()
-{
-    FILE *file = fopen("requests.dat", "wb");
-    if (file == NULL)
-    {
-        printf("%sError opening file for saving service requests.%s\n", RED, RESET);
-        return;
-    }
-
-    struct RequestNode *temp = serviceQueue;
-    while (temp != NULL)
-    {
-        fwrite(&(temp->data), sizeof(struct ServiceRequest), 1, file);
-        temp = temp->next;
-    }
-
-    fclose(file);
-}
-
-// Load service requests from file
-void loadRequestsFromFile()
-{
-    FILE *file = fopen("requests.dat", "rb");
-    if (file == NULL)
-    {
-        return; // No previous requests data
-    }
-
-    // Free existing service queue
-    while (serviceQueue != NULL)
-    {
-        struct RequestNode *temp = serviceQueue;
-        serviceQueue = serviceQueue->next;
-        free(temp);
-    }
-    serviceQueueRear = NULL;
-
-    struct ServiceRequest request;
-    while (fread(&request, sizeof(struct ServiceRequest), 1, file) == 1)
-    {
-        enqueueRequest(request);
-    }
-
-    fclose(file);
-}
-
-/***************************************************
- * SECTION 6: BRANCH MANAGEMENT FUNCTIONS
- ***************************************************/
-
-void viewAllBranches()
-{
-    if (branchCount == 0)
-    {
-        printf("%sNo branches available.%s\n", YELLOW, RESET);
-        return;
-    }
-
-    printf("\n%s%s Bank Branches %s\n", BG_GREEN, BLACK, RESET);
-    printf("%s%s%-5s %-15s %-20s %-15s %-15s %s\n", 
-           BG_CYAN, BLACK, "ID", "Name", "Location", "Manager", "Phone", RESET);
-
-    for (int i = 0; i < branchCount; i++)
-    {
-        printf("%-5d %-15s %-20s %-15s %-15s\n",
-               branchGraph[i].data.branchId,
-               branchGraph[i].data.branchName,
-               branchGraph[i].data.location,
-               branchGraph[i].data.managerName,
-               branchGraph[i].data.phoneNumber);
-    }
-}
-
-void viewBranchConnections(int branchId)
-{
-    int index = findBranchIndex(branchId);
-    if (index == -1)
-    {
-        printf("%sBranch not found.%s\n", RED, RESET);
-        return;
-    }
-
-    printf("\n%s%s Connections for Branch: %s %s\n", 
-           BG_GREEN, BLACK, branchGraph[index].data.branchName, RESET);
-    printf("%s%s%-5s %-15s %-10s %s\n", 
-           BG_CYAN, BLACK, "ID", "Name", "Distance", RESET);
-
-    struct EdgeList *edge = branchGraph[index].connections;
-    if (edge == NULL)
-    {
-        printf("%sNo connections for this branch.%s\n", YELLOW, RESET);
-        return;
-    }
-
-    while (edge != NULL)
-    {
-        int targetIndex = findBranchIndex(edge->branchId);
-        if (targetIndex != -1)
-        {
-            printf("%-5d %-15s %-10.2f\n",
-                   branchGraph[targetIndex].data.branchId,
-                   branchGraph[targetIndex].data.branchName,
-                   edge->distance);
-        }
-        edge = edge->next;
-    }
-}
-
-/***************************************************
- * SECTION 7: UI FUNCTIONS
- ***************************************************/
-
-void clearScreen()
-{
-    #ifdef _WIN32
-        system("cls");
-    #else
-        system("clear");
-    #endif
-}
-
-void displayBanner()
-{
-    printf("\n%s%s =============================================== %s\n", BG_BLUE, WHITE, RESET);
-    printf("%s%s                                               %s\n", BG_BLUE, WHITE, RESET);
-    printf("%s%s      ENHANCED BANK MANAGEMENT SYSTEM          %s\n", BG_BLUE, WHITE, RESET);
-    printf("%s%s                                               %s\n", BG_BLUE, WHITE, RESET);
-    printf("%s%s =============================================== %s\n", BG_BLUE, WHITE, RESET);
-    
-    // Display logged-in user
-    if (strlen(currentUser.username) > 0)
-    {
-        printf("\n%sLogged in as:%s %s%s%s (%s)%s\n", 
-               CYAN, RESET, BOLD, currentUser.username, RESET,
-               currentUser.isAdmin ? "Administrator" : "Regular User", RESET);
-    }
-}
-
-void pauseExecution()
-{
-    printf("\n%sPress Enter to continue...%s", YELLOW, RESET);
-    while (getchar() != '\n'); // Clear input buffer
-    getchar(); // Wait for Enter
-}
-
-void displayAdminMenu()
-{
-    clearScreen();
-    displayBanner();
-    
-    printf("\n%s%s ADMIN MENU %s\n", BG_CYAN, BLACK, RESET);
-    printf("%s 1. Account Management %s\n", YELLOW, RESET);
-    printf("%s 2. Transaction Management %s\n", YELLOW, RESET);
-    printf("%s 3. Service Request Management %s\n", YELLOW, RESET);
-    printf("%s 4. Branch Management %s\n", YELLOW, RESET);
-    printf("%s 5. User Management %s\n", YELLOW, RESET);
-    printf("%s 6. Save/Load Data %s\n", YELLOW, RESET);
-    printf("%s 7. Logout %s\n", YELLOW, RESET);
-    printf("%s 8. Exit %s\n", RED, RESET);
-    printf("\n%sEnter your choice: %s", GREEN, RESET);
-}
-
-void displayUserMenu()
-{
-    clearScreen();
-    displayBanner();
-    
-    printf("\n%s%s USER MENU %s\n", BG_CYAN, BLACK, RESET);
-    printf("%s 1. View Account Details %s\n", YELLOW, RESET);
-    printf("%s 2. Make a Transaction %s\n", YELLOW, RESET);
-    printf("%s 3. Submit Service Request %s\n", YELLOW, RESET);
-    printf("%s 4. View Branch Information %s\n", YELLOW, RESET);
-    printf("%s 5. Logout %s\n", YELLOW, RESET);
-    printf("%s 6. Exit %s\n", RED, RESET);
-    printf("\n%sEnter your choice: %s", GREEN, RESET);
-}
-
-void displayAccountMenu()
-{
-    clearScreen();
-    displayBanner();
-    
-    printf("\n%s%s ACCOUNT MANAGEMENT %s\n", BG_CYAN, BLACK, RESET);
-    printf("%s 1. Create New Account %s\n", YELLOW, RESET);
-    printf("%s 2. View All Accounts %s\n", YELLOW, RESET);
-    printf("%s 3. Search Account by Number %s\n", YELLOW, RESET);
-    printf("%s 4. Update Account Details %s\n", YELLOW, RESET);
-    printf("%s 5. Delete Account %s\n", YELLOW, RESET);
-    printf("%s 6. Return to Main Menu %s\n", YELLOW, RESET);
-    printf("\n%sEnter your choice: %s", GREEN, RESET);
-}
-
-void displayTransactionMenu()
-{
-    clearScreen();
-    displayBanner();
-    
-    printf("\n%s%s TRANSACTION MANAGEMENT %s\n", BG_CYAN, BLACK, RESET);
-    printf("%s 1. Deposit %s\n", YELLOW, RESET);
-    printf("%s 2. Withdraw %s\n", YELLOW, RESET);
-    printf("%s 3. Transfer %s\n", YELLOW, RESET);
-    printf("%s 4. View All Transactions %s\n", YELLOW, RESET);
-    printf("%s 5. View Account Transactions %s\n", YELLOW, RESET);
-    printf("%s 6. Undo Last Transaction %s\n", YELLOW, RESET);
-    printf("%s 7. Return to Main Menu %s\n", YELLOW, RESET);
-    printf("\n%sEnter your choice: %s", GREEN, RESET);
-}
-
-void displayServiceMenu()
-{
-    clearScreen();
-    displayBanner();
-    
-    printf("\n%s%s SERVICE REQUEST MANAGEMENT %s\n", BG_CYAN, BLACK, RESET);
-    printf("%s 1. Submit New Request %s\n", YELLOW, RESET);
-    printf("%s 2. View All Pending Requests %s\n", YELLOW, RESET);
-    printf("%s 3. Process Next Request %s\n", YELLOW, RESET);
-    printf("%s 4. Return to Main Menu %s\n", YELLOW, RESET);
-    printf("\n%sEnter your choice: %s", GREEN, RESET);
-}
-
-void displayBranchMenu()
-{
-    clearScreen();
-    displayBanner();
-    
-    printf("\n%s%s BRANCH MANAGEMENT %s\n", BG_CYAN, BLACK, RESET);
-    printf("%s 1. Add New Branch %s\n", YELLOW, RESET);
-    printf("%s 2. View All Branches %s\n", YELLOW, RESET);
-    printf("%s 3. Add Branch Connection %s\n", YELLOW, RESET);
-    printf("%s 4. View Branch Connections %s\n", YELLOW, RESET);
-    printf("%s 5. Find Shortest Path Between Branches %s\n", YELLOW, RESET);
-    printf("%s 6. Return to Main Menu %s\n", YELLOW, RESET);
-    printf("\n%sEnter your choice: %s", GREEN, RESET);
-}
-
-void displayUserManagementMenu()
-{
-    clearScreen();
-    displayBanner();
-    
-    printf("\n%s%s USER MANAGEMENT %s\n", BG_CYAN, BLACK, RESET);
-    printf("%s 1. Add New User %s\n", YELLOW, RESET);
-    printf("%s 2. View All Users %s\n", YELLOW, RESET);
-    printf("%s 3. Return to Main Menu %s\n", YELLOW, RESET);
-    printf("\n%sEnter your choice: %s", GREEN, RESET);
-}
-
-void displaySaveLoadMenu()
-{
-    clearScreen();
-    displayBanner();
-    
-    printf("\n%s%s DATA MANAGEMENT %s\n", BG_CYAN, BLACK, RESET);
-    printf("%s 1. Save All Data %s\n", YELLOW, RESET);
-    printf("%s 2. Load All Data %s\n", YELLOW, RESET);
-    printf("%s 3. Return to Main Menu %s\n", YELLOW, RESET);
-    printf("\n%sEnter your choice: %s", GREEN, RESET);
-}
-
-/***************************************************
- * SECTION 8: ACCOUNT MANAGEMENT FUNCTIONS
- ***************************************************/
-
-void viewAllAccounts()
-{
-    if (accountList == NULL)
-    {
-        printf("%sNo accounts to display.%s\n", YELLOW, RESET);
-        return;
-    }
-
-    printf("\n%s%s All Accounts %s\n", BG_GREEN, BLACK, RESET);
-    printf("%s%s%-5s %-15s %-10s %-20s %-15s %s\n", 
-           BG_CYAN, BLACK, "No", "Name", "Balance", "Address", "Phone", RESET);
-
-    struct AccountNode *temp = accountList;
-    while (temp != NULL)
-    {
-        printf("%-5d %-15s %s$%.2f%s %-20.20s %-15s\n",
-               temp->data.accountNo,
-               temp->data.name,
-               GREEN,
-               temp->data.balance,
-               RESET,
-               temp->data.address,
-               temp->data.phoneNumber);
-        temp = temp->next;
-    }
-}
-
-void searchAccount()
-{
-    int accountNo;
-    printf("\n%sEnter Account Number to search: %s", CYAN, RESET);
-    scanf("%d", &accountNo);
-    getchar(); // Clear input buffer
-    
-    struct Account *account = findAccount(accountNo);
-    if (account == NULL)
-    {
-        printf("%sAccount not found.%s\n", RED, RESET);
-        return;
-    }
-    
-    printf("\n%s%s Account Details %s\n", BG_GREEN, BLACK, RESET);
-    printf("%sAccount Number: %d%s\n", CYAN, account->accountNo, RESET);
-    printf("%sName: %s%s\n", CYAN, account->name, RESET);
-    printf("%sBalance: %s$%.2f%s\n", CYAN, GREEN, account->balance, RESET);
-    printf("%sAddress: %s%s\n", CYAN, account->address, RESET);
-    printf("%sPhone: %s%s\n", CYAN, account->phoneNumber, RESET);
-    printf("%sEmail: %s%s\n", CYAN, account->email, RESET);
-    printf("%sDate Created: %s%s\n", CYAN, account->dateCreated, RESET);
-}
-
-bool updateAccountDetails(int accountNo)
-{
-    struct Account *account = findAccount(accountNo);
-    if (account == NULL)
-    {
-        return false;
-    }
-    
-    printf("\n%s%s Update Account Details %s\n", BG_GREEN, BLACK, RESET);
-    printf("%sCurrent Name: %s - Enter new name (or press Enter to keep): %s", CYAN, account->name, RESET);
-    
-    char input[100];
-    fgets(input, sizeof(input), stdin);
-    input[strcspn(input, "\n")] = 0; // Remove newline
-    
-    if (strlen(input) > 0)
-    {
-        strcpy(account->name, input);
-    }
-    
-    printf("%sCurrent Address: %s - Enter new address (or press Enter to keep): %s", CYAN, account->address, RESET);
-    fgets(input, sizeof(input), stdin);
-    input[strcspn(input, "\n")] = 0;
-    
-    if (strlen(input) > 0)
-    {
-        strcpy(account->address, input);
-    }
-    
-    printf("%sCurrent Phone: %s - Enter new phone (or press Enter to keep): %s", CYAN, account->phoneNumber, RESET);
-    fgets(input, sizeof(input), stdin);
-    input[strcspn(input, "\n")] = 0;
-    
-    if (strlen(input) > 0)
-    {
-        strcpy(account->phoneNumber, input);
-    }
-    
-    printf("%sCurrent Email: %s - Enter new email (or press Enter to keep): %s", CYAN, account->email, RESET);
-    fgets(input, sizeof(input), stdin);
-    input[strcspn(input, "\n")] = 0;
-    
-    if (strlen(input) > 0)
-    {
-        strcpy(account->email, input);
-    }
-    
-    printf("%sAccount details updated successfully!%s\n", GREEN, RESET);
-    return true;
-}
-
-bool deleteAccount(int accountNo)
-{
-    if (accountList == NULL)
-    {
-        return false;
-    }
-    
-    // If first node is the one to delete
-    if (accountList->data.accountNo == accountNo)
-    {
-        struct AccountNode *temp = accountList;
-        accountList = accountList->next;
-        free(temp);
-        return true;
-    }
-    
-    // Search for the node to delete
-    struct AccountNode *current = accountList;
-    struct AccountNode *prev = NULL;
-    
-    while (current != NULL && current->data.accountNo != accountNo)
-    {
-        prev = current;
-        current = current->next;
-    }
-    
-    // If account not found
-    if (current == NULL)
-    {
-        return false;
-    }
-    
-    // Remove the node
-    prev->next = current->next;
-    free(current);
-    return true;
-}
-/***************************************************
- * SECTION 9: MAIN AND MENU HANDLING FUNCTIONS
- ***************************************************/
-
-// Handle account management menu
-void handleAccountMenu()
-{
-    int choice;
-    int accountNo;
-    char name[50], address[100], phone[15], email[50];
-    float initialBalance;
-    
-    do {
-        displayAccountMenu();
-        scanf("%d", &choice);
-        getchar(); // Clear input buffer
-        
-        switch (choice) {
-            case 1: // Create New Account
-                printf("\n%s%s Create New Account %s\n", BG_GREEN, BLACK, RESET);
-                
-                printf("%sEnter Account Number: %s", CYAN, RESET);
-                scanf("%d", &accountNo);
-                getchar(); // Clear input buffer
-                
-                printf("%sEnter Name: %s", CYAN, RESET);
-                fgets(name, sizeof(name), stdin);
-                name[strcspn(name, "\n")] = 0; // Remove newline
-                
-                printf("%sEnter Initial Balance: %s", CYAN, RESET);
-                scanf("%f", &initialBalance);
-                getchar(); // Clear input buffer
-                
-                printf("%sEnter Address: %s", CYAN, RESET);
-                fgets(address, sizeof(address), stdin);
-                address[strcspn(address, "\n")] = 0;
-                
-                printf("%sEnter Phone Number: %s", CYAN, RESET);
-                fgets(phone, sizeof(phone), stdin);
-                phone[strcspn(phone, "\n")] = 0;
-                
-                printf("%sEnter Email: %s", CYAN, RESET);
-                fgets(email, sizeof(email), stdin);
-                email[strcspn(email, "\n")] = 0;
-                
-                if (addAccount(accountNo, name, initialBalance, address, phone, email)) {
-                    printf("%sAccount created successfully!%s\n", GREEN, RESET);
-                } else {
-                    printf("%sAccount number already exists!%s\n", RED, RESET);
-                }
-                pauseExecution();
-                break;
-                
-            case 2: // View All Accounts
-                viewAllAccounts();
-                pauseExecution();
-                break;
-                
-            case 3: // Search Account by Number
-                searchAccount();
-                pauseExecution();
-                break;
-                
-            case 4: // Update Account Details
-                printf("\n%sEnter Account Number to update: %s", CYAN, RESET);
-                scanf("%d", &accountNo);
-                getchar(); // Clear input buffer
-                
-                if (!updateAccountDetails(accountNo)) {
-                    printf("%sAccount not found!%s\n", RED, RESET);
-                }
-                pauseExecution();
-                break;
-                
-            case 5: // Delete Account
-                printf("\n%sEnter Account Number to delete: %s", CYAN, RESET);
-                scanf("%d", &accountNo);
-                getchar(); // Clear input buffer
-                
-                if (deleteAccount(accountNo)) {
-                    printf("%sAccount deleted successfully!%s\n", GREEN, RESET);
-                } else {
-                    printf("%sAccount not found!%s\n", RED, RESET);
-                }
-                pauseExecution();
-                break;
-                
-            case 6: // Return to Main Menu
-                break;
-                
-            default:
-                printf("%sInvalid choice!%s\n", RED, RESET);
-                pauseExecution();
-        }
-    } while (choice != 6);
-}
-
-// Handle transaction menu
-void handleTransactionMenu()
-{
-    int choice;
-    int accountNo, toAccountNo;
-    float amount;
-    
-    do {
-        displayTransactionMenu();
-        scanf("%d", &choice);
-        getchar(); // Clear input buffer
-        
-        switch (choice) {
-            case 1: // Deposit
-                printf("\n%s%s Deposit %s\n", BG_GREEN, BLACK, RESET);
-                
-                printf("%sEnter Account Number: %s", CYAN, RESET);
-                scanf("%d", &accountNo);
-                getchar(); // Clear input buffer
-                
-                printf("%sEnter Amount to Deposit: %s", CYAN, RESET);
-                scanf("%f", &amount);
-                getchar(); // Clear input buffer
-                
-                if (deposit(accountNo, amount)) {
-                    printf("%sDeposit successful!%s\n", GREEN, RESET);
-                } else {
-                    printf("%sAccount not found!%s\n", RED, RESET);
-                }
-                pauseExecution();
-                break;
-                
-            case 2: // Withdraw
-                printf("\n%s%s Withdraw %s\n", BG_GREEN, BLACK, RESET);
-                
-                printf("%sEnter Account Number: %s", CYAN, RESET);
-                scanf("%d", &accountNo);
-                getchar(); // Clear input buffer
-                
-                printf("%sEnter Amount to Withdraw: %s", CYAN, RESET);
-                scanf("%f", &amount);
-                getchar(); // Clear input buffer
-                
-                if (withdraw(accountNo, amount)) {
-                    printf("%sWithdrawal successful!%s\n", GREEN, RESET);
-                } else {
-                    printf("%sAccount not found or insufficient balance!%s\n", RED, RESET);
-                }
-                pauseExecution();
-                break;
-                
-            case 3: // Transfer
-                printf("\n%s%s Transfer %s\n", BG_GREEN, BLACK, RESET);
-                
-                printf("%sEnter Source Account Number: %s", CYAN, RESET);
-                scanf("%d", &accountNo);
-                getchar(); // Clear input buffer
-                
-                printf("%sEnter Destination Account Number: %s", CYAN, RESET);
-                scanf("%d", &toAccountNo);
-                getchar(); // Clear input buffer
-                
-                printf("%sEnter Amount to Transfer: %s", CYAN, RESET);
-                scanf("%f", &amount);
-                getchar(); // Clear input buffer
-                
-                if (transfer(accountNo, toAccountNo, amount)) {
-                    printf("%sTransfer successful!%s\n", GREEN, RESET);
-                } else {
-                    printf("%sTransaction failed! Check account numbers and balance.%s\n", RED, RESET);
-                }
-                pauseExecution();
-                break;
-                
-            case 4: // View All Transactions
-                viewTransactions();
-                pauseExecution();
-                break;
-                
-            case 5: // View Account Transactions
-                printf("\n%sEnter Account Number: %s", CYAN, RESET);
-                scanf("%d", &accountNo);
-                getchar(); // Clear input buffer
-                
-                viewAccountTransactions(accountNo);
-                pauseExecution();
-                break;
-                
-            case 6: // Undo Last Transaction
-                if (undoLastTransaction()) {
-                    printf("%sTransaction undone successfully!%s\n", GREEN, RESET);
-                } else {
-                    printf("%sNo transactions to undo or invalid transaction!%s\n", RED, RESET);
-                }
-                pauseExecution();
-                break;
-                
-            case 7: // Return to Main Menu
-                break;
-                
-            default:
-                printf("%sInvalid choice!%s\n", RED, RESET);
-                pauseExecution();
-        }
-    } while (choice != 7);
-}
-
-// Handle service request menu
-void handleServiceMenu()
-{
-    int choice;
-    int accountNo, priority;
-    char requestType[50], description[200];
-    
-    do {
-        displayServiceMenu();
-        scanf("%d", &choice);
-        getchar(); // Clear input buffer
-        
-        switch (choice) {
-            case 1: // Submit New Request
-                printf("\n%s%s Submit Service Request %s\n", BG_GREEN, BLACK, RESET);
-                
-                printf("%sEnter Account Number: %s", CYAN, RESET);
-                scanf("%d", &accountNo);
-                getchar(); // Clear input buffer
-                
-                printf("%sEnter Request Type: %s", CYAN, RESET);
-                fgets(requestType, sizeof(requestType), stdin);
-                requestType[strcspn(requestType, "\n")] = 0; // Remove newline
-                
-                printf("%sEnter Description: %s", CYAN, RESET);
-                fgets(description, sizeof(description), stdin);
-                description[strcspn(description, "\n")] = 0;
-                
-                printf("%sEnter Priority (1-5, 5 being highest): %s", CYAN, RESET);
-                scanf("%d", &priority);
-                getchar(); // Clear input buffer
-                
-                if (priority < 1 || priority > 5) {
-                    printf("%sInvalid priority! Setting to default (3).%s\n", YELLOW, RESET);
-                    priority = 3;
-                }
-                
-                if (submitServiceRequest(accountNo, requestType, description, priority)) {
-                    printf("%sService request submitted successfully!%s\n", GREEN, RESET);
-                } else {
-                    printf("%sAccount not found!%s\n", RED, RESET);
-                }
-                pauseExecution();
-                break;
-                
-            case 2: // View All Pending Requests
-                viewPendingRequests();
-                pauseExecution();
-                break;
-                
-            case 3: // Process Next Request
-                processNextRequest();
-                pauseExecution();
-                break;
-                
-            case 4: // Return to Main Menu
-                break;
-                
-            default:
-                printf("%sInvalid choice!%s\n", RED, RESET);
-                pauseExecution();
-        }
-    } while (choice != 4);
-}
-
-// Handle branch management menu
-void handleBranchMenu()
-{
-    int choice;
-    int branchId, targetBranchId, employeeCount;
-    float distance;
-    char branchName[50], location[100], managerName[50], phoneNumber[15];
-    
-    do {
-        displayBranchMenu();
-        scanf("%d", &choice);
-        getchar(); // Clear input buffer
-        
-        switch (choice) {
-            case 1: // Add New Branch
-                printf("\n%s%s Add New Branch %s\n", BG_GREEN, BLACK, RESET);
-                
-                printf("%sEnter Branch ID: %s", CYAN, RESET);
-                scanf("%d", &branchId);
-                getchar(); // Clear input buffer
-                
-                printf("%sEnter Branch Name: %s", CYAN, RESET);
-                fgets(branchName, sizeof(branchName), stdin);
-                branchName[strcspn(branchName, "\n")] = 0; // Remove newline
-                
-                printf("%sEnter Location: %s", CYAN, RESET);
-                fgets(location, sizeof(location), stdin);
-                location[strcspn(location, "\n")] = 0;
-                
-                printf("%sEnter Manager Name: %s", CYAN, RESET);
-                fgets(managerName, sizeof(managerName), stdin);
-                managerName[strcspn(managerName, "\n")] = 0;
-                
-                printf("%sEnter Phone Number: %s", CYAN, RESET);
-                fgets(phoneNumber, sizeof(phoneNumber), stdin);
-                phoneNumber[strcspn(phoneNumber, "\n")] = 0;
-                
-                printf("%sEnter Employee Count: %s", CYAN, RESET);
-                scanf("%d", &employeeCount);
-                getchar(); // Clear input buffer
-                
-                addBranch(branchId, branchName, location, managerName, phoneNumber, employeeCount);
-                printf("%sBranch added successfully!%s\n", GREEN, RESET);
-                pauseExecution();
-                break;
-                
-            case 2: // View All Branches
-                viewAllBranches();
-                pauseExecution();
-                break;
-                
-            case 3: // Add Branch Connection
-                printf("\n%s%s Add Branch Connection %s\n", BG_GREEN, BLACK, RESET);
-                
-                printf("%sEnter Source Branch ID: %s", CYAN, RESET);
-                scanf("%d", &branchId);
-                getchar(); // Clear input buffer
-                
-                printf("%sEnter Target Branch ID: %s", CYAN, RESET);
-                scanf("%d", &targetBranchId);
-                getchar(); // Clear input buffer
-                
-                printf("%sEnter Distance (in km): %s", CYAN, RESET);
-                scanf("%f", &distance);
-                getchar(); // Clear input buffer
-                
-                addConnection(branchId, targetBranchId, distance);
-                printf("%sConnection added successfully!%s\n", GREEN, RESET);
-                pauseExecution();
-                break;
-                
-            case 4: // View Branch Connections
-                printf("\n%sEnter Branch ID: %s", CYAN, RESET);
-                scanf("%d", &branchId);
-                getchar(); // Clear input buffer
-                
-                viewBranchConnections(branchId);
-                pauseExecution();
-                break;
-                
-            case 5: // Find Shortest Path Between Branches
-                printf("\n%s%s Find Shortest Path %s\n", BG_GREEN, BLACK, RESET);
-                
-                printf("%sEnter Start Branch ID: %s", CYAN, RESET);
-                scanf("%d", &branchId);
-                getchar(); // Clear input buffer
-                
-                printf("%sEnter Destination Branch ID: %s", CYAN, RESET);
-                scanf("%d", &targetBranchId);
-                getchar(); // Clear input buffer
-                
-                findShortestPath(branchId, targetBranchId);
-                pauseExecution();
-                break;
-                
-            case 6: // Return to Main Menu
-                break;
-                
-            default:
-                printf("%sInvalid choice!%s\n", RED, RESET);
-                pauseExecution();
-        }
-    } while (choice != 6);
-}
-
-// Handle user management menu
-void handleUserManagementMenu()
-{
-    int choice;
-    char username[50], password[50];
-    int isAdmin;
-    
-    do {
-        displayUserManagementMenu();
-        scanf("%d", &choice);
-        getchar(); // Clear input buffer
-        
-        switch (choice) {
-            case 1: // Add New User
-                printf("\n%s%s Add New User %s\n", BG_GREEN, BLACK, RESET);
-                
-                printf("%sEnter Username: %s", CYAN, RESET);
-                fgets(username, sizeof(username), stdin);
-                username[strcspn(username, "\n")] = 0; // Remove newline
-                
-                printf("%sEnter Password: %s", CYAN, RESET);
-                fgets(password, sizeof(password), stdin);
-                password[strcspn(password, "\n")] = 0;
-                
-                printf("%sIs Admin (1 for Yes, 0 for No): %s", CYAN, RESET);
-                scanf("%d", &isAdmin);
-                getchar(); // Clear input buffer
-                
-                if (addUser(username, password, isAdmin == 1)) {
-                    printf("%sUser added successfully!%s\n", GREEN, RESET);
-                } else {
-                    printf("%sFailed to add user! Username might exist already.%s\n", RED, RESET);
-                }
-                pauseExecution();
-                break;
-                
-            case 2: // View All Users
-                printf("\n%s%s All Users %s\n", BG_GREEN, BLACK, RESET);
-                printf("%s%s%-20s %-15s %s\n", BG_CYAN, BLACK, "Username", "Role", RESET);
-                
-                for (int i = 0; i < userCount; i++) {
-                    printf("%-20s %-15s\n", 
-                          users[i].username, 
-                          users[i].isAdmin ? "Administrator" : "Regular User");
-                }
-                pauseExecution();
-                break;
-                
-            case 3: // Return to Main Menu
-                break;
-                
-            default:
-                printf("%sInvalid choice!%s\n", RED, RESET);
-                pauseExecution();
-        }
-    } while (choice != 3);
-}
-
-// Handle save/load menu
-void handleSaveLoadMenu()
-{
-    int choice;
-    
-    do {
-        displaySaveLoadMenu();
-        scanf("%d", &choice);
-        getchar(); // Clear input buffer
-        
-        switch (choice) {
-            case 1: // Save All Data
-                saveAllData();
-                pauseExecution();
-                break;
-                
-            case 2: // Load All Data
-                loadAllData();
-                printf("%sAll data loaded successfully!%s\n", GREEN, RESET);
-                pauseExecution();
-                break;
-                
-            case 3: // Return to Main Menu
-                break;
-                
-            default:
-                printf("%sInvalid choice!%s\n", RED, RESET);
-                pauseExecution();
-        }
-    } while (choice != 3);
-}
-
-// Handle user account operations (regular user)
-void handleUserAccountOperations()
-{
-    int choice;
-    int accountNo, toAccountNo;
-    float amount;
-    char requestType[50], description[200];
-    int priority;
-    
-    do {
-        displayUserMenu();
-        scanf("%d", &choice);
-        getchar(); // Clear input buffer
-        
-        switch (choice) {
-            case 1: // View Account Details
-                printf("\n%sEnter Your Account Number: %s", CYAN, RESET);
-                scanf("%d", &accountNo);
-                getchar(); // Clear input buffer
-                
-                searchAccount();
-                pauseExecution();
-                break;
-                
-            case 2: // Make a Transaction
-                printf("\n%s%s Transaction Options %s\n", BG_GREEN, BLACK, RESET);
-                printf("%s 1. Deposit %s\n", YELLOW, RESET);
-                printf("%s 2. Withdraw %s\n", YELLOW, RESET);
-                printf("%s 3. Transfer %s\n", YELLOW, RESET);
-                printf("\n%sEnter choice: %s", GREEN, RESET);
-                
-                int transChoice;
-                scanf("%d", &transChoice);
-                getchar(); // Clear input buffer
-                
-                switch (transChoice) {
-                    case 1: // Deposit
-                        printf("\n%sEnter Your Account Number: %s", CYAN, RESET);
-                        scanf("%d", &accountNo);
-                        getchar(); // Clear input buffer
-                        
-                        printf("%sEnter Amount to Deposit: %s", CYAN, RESET);
-                        scanf("%f", &amount);
-                        getchar(); // Clear input buffer
-                        
-                        if (deposit(accountNo, amount)) {
-                            printf("%sDeposit successful!%s\n", GREEN, RESET);
-                        } else {
-                            printf("%sAccount not found!%s\n", RED, RESET);
-                        }
-                        break;
-                        
-                    case 2: // Withdraw
-                        printf("\n%sEnter Your Account Number: %s", CYAN, RESET);
-                        scanf("%d", &accountNo);
-                        getchar(); // Clear input buffer
-                        
-                        printf("%sEnter Amount to Withdraw: %s", CYAN, RESET);
-                        scanf("%f", &amount);
-                        getchar(); // Clear input buffer
-                        
-                        if (withdraw(accountNo, amount)) {
-                            printf("%sWithdrawal successful!%s\n", GREEN, RESET);
-                        } else {
-                            printf("%sAccount not found or insufficient balance!%s\n", RED, RESET);
-                        }
-                        break;
-                        
-                    case 3: // Transfer
-                        printf("\n%sEnter Your Account Number: %s", CYAN, RESET);
-                        scanf("%d", &accountNo);
-                        getchar(); // Clear input buffer
-                        
-                        printf("%sEnter Destination Account Number: %s", CYAN, RESET);
-                        scanf("%d", &toAccountNo);
-                        getchar(); // Clear input buffer
-                        
-                        printf("%sEnter Amount to Transfer: %s", CYAN, RESET);
-                        scanf("%f", &amount);
-                        getchar(); // Clear input buffer
-                        
-                        if (transfer(accountNo, toAccountNo, amount)) {
-                            printf("%sTransfer successful!%s\n", GREEN, RESET);
-                        } else {
-                            printf("%sTransaction failed! Check account numbers and balance.%s\n", RED, RESET);
-                        }
-                        break;
-                        
-                    default:
-                        printf("%sInvalid choice!%s\n", RED, RESET);
-                }
-                pauseExecution();
-                break;
-                
-            case 3: // Submit Service Request
-                printf("\n%s%s Submit Service Request %s\n", BG_GREEN, BLACK, RESET);
-                
-                printf("%sEnter Your Account Number: %s", CYAN, RESET);
-                scanf("%d", &accountNo);
-                getchar(); // Clear input buffer
-                
-                printf("%sEnter Request Type: %s", CYAN, RESET);
-                fgets(requestType, sizeof(requestType), stdin);
-                requestType[strcspn(requestType, "\n")] = 0; // Remove newline
-                
-                printf("%sEnter Description: %s", CYAN, RESET);
-                fgets(description, sizeof(description), stdin);
-                description[strcspn(description, "\n")] = 0;
-                
-                printf("%sEnter Priority (1-5, 5 being highest): %s", CYAN, RESET);
-                scanf("%d", &priority);
-                getchar(); // Clear input buffer
-                
-                if (priority < 1 || priority > 5) {
-                    printf("%sInvalid priority! Setting to default (3).%s\n", YELLOW, RESET);
-                    priority = 3;
-                }
-                
-                if (submitServiceRequest(accountNo, requestType, description, priority)) {
-                    printf("%sService request submitted successfully!%s\n", GREEN, RESET);
-                } else {
-                    printf("%sAccount not found!%s\n", RED, RESET);
-                }
-                pauseExecution();
-                break;
-                
-            case 4: // View Branch Information
-                viewAllBranches();
-                
-                printf("\n%sDo you want to see branch connections? (1 for Yes, 0 for No): %s", CYAN, RESET);
-                int showConnections;
-                scanf("%d", &showConnections);
-                getchar(); // Clear input buffer
-                
-                if (showConnections) {
-                    printf("\n%sEnter Branch ID: %s", CYAN, RESET);
-                    scanf("%d", &accountNo); // Reusing accountNo variable for branch ID
-                    getchar(); // Clear input buffer
-                    
-                    viewBranchConnections(accountNo);
-                }
-                pauseExecution();
-                break;
-                
-            case 5: // Logout
-                printf("%sLogging out...%s\n", YELLOW, RESET);
-                // Clear current user info
-                strcpy(currentUser.username, "");
-                strcpy(currentUser.password, "");
-                currentUser.isAdmin = false;
-                break;
-                
-            case 6: // Exit
-                printf("%sThank you for using the Bank Management System!%s\n", GREEN, RESET);
-                saveAllData(); // Auto-save on exit
-                exit(0);
-                
-            default:
-                printf("%sInvalid choice!%s\n", RED, RESET);
-                pauseExecution();
-        }
-    } while (choice != 5 && choice != 6);
-}
-
-// Handle admin operations
-void handleAdminOperations()
-{
-    int choice;
-    
-    do {
-        displayAdminMenu();
-        scanf("%d", &choice);
-        getchar(); // Clear input buffer
-        
-        switch (choice) {
-            case 1: // Account Management
-                handleAccountMenu();
-                break;
-                
-            case 2: // Transaction Management
-                handleTransactionMenu();
-                break;
-                
-            case 3: // Service Request Management
-                handleServiceMenu();
-                break;
-                
-            case 4: // Branch Management
-                handleBranchMenu();
-                break;
-                
-            case 5: // User Management
-                handleUserManagementMenu();
-                break;
-                
-            case 6: // Save/Load Data
-                handleSaveLoadMenu();
-                break;
-                
-            case 7: // Logout
-                printf("%sLogging out...%s\n", YELLOW, RESET);
-                // Clear current user info
-                strcpy(currentUser.username, "");
-                strcpy(currentUser.password, "");
-                currentUser.isAdmin = false;
-                break;
-                
-            case 8: // Exit
-                printf("%sThank you for using the Bank Management System!%s\n", GREEN, RESET);
-                saveAllData(); // Auto-save on exit
-                exit(0);
-                
-            default:
-                printf("%sInvalid choice!%s\n", RED, RESET);
-                pauseExecution();
-        }
-    } while (choice != 7 && choice != 8);
-}
-
-// Main function
-int main()
-{
-    // Initialize the random number generator
-    srand(time(NULL));
-    
-    // Initialize users
-    initializeUsers();
-    
-    // Load saved data
-    loadAllData();
-    
-    // Main program loop
-    while (1) {
-        clearScreen();
-        displayBanner();
-        
-        // Login if not already logged in
-        if (strlen(currentUser.username) == 0) {
-            char username[50], password[50];
-            bool isAdmin;
-            
-            printf("\n%s%s LOGIN %s\n", BG_CYAN, BLACK, RESET);
-            printf("%sUsername: %s", CYAN, RESET);
-            fgets(username, sizeof(username), stdin);
-            username[strcspn(username, "\n")] = 0; // Remove newline
-            
-            printf("%sPassword: %s", CYAN, RESET);
-            fgets(password, sizeof(password), stdin);
-            password[strcspn(password, "\n")] = 0;
-            
-            if (login(username, password, &isAdmin)) {
-                printf("%sLogin successful!%s\n", GREEN, RESET);
-                pauseExecution();
-                
-                if (isAdmin) {
-                    handleAdminOperations();
-                } else {
-                    handleUserAccountOperations();
-                }
-            } else {
-                printf("%sInvalid username or password!%s\n", RED, RESET);
-                pauseExecution();
-            }
-        } else {
-            // User is already logged in, direct to appropriate menu
-            if (currentUser.isAdmin) {
-                handleAdminOperations();
-            } else {
-                handleUserAccountOperations();
-            }
-        }
-    }
-    
-    return 0;
+/***************************************************
+ * Enhanced Bank Management System
+ * Features:
+ * - User/Admin authentication
+ * - Customer management using linked list
+ * - Transaction handling using stack
+ * - Customer service requests using queue
+ * - Branch connectivity using graph with shortest path
+ * - Data persistence using file handling
+ * - Enhanced UI with colors and menu systems
+ ***************************************************/
+
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <stdbool.h>
+ #include <stdint.h>
+ #include <time.h>
+ #include <float.h>
+ #include <limits.h>
+ #include <stdatomic.h>
+ 
+ #ifdef _WIN32
+ #include <io.h>
+ #include <windows.h>
+ #else
+ #include <pthread.h>
+ #include <sched.h>
+ #include <fcntl.h>
+ #include <unistd.h>
+ #include <dirent.h>
+ #include <sys/mman.h>
+ #include <sys/stat.h>
+ #endif
+ 
+ #ifdef __linux__
+ #include <errno.h>
+ #include <signal.h>
+ #include <netdb.h>
+ #include <netinet/in.h>
+ #include <netinet/tcp.h>
+ #include <sys/epoll.h>
+ #include <sys/socket.h>
+ #include <sys/un.h>
+ #endif
+ 
+ // Constants for terminal colors
+ #define RESET "\033[0m"
+ #define BOLD "\033[1m"
+ #define BLACK "\033[30m"
+ #define RED "\033[31m"
+ #define GREEN "\033[32m"
+ #define YELLOW "\033[33m"
+ #define BLUE "\033[34m"
+ #define MAGENTA "\033[35m"
+ #define CYAN "\033[36m"
+ #define WHITE "\033[37m"
+ #define BG_BLACK "\033[40m"
+ #define BG_RED "\033[41m"
+ #define BG_GREEN "\033[42m"
+ #define BG_YELLOW "\033[43m"
+ #define BG_BLUE "\033[44m"
+ #define BG_MAGENTA "\033[45m"
+ #define BG_CYAN "\033[46m"
+ #define BG_WHITE "\033[47m"
+ 
+ // Data file identification
+ #define ACCOUNTS_FILE_MAGIC "NBACCTS"
+ #define TRANSACTIONS_FILE_MAGIC "NBTRANS"
+ #define ACCOUNTS_DELTA_FILE_NAME "accounts.dat.delta"
+ #define ACCOUNTS_DELTA_FILE_MAGIC "NBDELTA"
+ #define REQUESTS_FILE_MAGIC "NBREQST"
+ #define TRANSACTIONS_FILE_VERSION 5
+ #define ACCOUNTS_FILE_VERSION 3
+ #define REQUESTS_FILE_VERSION 3
+ #define HIERARCHY_FILE_NAME "hierarchy.dat"
+ #define HIERARCHY_FILE_MAGIC "NBROUTE"
+ #define HIERARCHY_FILE_VERSION 1
+ 
+ // Write-ahead log
+ #define WAL_FILE_NAME "journal.wal"
+ #define WAL_FILE_MAGIC "NBWALOG"
+ #define WAL_FILE_VERSION 2
+ 
+ // Records per read when streaming transactions.dat
+ #define TRANSACTION_LOAD_CHUNK 8192
+ 
+ // Size of a cache line, for keeping locks that different threads take apart
+ #define CACHE_LINE_SIZE 64
+ 
+ // Operations each thread's journal ring holds before its writer has to wait
+ #define JOURNAL_RING_ENTRIES 4096
+ 
+ // Operations per batch when posting a file
+ #define POSTING_BATCH_SIZE 65536
+ 
+ // Server: largest request body accepted, events handled per wakeup, and the
+ // unsent reply bytes at which a connection stops being read
+ #define SERVER_MAX_FRAME 65536
+ #define SERVER_EVENT_BATCH 256
+ #define SERVER_OUTPUT_LIMIT (1 << 20)
+ 
+ // Transaction IDs a writer takes from the shared sequence at a time
+ #define TRANSACTION_ID_BLOCK 64
+ 
+ // Entries per page of the transaction ID index
+ #define TRANSACTION_ID_PAGE_ENTRIES 4096
+ 
+ // Account locks: accounts hash onto 1 << ACCOUNT_LOCK_STRIPE_BITS stripes
+ #define ACCOUNT_LOCK_STRIPE_BITS 10
+ #define ACCOUNT_LOCK_STRIPES (1 << ACCOUNT_LOCK_STRIPE_BITS)
+ 
+ // Entries per TransactionHistory chunk; makes a chunk two cache lines
+ #define HISTORY_CHUNK_ENTRIES 12
+ 
+ // Entries per segment of the transaction timeline
+ #define TIMELINE_SEGMENT_ENTRIES 1024
+ 
+ // Buffer size for formatMoney
+ #define MONEY_TEXT_SIZE 32
+ 
+ // Largest amount one operation may move, in cents ($1 trillion)
+ #define MONEY_MAX_AMOUNT 100000000000000LL
+ 
+ // Buffer size for the date and time text of formatTimestamp
+ #define TIMESTAMP_TEXT_SIZE 20
+ 
+ #define MICROS_PER_SECOND 1000000LL
+ 
+ // A waiting service request gains one priority level per this much time
+ #define REQUEST_AGING_MICROS (3600 * MICROS_PER_SECOND)
+ 
+ // Request pool: most workers, and requests handed out per worker ahead of
+ // the ones being processed (more keeps workers busy, fewer keeps the
+ // service order closer to priority order)
+ #define REQUEST_POOL_MAX_WORKERS 64
+ #define REQUEST_POOL_WINDOW 16
+ 
+ // Route matrix: networks with up to this many branches keep every pair's
+ // distance and first hop (8 bytes a pair), and most threads building it
+ #define ROUTE_MATRIX_MAX_BRANCHES 2048
+ #define ROUTE_MATRIX_MAX_WORKERS 64
+ 
+ // Route hierarchy: branches a witness search settles before giving up and
+ // adding the shortcut anyway (more finds more witnesses, and builds slower),
+ // and a smaller limit for only estimating what contracting a branch costs
+ #define HIERARCHY_WITNESS_LIMIT 200
+ #define HIERARCHY_ESTIMATE_LIMIT 40
+ 
+ // Route batches: most threads answering one, and the most queries from a
+ // start branch answered one at a time through the route hierarchy rather
+ // than by a single search from the start
+ #define ROUTE_BATCH_MAX_WORKERS 64
+ #define ROUTE_BATCH_HIERARCHY_LIMIT 128
+ 
+ /***************************************************
+  * SECTION 1: STRUCTURES DEFINITION
+  ***************************************************/
+ 
+ // Monetary amounts are whole cents so balances and sums stay exact
+ typedef long long Money;
+ 
+ // Points in time are microseconds since the epoch; they are only turned
+ // into local dates and times for display
+ typedef long long Timestamp;
+ 
+ #ifdef _WIN32
+ typedef SRWLOCK Mutex;
+ typedef HANDLE Thread;
+ #else
+ typedef pthread_mutex_t Mutex;
+ typedef pthread_t Thread;
+ #endif
+ 
+ // User authentication structure
+ struct User
+ {
+     char username[50];
+     char password[50];
+     bool isAdmin;
+ };
+ 
+ // Account record of version 1 accounts.dat files; only read when upgrading
+ // them, the live store is AccountTable
+ struct Account
+ {
+     int accountNo;
+     char name[50];
+     Money balance;
+     char address[100];
+     char phoneNumber[15];
+     char email[50];
+     char dateCreated[20];
+     struct TransactionHistory *history;
+ };
+ 
+ // Transaction structure
+ struct Transaction
+ {
+     long long transactionId; // From the transaction ID sequence; never reused
+     int accountNo;
+     char type[20]; // "deposit", "withdraw", "transfer"
+     Money amount;
+     Timestamp timestamp;
+ };
+ 
+ // Transaction categories used by the reconciliation sums
+ enum TransactionKind
+ {
+     TRANSACTION_DEPOSIT,
+     TRANSACTION_WITHDRAW,
+     TRANSACTION_TRANSFER_OUT,
+     TRANSACTION_TRANSFER_IN,
+     TRANSACTION_KIND_COUNT
+ };
+ 
+ // Transaction history node for stack
+ struct TransactionNode
+ {
+     struct Transaction data;
+     struct TransactionNode *next;
+ };
+ 
+ // One account's transactions as a chain of chunks, newest chunk first.
+ // Entries point at nodes on the transaction stack, oldest first in a chunk.
+ // The time bounds let a date range skip chunks and stop at the first chunk
+ // whose history is all older than the range.
+ struct TransactionHistory
+ {
+     struct TransactionHistory *older;
+     int count;
+     Timestamp earliest; // Oldest entry in this chunk
+     Timestamp latest;   // Newest entry in this chunk or any older one
+     struct TransactionNode *entries[HISTORY_CHUNK_ENTRIES];
+ };
+ 
+ // Customer service request structure
+ struct ServiceRequest
+ {
+     int requestId;
+     int accountNo;
+     char requestType[50];
+     char description[200];
+     bool isProcessed;
+     int priority; // 1-5, 5 being highest
+     Timestamp submittedAt;
+ };
+ 
+ // Service request node for queue. The texts share one allocation of
+ // their actual length rather than the ServiceRequest's fixed arrays.
+ struct RequestNode
+ {
+     long long rank; // Higher is served first; see requestRank
+     Timestamp submittedAt;
+     int requestId;
+     int accountNo;
+     int priority;
+     char *text; // Request type, then description, each NUL-terminated
+ };
+ 
+ // Fixed part of a service request record in requests.dat and the journal.
+ // The request type and description follow, without terminators.
+ struct RequestRecordHeader
+ {
+     Timestamp submittedAt;
+     int requestId;
+     int accountNo;
+     unsigned char priority;
+     unsigned char typeLength;
+     unsigned char descriptionLength;
+     unsigned char reserved;
+ };
+ 
+ // Header of version 3 requests.dat, whose records vary in length
+ struct RequestsFileHeader
+ {
+     char magic[8];
+     int version;
+     int recordSize;            // Size of a RequestRecordHeader
+     unsigned long long walLsn; // Last journal record reflected in the file
+     long long recordCount;
+     int lastRequestId;         // Highest ID handed out, queued or not
+     int reserved;
+ };
+ 
+ // Bank branch structure
+ struct Branch
+ {
+     int branchId;
+     char branchName[50];
+     char location[100];
+     char managerName[50];
+     char phoneNumber[15];
+     int employeeCount;
+ };
+ 
+ // Graph node for branch connectivity
+ struct BranchNode
+ {
+     struct Branch data;
+     struct EdgeList *connections;
+ };
+ 
+ // Edge list for graph connections
+ struct EdgeList
+ {
+     int branchId;
+     float distance;
+     struct EdgeList *next;
+ };
+ 
+ // A branch waiting in the Dijkstra frontier. Entries aren't updated when a
+ // shorter distance turns up; a new one is pushed and the old one skipped.
+ struct RouteHeapEntry
+ {
+     float distance;
+     int branch;
+ };
+ 
+ // The branch graph compiled for route searches, in compressed sparse row
+ // form: the edges leaving branch i are targets[offsets[i]] up to
+ // targets[offsets[i + 1]], each a branch index rather than an ID. Any
+ // change to the branches or connections marks it stale, and the next
+ // search rebuilds it.
+ struct BranchRoutes
+ {
+     int *offsets;     // branchCount + 1 entries
+     int *targets;
+     float *distances;
+     int branchCount;
+     int edgeCount;
+     bool stale;
+ };
+ 
+ // What a route search knows about one branch, together so relaxing an
+ // edge touches one cache line. distance and previous only hold this
+ // search's values if reached matches its number, so a search doesn't
+ // clear them first.
+ struct RouteLabel
+ {
+     float distance;
+     int previous;
+     unsigned int reached;
+     unsigned int settled;
+ };
+ 
+ // A link in the route hierarchy, to node in a branch's upward list and
+ // from it in the downward list. A shortcut stands in for the links to and
+ // from middle; real connections have middle -1.
+ struct HierarchyArc
+ {
+     int node;
+     float distance;
+     int middle;
+ };
+ 
+ struct HierarchyArcList
+ {
+     struct HierarchyArc *arcs;
+     int count;
+     int capacity;
+ };
+ 
+ // Contraction hierarchy over the branch graph, for networks too large for
+ // the route matrix. Branches are ranked, and each keeps only its links to
+ // higher-ranked ones, with shortcuts added so that every shortest route
+ // climbs the ranks and then descends. A query searches upwards from both
+ // ends, so it only visits a few hundred branches of any network.
+ struct RouteHierarchy
+ {
+     int *rank;
+     int *upOffsets;                // Links leaving each branch for higher ones
+     struct HierarchyArc *upArcs;
+     int *downOffsets;              // Links reaching each branch from higher ones
+     struct HierarchyArc *downArcs;
+     int branchCount;
+     int upCount;
+     int downCount;
+     bool ready;                    // Built for the network as it is now
+ };
+ 
+ // Working state while the hierarchy is built: the links between branches
+ // not yet contracted, and a witness search's scratch
+ struct HierarchyBuilder
+ {
+     struct HierarchyArcList *out;
+     struct HierarchyArcList *in;
+     bool *contracted;
+     int *contractedNeighbours;
+     int *level;  // One more than the highest contracted branch below it
+     float *distance;
+     unsigned int *reached;
+     unsigned int *wanted; // The current search's targets
+     unsigned int search;
+     struct RouteHeapEntry *heap;
+     int heapCapacity;
+     bool failed; // Ran out of memory
+ };
+ 
+ // What a hierarchy query knows about one branch from one end
+ struct HierarchyLabel
+ {
+     float distance;
+     int parent; // Branch it was reached from
+     int arc;    // Link it was reached by, in the parent's or its own list
+     unsigned int reached;
+     unsigned int settled;
+ };
+ 
+ // Scratch space for hierarchy queries, kept between them like RouteSearch.
+ // Side 0 searches up from the start, side 1 up from the end.
+ struct HierarchySearch
+ {
+     struct HierarchyLabel *labels[2];
+     struct RouteHeapEntry *heap[2];
+     int heapCapacity[2];
+     int *path;
+     int *climb; // Branches the start's side passed through, meeting point first
+     int branchCapacity;
+     unsigned int search;
+ };
+ 
+ // Header of hierarchy.dat. The ranks, upward offsets and links and downward
+ // offsets and links follow. signature identifies the network it was built
+ // for; a file that doesn't match the loaded network is ignored.
+ struct HierarchyFileHeader
+ {
+     char magic[8];
+     int version;
+     int branchCount;
+     int upCount;
+     int downCount;
+     unsigned long long signature;
+ };
+ 
+ // Scratch space for route searches, grown to the branch and edge counts
+ // and kept from one search to the next
+ struct RouteSearch
+ {
+     struct RouteLabel *labels;
+     int *path;                   // Branch indices, start first
+     int *order;                  // Branches in the order they were settled
+     unsigned int *wanted;        // Search number of the search that must settle a branch
+     struct RouteHeapEntry *heap; // Dijkstra frontier, one slot per edge
+     int branchCapacity;
+     int heapCapacity;
+     unsigned int search;         // Number of the current search
+ };
+ 
+ // Account flags
+ #define ACCOUNT_ACTIVE 0x01
+ #define ACCOUNT_DIRTY 0x02 // Changed since the last checkpoint; never written out
+ 
+ // Cold account fields, kept out of the way of balance sweeps
+ struct AccountProfile
+ {
+     char name[50];
+     char address[100];
+     char phoneNumber[15];
+     char email[50];
+     Timestamp createdAt;
+ };
+ 
+ // Account store. Hot fields live in parallel arrays indexed by row; profile
+ // strings live in a separate slab and each row points at its profile by index.
+ struct AccountTable
+ {
+     int count;
+     int capacity;
+     int *accountNo;
+     Money *balance;
+     unsigned char *flags;
+     struct TransactionHistory **history;
+     int *profileIndex;
+     int *fileSlot; // Record slot in accounts.dat, -1 until checkpointed
+ 
+     // Profile slab; slots released by deleteAccount are reused first
+     struct AccountProfile *profiles;
+     int profileCount;
+     int profileCapacity;
+     int *freeProfiles;
+     int freeProfileCount;
+ };
+ 
+ // Header of version 1 transactions.dat and accounts.dat; later headers
+ // start with the same fields
+ struct DataFileHeader
+ {
+     char magic[8];
+     int version;
+     int recordSize;
+ };
+ 
+ // Header of version 2 and 3 accounts.dat; starts with the same fields as
+ // DataFileHeader so older files can be told apart
+ struct AccountsFileHeader
+ {
+     char magic[8];
+     int version;
+     int recordSize;
+     long long recordCount;
+     unsigned long long checksum; // Sum of hashAccountRecord over all records
+     unsigned long long walLsn;   // Last journal record reflected in the file
+     unsigned long long reserved[3];
+ };
+ 
+ // Header of version 2 and later transactions.dat. Version 2 files hold the
+ // newest record first; later files hold the oldest first and only their
+ // first recordCount records count, so a save can append safely.
+ struct TransactionsFileHeader
+ {
+     char magic[8];
+     int version;
+     int recordSize;
+     unsigned long long walLsn;   // Last journal record reflected in the file
+     long long recordCount;       // Version 3 and later
+     long long nextTransactionId; // Version 4 and later: first ID not yet handed out
+     unsigned long long reserved[1];
+ };
+ 
+ // Fixed-stride accounts.dat record: hot fields followed by the profile as it
+ // is held in memory. A slot whose flags lack ACCOUNT_ACTIVE is the tombstone
+ // of a deleted account and can be reused.
+ struct AccountRecord
+ {
+     int accountNo;
+     int flags;
+     Money balance;
+     struct AccountProfile profile;
+ };
+ 
+ // What accounts.dat holds, so a checkpoint can rewrite only the records that
+ // changed since the last one
+ struct AccountsFileState
+ {
+     bool valid;                   // false until the file is loaded or fully written
+     int slotCount;                // Records in the file, tombstones included
+     int slotCapacity;
+     unsigned long long *slotHash; // hashAccountRecord of the record in each slot
+     unsigned long long checksum;
+     int *freeSlots;               // Tombstones that new accounts can take over
+     int freeSlotCount;
+     int freeSlotCapacity;
+     int *releasedSlots;           // Slots of accounts deleted since the last checkpoint
+     int releasedSlotCount;
+     int releasedSlotCapacity;
+     int *dirtyAccounts;           // Numbers of the accounts marked ACCOUNT_DIRTY
+     int dirtyCount;
+     int dirtyCapacity;
+ };
+ 
+ // Header of accounts.dat.delta, the records a checkpoint is about to copy
+ // into accounts.dat. The file is only complete once this header is written.
+ struct AccountsDeltaHeader
+ {
+     char magic[8];
+     int version;
+     int recordSize;
+     long long entryCount;
+     unsigned long long entriesChecksum;
+     long long slotCount;          // accounts.dat header values after the copy
+     unsigned long long checksum;
+     unsigned long long walLsn;
+ };
+ 
+ struct AccountDeltaEntry
+ {
+     long long slot;
+     struct AccountRecord record;
+ };
+ 
+ // Record layouts from before amounts were stored in cents; only read when
+ // migrating old data files
+ struct LegacyAccount
+ {
+     int accountNo;
+     char name[50];
+     float balance;
+     char address[100];
+     char phoneNumber[15];
+     char email[50];
+     char dateCreated[20];
+     void *history;
+ };
+ 
+ // Transaction record of version 4 transactions.dat, from before times were
+ // stored as timestamps
+ struct TransactionRecordV4
+ {
+     long long transactionId;
+     int accountNo;
+     char type[20];
+     Money amount;
+     char date[20];
+     char time[10];
+ };
+ 
+ // Transaction record of version 1 to 3 transactions.dat, from before IDs
+ // were 64-bit
+ struct TransactionRecordV3
+ {
+     int transactionId;
+     int accountNo;
+     char type[20];
+     Money amount;
+     char date[20];
+     char time[10];
+ };
+ 
+ // Account record of version 2 accounts.dat and of journal records written
+ // before account creation dates were stored as timestamps
+ struct AccountProfileV2
+ {
+     char name[50];
+     char address[100];
+     char phoneNumber[15];
+     char email[50];
+     char dateCreated[20];
+ };
+ 
+ struct AccountRecordV2
+ {
+     int accountNo;
+     int flags;
+     Money balance;
+     struct AccountProfileV2 profile;
+ };
+ 
+ // Service request record of headerless requests.dat files
+ struct ServiceRequestV1
+ {
+     int requestId;
+     int accountNo;
+     char requestType[50];
+     char description[200];
+     bool isProcessed;
+     char dateSubmitted[20];
+     int priority;
+ };
+ 
+ struct LegacyTransaction
+ {
+     int transactionId;
+     int accountNo;
+     char type[20];
+     float amount;
+     char date[20];
+     char time[10];
+ };
+ 
+ // Write-ahead log record types
+ enum WalRecordType
+ {
+     WAL_DEPOSIT = 1,
+     WAL_WITHDRAW,
+     WAL_TRANSFER,
+     WAL_UNDO,
+     WAL_ACCOUNT_OPEN,   // Payload is an AccountRecord
+     WAL_ACCOUNT_CLOSE,  // Payload is the account number
+     WAL_ACCOUNT_UPDATE, // Payload is an AccountRecord
+     WAL_REQUEST_ENQUEUE,  // Payload is a service request record
+     WAL_REQUEST_DEQUEUE,  // Payload is the request ID; served or cancelled
+     WAL_REQUEST_PRIORITY  // Payload is a WalRequestPriorityPayload
+ };
+ 
+ // Every journal record starts with this header; payloadSize bytes follow
+ struct WalRecordHeader
+ {
+     unsigned int checksum; // FNV-1a of the rest of the header and the payload
+     unsigned short type;
+     unsigned short payloadSize;
+     unsigned long long lsn;
+ };
+ 
+ // Payload of deposit, withdraw and transfer records
+ struct WalMoneyPayload
+ {
+     int accountNo;
+     int toAccountNo;           // Transfers only
+     long long transactionId;
+     long long toTransactionId; // Transfers only: id of the receiving side
+     Money amount;
+     Timestamp timestamp;
+ };
+ 
+ // Money payload of version 1 journals from before transaction IDs were
+ // 64-bit. Version 1 timestamps are in seconds.
+ struct WalMoneyPayloadV1
+ {
+     int accountNo;
+     int toAccountNo;
+     int transactionId;
+     int toTransactionId;
+     Money amount;
+     long long timestamp;
+ };
+ 
+ struct WalUndoPayload
+ {
+     int popped; // History entries the undo removed
+ };
+ 
+ struct WalRequestPriorityPayload
+ {
+     int requestId;
+     int priority;
+ };
+ 
+ // Journal state. Records are buffered and written out together by a group
+ // commit, so one fsync covers many operations.
+ struct WriteAheadLog
+ {
+     FILE *file;                // NULL while closed; appends are then dropped
+     unsigned long long lastLsn;
+     unsigned char *buffer;     // Records waiting for the next commit
+     size_t bufferUsed;
+     size_t bufferCapacity;
+     int pendingRecords;
+     double oldestPending;      // When the first pending record was appended
+     int groupRecords;          // Commit once this many records are pending
+     double groupWindow;        // or the oldest has waited this many seconds
+     unsigned long long accountsLsn;     // walLsn of the loaded accounts.dat
+     unsigned long long transactionsLsn; // walLsn of the loaded transactions.dat
+     unsigned long long requestsLsn;     // walLsn of the loaded requests.dat
+     long long records;
+     long long commits;
+ };
+ 
+ // Block of nodes carved up by a NodePool; the nodes follow the header
+ struct NodeSlab
+ {
+     struct NodeSlab *next;
+ };
+ 
+ // Fixed-size node allocator: nodes come from large slabs, freed nodes go on
+ // a free list, and a reset hands every node back at once
+ struct NodePool
+ {
+     const char *name;
+     size_t nodeSize;
+     int nodesPerSlab;
+     struct NodeSlab *slabs;       // Every slab owned by the pool
+     struct NodeSlab *currentSlab; // Slab the bump pointer is carving
+     char *bumpNext;
+     int bumpLeft;
+     void *freeList;
+     int slabCount;
+     int liveCount;
+     int freeListCount;
+     int highWater;
+ };
+ 
+ // Slot of an open-addressing ID index (value == -1 marks an empty slot)
+ struct IdIndexSlot
+ {
+     int id;
+     int value;
+ };
+ 
+ // Hash index from an ID to a non-negative int, such as an account number
+ // to its accountTable row (linear probing)
+ struct IdIndex
+ {
+     struct IdIndexSlot *slots;
+     int capacity; // Always a power of two
+     int count;
+ };
+ 
+ // Pending service requests: a binary heap of nodes, highest rank at the
+ // top, and each request's heap position by ID for cancel and reprioritize
+ struct RequestQueue
+ {
+     struct RequestNode **heap;
+     int count;
+     int capacity;
+     struct IdIndex positions;
+ };
+ 
+ // Range of transaction IDs a writer has taken from the shared sequence and
+ // not used yet
+ struct TransactionIdBlock
+ {
+     long long next;
+     long long end;
+ };
+ 
+ // Transaction ID to history node, as pages of TRANSACTION_ID_PAGE_ENTRIES
+ // slots. IDs are handed out densely, so a lookup is two array reads.
+ struct TransactionIdIndex
+ {
+     struct TransactionNode ***pages; // NULL for pages with no IDs yet
+     long long pageCount;
+ };
+ 
+ // Time bounds of a timeline segment
+ struct TimelineBounds
+ {
+     Timestamp earliest;
+     Timestamp latest;
+ };
+ 
+ // Every transaction in the order it was recorded, in segments of
+ // TIMELINE_SEGMENT_ENTRIES. The bounds are a sparse index kept apart from the
+ // entries; while times never go backwards they are sorted, so the segments
+ // of a date range are found by binary search.
+ struct TransactionTimeline
+ {
+     struct TransactionNode ***segments;
+     struct TimelineBounds *bounds;
+     int segmentCount;
+     int segmentCapacity;
+     int lastCount; // Entries in the last segment
+     bool ordered;  // No transaction is older than one recorded before it
+ };
+ 
+ // One lock stripe, alone on its cache line so stripes taken by different
+ // threads don't share one
+ struct AccountStripe
+ {
+     _Alignas(CACHE_LINE_SIZE) Mutex lock;
+     unsigned long long sequence; // Operations queued on the stripe so far
+ };
+ 
+ // A deposit, withdrawal or transfer waiting in a journal ring. Its place in
+ // each stripe's sequence lets the drainer put operations on one account
+ // into the journal in the order they were applied.
+ struct JournalEntry
+ {
+     int type;
+     int stripeCount;
+     int stripes[2];
+     unsigned long long sequences[2];
+     struct WalMoneyPayload payload;
+ };
+ 
+ // Single-producer queue owned by one thread at a time. Only the owner moves
+ // tail and only the drainer moves head, each on its own cache line.
+ struct JournalRing
+ {
+     _Alignas(CACHE_LINE_SIZE) atomic_ullong tail;
+     _Alignas(CACHE_LINE_SIZE) atomic_ullong head;
+     atomic_bool inUse;
+     struct JournalRing *next; // Rings are never freed, only handed on
+     struct JournalEntry entries[JOURNAL_RING_ENTRIES];
+ };
+ 
+ // What a thread started by startThread runs
+ struct ThreadStart
+ {
+     void *(*run)(void *);
+     void *arg;
+ };
+ 
+ // Every branch's distance and first hop to every other branch, entry
+ // [from * branchCount + to], so a route is a lookup and a walk along the
+ // hops. Filled by Dijkstra from every branch, spread over threads, and
+ // then kept current as connections are added. Only kept for networks of
+ // up to ROUTE_MATRIX_MAX_BRANCHES.
+ struct RouteMatrix
+ {
+     float *distance;       // FLT_MAX where to can't be reached
+     int *nextHop;          // -1 where to can't be reached
+     int *path;
+     int branchCount;
+     bool stale;
+     bool enabled;
+     atomic_int nextSource; // Next row for a building thread to fill
+ };
+ 
+ struct RouteMatrixWorker
+ {
+     Thread thread;
+     struct ThreadStart start;
+     struct RouteSearch search;
+     bool failed;
+ };
+ 
+ // One route of a batch. planRoutes fills in the distance, FLT_MAX if the
+ // end can't be reached or an index is -1, and the branch indices along the
+ // way, start first.
+ struct RouteQuery
+ {
+     int startIndex;
+     int endIndex;
+     float distance;
+     const int *path;
+     int pathLength;
+ };
+ 
+ // A batch of routes being planned. The queries are grouped by start branch,
+ // and each group is answered by one thread.
+ struct RouteBatch
+ {
+     struct RouteQuery *queries;
+     int count;
+     int *order;       // Query numbers, grouped by start branch
+     int *ends;        // End branch of each query in order
+     int *groups;      // Where each group begins in order, and where the last ends
+     int *groupWorker; // Worker that answered each group
+     size_t *pathStart; // Where each query's path begins in its worker's paths
+     int groupCount;
+     bool useMatrix;
+     bool useHierarchy;
+     atomic_int nextGroup; // Next group for a thread to answer
+     int *paths;        // Every query's path, once the batch is planned
+ };
+ 
+ struct RouteBatchWorker
+ {
+     Thread thread;
+     struct ThreadStart start;
+     struct RouteBatch *batch;
+     struct RouteSearch search;
+     struct HierarchySearch hierarchy;
+     int *paths; // Paths of the queries this thread answered
+     size_t pathsUsed, pathsCapacity;
+     int number;
+     bool failed;
+ };
+ 
+ // One deposit, withdrawal or transfer of a batch posting
+ struct BatchOperation
+ {
+     int type; // WAL_DEPOSIT, WAL_WITHDRAW or WAL_TRANSFER
+     int accountNo;
+     int toAccountNo; // Transfers only
+     Money amount;
+ };
+ 
+ // What happened to each operation of a batch
+ enum BatchStatus
+ {
+     BATCH_POSTED,
+     BATCH_NO_ACCOUNT,
+     BATCH_INSUFFICIENT_FUNDS,
+     BATCH_BAD_AMOUNT,
+     BATCH_BAD_LINE // Posting files only: the line didn't parse
+ };
+ 
+ // An account a batch operation names, sorted so each is looked up once
+ struct BatchAccountRef
+ {
+     int accountNo;
+     int operation;
+     bool receiving; // The receiving side of a transfer
+ };
+ 
+ // Server requests. Frames are a 4-byte length and a body; request bodies
+ // are the opcode, a 4-byte tag echoed in the reply, and the fields below.
+ // Reply bodies are the opcode, the tag, a ServerStatus byte and, on
+ // SERVER_OK, the results. Integers are big-endian and amounts are cents;
+ // text is a length byte and the characters.
+ enum ServerOp
+ {
+     SERVER_LOGIN = 1,       // username, password -> isAdmin byte
+     SERVER_DEPOSIT,         // account, amount -> balance
+     SERVER_WITHDRAW,        // account, amount -> balance
+     SERVER_TRANSFER,        // from, to, amount -> from balance, to balance
+     SERVER_LOOKUP,          // account -> balance, name
+     SERVER_SERVICE_REQUEST, // account, priority byte, type, description -> request ID
+     SERVER_SHORTEST_PATH,   // from branch, to branch -> distance (float bits), count, branch IDs
+     SERVER_ROUTE_BATCH      // count, (from branch, to branch) each -> for each a ServerStatus byte and, if
+                             // SERVER_OK, what SERVER_SHORTEST_PATH returns
+ };
+ 
+ enum ServerStatus
+ {
+     SERVER_OK,
+     SERVER_NOT_LOGGED_IN,
+     SERVER_BAD_LOGIN,
+     SERVER_NO_ACCOUNT,
+     SERVER_INSUFFICIENT_FUNDS,
+     SERVER_BAD_AMOUNT,
+     SERVER_NO_BRANCH,
+     SERVER_NO_PATH,
+     SERVER_BAD_REQUEST
+ };
+ 
+ // One client of the server, with the bytes read but not yet handled and the
+ // replies not yet sent
+ struct ServerConnection
+ {
+     int fd;
+     bool loggedIn;
+     bool isAdmin;
+     bool closing; // Close once the replies are out
+     bool listed; // Already on this round's list of connections to finish
+     unsigned int interest; // Events epoll watches for
+     unsigned char *in;
+     size_t inUsed, inCapacity;
+     unsigned char *out;
+     size_t outUsed, outSent, outCapacity;
+     struct ServerConnection *nextListed;
+ };
+ 
+ // Reads the fields of a frame body. Reading past the end clears ok and
+ // yields zeros, so a handler checks ok once after taking all its fields.
+ struct FrameReader
+ {
+     const unsigned char *p;
+     size_t left;
+     bool ok;
+ };
+ 
+ // A reply being built at the end of a connection's output
+ struct FrameWriter
+ {
+     struct ServerConnection *connection;
+     size_t start;
+     bool ok;
+ };
+ 
+ // One connection of the load generator, keeping up to depth requests in
+ // flight. Replies come back in order, so sentAt is indexed by tag.
+ struct LoadConnection
+ {
+     int fd;
+     long long sent, received;
+     double *sentAt; // depth entries
+     unsigned char in[65536];
+     size_t inUsed;
+     unsigned char out[65536];
+     size_t outUsed, outSent;
+ };
+ 
+ // A service request handed to the worker pool
+ struct RequestTask
+ {
+     struct ServiceRequest request;
+     double dispatchedAt;
+     struct RequestTask *next;
+ };
+ 
+ // The pool's requests for one account, processed one at a time in the order
+ // they were handed out. A strand with requests waiting is on exactly one
+ // worker's deque.
+ struct RequestStrand
+ {
+     int accountNo;
+     bool scheduled;
+     struct RequestTask *head;
+     struct RequestTask *tail;
+ };
+ 
+ // Called by a pool worker for each request it processes
+ typedef void (*RequestHandler)(const struct ServiceRequest *request, int worker, void *context);
+ 
+ // A worker of the request pool. Its deque holds strand numbers; the worker
+ // takes from the front and thieves take from the back.
+ struct RequestWorker
+ {
+     _Alignas(CACHE_LINE_SIZE) Mutex lock;
+     int *deque; // Ring of REQUEST_POOL_WINDOW * workers entries
+     int first;
+     int count;
+     int index;
+     Thread thread;
+     struct ThreadStart start;
+     long long processed;
+     long long stolen;   // Strands taken from other workers' deques
+     double busySeconds; // Time spent in the handler
+     double *waits;      // Seconds each request waited in the pool
+ };
+ 
+ // What a run of the request pool did
+ struct RequestPoolStats
+ {
+     int workers;
+     long long processed;
+     int startDepth; // Requests in the service queue when the run started
+     int maxInFlight;
+     double seconds;
+     double waitP50, waitP99, waitMax; // Handed out until a worker started it
+     long long workerProcessed[REQUEST_POOL_MAX_WORKERS];
+     long long workerStolen[REQUEST_POOL_MAX_WORKERS];
+     double workerBusy[REQUEST_POOL_MAX_WORKERS];
+ };
+ 
+ // The request pool while it runs. Only the thread handing out requests
+ // touches the service queue; strands and their tasks are shared under
+ // strandLock.
+ struct ServicePool
+ {
+     struct RequestWorker workers[REQUEST_POOL_MAX_WORKERS];
+     int workerCount;
+     int dequeCapacity;
+     Mutex strandLock; // Guards the strands, their tasks and requestTaskPool
+     struct RequestStrand *strands;
+     int strandCount;
+     int strandCapacity;
+     struct IdIndex strandIndex; // Account number to strand
+     atomic_int inFlight;        // Handed out and not yet processed
+     atomic_bool dispatching;
+     RequestHandler handler;
+     void *context;
+ };
+ 
+ // Called once per transaction a range query finds
+ typedef void (*TransactionVisitor)(const struct Transaction *transaction, void *context);
+ 
+ // How much of the transaction history transactions.dat already holds
+ struct TransactionsFileState
+ {
+     bool valid;           // The file is oldest first and matches the history
+     long long fileCount;  // Records the file's header vouches for
+     long long savedCount; // Oldest entries unchanged since they were saved
+ };
+ 
+ // Global data structures
+ struct User currentUser;
+ struct AccountTable accountTable = {0};
+ struct IdIndex accountIndex = {NULL, 0, 0};
+ struct AccountsFileState accountsFile = {0};
+ struct WriteAheadLog wal = {NULL, 0, NULL, 0, 0, 0, 0.0, 64, 0.002};
+ 
+ // Node pools for the linked structures
+ struct NodePool transactionPool = {"TransactionNode", sizeof(struct TransactionNode), 1024};
+ struct NodePool historyPool = {"TransactionHistory", sizeof(struct TransactionHistory), 512};
+ struct NodePool requestPool = {"RequestNode", sizeof(struct RequestNode), 256};
+ struct NodePool edgePool = {"EdgeList", sizeof(struct EdgeList), 256};
+ struct NodePool requestTaskPool = {"RequestTask", sizeof(struct RequestTask), 1024};
+ struct TransactionNode *transactionStack = NULL;
+ long long transactionCount = 0;
+ atomic_llong transactionIdSequence = 1; // Next ID not yet in any writer's block
+ _Thread_local struct TransactionIdBlock transactionIdBlock = {0, 0};
+ struct TransactionIdIndex transactionIdIndex = {NULL, 0};
+ struct TransactionTimeline transactionTimeline = {NULL, NULL, 0, 0, 0, true};
+ 
+ // Deposits, withdrawals and transfers run concurrently. Each holds the
+ // stripes of the accounts it touches and queues its journal record on its
+ // thread's ring. Whoever holds journalLock drains the rings into journal.wal
+ // and the history, so both only ever have one writer. Account opening and
+ // closing, undo and saves change or read every account and hold all the
+ // stripes.
+ struct AccountStripe accountStripes[ACCOUNT_LOCK_STRIPES];
+ Mutex journalLock;
+ Mutex dirtyListLock; // Guards accountsFile's dirty list
+ _Atomic(struct JournalRing *) journalRings = NULL;
+ _Thread_local struct JournalRing *journalRing = NULL;
+ unsigned long long journalDrained[ACCOUNT_LOCK_STRIPES]; // Next sequence due per stripe
+ atomic_bool journalDrainerRunning = false;
+ Thread journalDrainer;
+ struct TransactionsFileState transactionsFile = {false, 0, 0};
+ struct RequestQueue serviceQueue = {NULL, 0, 0, {NULL, 0, 0}};
+ int lastRequestId = 1000; // Highest request ID handed out or loaded
+ struct ServicePool servicePool;
+ struct BranchNode *branchGraph = NULL;
+ int branchCount = 0;
+ int branchCapacity = 0;
+ struct IdIndex branchIndex = {NULL, 0, 0}; // Branch ID to branchGraph index
+ struct BranchRoutes branchRoutes = {NULL, NULL, NULL, 0, 0, true};
+ struct RouteSearch routeSearch = {0};
+ struct RouteMatrix routeMatrix = {NULL, NULL, NULL, 0, true, true};
+ struct RouteHierarchy routeHierarchy = {0};
+ struct HierarchySearch hierarchySearch = {0};
+ 
+ /***************************************************
+  * SECTION 2: AUTHENTICATION FUNCTIONS
+  ***************************************************/
+ 
+ struct User users[10]; // Array to store users (admin & regular)
+ int userCount = 0;
+ 
+ // Initialize with default admin
+ void initializeUsers()
+ {
+     strcpy(users[0].username, "admin");
+     strcpy(users[0].password, "admin123");
+     users[0].isAdmin = true;
+ 
+     strcpy(users[1].username, "user");
+     strcpy(users[1].password, "user123");
+     users[1].isAdmin = false;
+ 
+     userCount = 2;
+ }
+ 
+ // Index of the user with these credentials, or -1
+ int findUser(const char *username, const char *password)
+ {
+     for (int i = 0; i < userCount; i++)
+     {
+         if (strcmp(users[i].username, username) == 0 &&
+             strcmp(users[i].password, password) == 0)
+         {
+             return i;
+         }
+     }
+     return -1;
+ }
+ 
+ // Authenticate user
+ bool login(char *username, char *password, bool *isAdmin)
+ {
+     int i = findUser(username, password);
+     if (i == -1)
+     {
+         return false;
+     }
+     *isAdmin = users[i].isAdmin;
+     strcpy(currentUser.username, username);
+     strcpy(currentUser.password, password);
+     currentUser.isAdmin = *isAdmin;
+     return true;
+ }
+ 
+ // Add new user (admin only)
+ bool addUser(char *username, char *password, bool isAdmin)
+ {
+     if (userCount >= 10)
+     {
+         return false; // Maximum users reached
+     }
+ 
+     // Check if username already exists
+     for (int i = 0; i < userCount; i++)
+     {
+         if (strcmp(users[i].username, username) == 0)
+         {
+             return false; // Username already exists
+         }
+     }
+ 
+     strcpy(users[userCount].username, username);
+     strcpy(users[userCount].password, password);
+     users[userCount].isAdmin = isAdmin;
+     userCount++;
+     return true;
+ }
+ 
+ /***************************************************
+  * SECTION 3: DATA STRUCTURE OPERATIONS
+  ***************************************************/
+ 
+ // Money Operations
+ Money moneyFromFloat(double value)
+ {
+     return (Money)(value * 100.0 + (value < 0 ? -0.5 : 0.5));
+ }
+ 
+ // True for an amount a single operation may move
+ bool moneyAmountValid(Money amount)
+ {
+     return amount > 0 && amount <= MONEY_MAX_AMOUNT;
+ }
+ 
+ // True if amount can be credited to balance without overflowing Money
+ bool moneyCreditFits(Money balance, Money amount)
+ {
+     return balance <= 0 || amount <= LLONG_MAX - balance;
+ }
+ 
+ // Parse a non-negative amount such as "12", "12.5" or "12.34" into cents.
+ // Anything above MONEY_MAX_AMOUNT is rejected.
+ bool parseMoney(const char *text, Money *amount)
+ {
+     Money whole = 0;
+     int cents = 0;
+     int wholeDigits = 0;
+     int fractionDigits = 0;
+     const char *p = text;
+ 
+     while (*p >= '0' && *p <= '9')
+     {
+         if (whole > (LLONG_MAX / 100 - 99) / 10)
+         {
+             return false; // Too large
+         }
+         whole = whole * 10 + (*p - '0');
+         wholeDigits++;
+         p++;
+     }
+ 
+     if (*p == '.')
+     {
+         p++;
+         while (*p >= '0' && *p <= '9')
+         {
+             if (fractionDigits == 2)
+             {
+                 return false; // Sub-cent precision
+             }
+             cents = cents * 10 + (*p - '0');
+             fractionDigits++;
+             p++;
+         }
+     }
+ 
+     if (*p != '\0' || wholeDigits + fractionDigits == 0)
+     {
+         return false;
+     }
+ 
+     if (fractionDigits == 1)
+     {
+         cents *= 10;
+     }
+     if (whole * 100 + cents > MONEY_MAX_AMOUNT)
+     {
+         return false;
+     }
+     *amount = whole * 100 + cents;
+     return true;
+ }
+ 
+ // Read an amount from input; anything unparsable becomes -1, which the
+ // transaction functions reject
+ void scanMoney(Money *amount)
+ {
+     char text[MONEY_TEXT_SIZE];
+     if (scanf("%31s", text) != 1 || !parseMoney(text, amount))
+     {
+         *amount = -1;
+     }
+ }
+ 
+ // Format cents as "1234.56"; buffer must hold MONEY_TEXT_SIZE bytes
+ char *formatMoney(Money amount, char *buffer)
+ {
+     unsigned long long magnitude = amount < 0 ? -(unsigned long long)amount : (unsigned long long)amount;
+     sprintf(buffer, "%s%llu.%02llu", amount < 0 ? "-" : "", magnitude / 100, magnitude % 100);
+     return buffer;
+ }
+ 
+ // Time Operations
+ Timestamp timestampNow()
+ {
+     struct timespec ts;
+     clock_gettime(CLOCK_REALTIME, &ts);
+     return (Timestamp)ts.tv_sec * MICROS_PER_SECOND + ts.tv_nsec / 1000;
+ }
+ 
+ Timestamp timestampFromSeconds(time_t seconds)
+ {
+     return (Timestamp)seconds * MICROS_PER_SECOND;
+ }
+ 
+ // Whole seconds, rounding down for times before the epoch too
+ time_t timestampSeconds(Timestamp timestamp)
+ {
+     Timestamp seconds = timestamp / MICROS_PER_SECOND;
+     return (time_t)(timestamp % MICROS_PER_SECOND < 0 ? seconds - 1 : seconds);
+ }
+ 
+ void localTimeOf(time_t when, struct tm *result)
+ {
+ #ifdef _WIN32
+     localtime_s(result, &when);
+ #else
+     localtime_r(&when, result);
+ #endif
+ }
+ 
+ // Write a local time's date as "YYYY-MM-DD" into TIMESTAMP_TEXT_SIZE bytes.
+ // Each field is cut to its width, so the text always fits.
+ void formatCalendarDate(const struct tm *t, char *date)
+ {
+     snprintf(date, TIMESTAMP_TEXT_SIZE, "%04u-%02u-%02u", (unsigned int)(t->tm_year + 1900) % 10000u,
+              (unsigned int)(t->tm_mon + 1) % 100u, (unsigned int)t->tm_mday % 100u);
+ }
+ 
+ // Local midnight at the start of a day. Out-of-range months and days carry
+ // over, so the day after the last of a month is the next month's first.
+ Timestamp timestampFromDate(int year, int month, int day)
+ {
+     struct tm t;
+     memset(&t, 0, sizeof(t));
+     t.tm_year = year - 1900;
+     t.tm_mon = month - 1;
+     t.tm_mday = day;
+     t.tm_isdst = -1;
+     time_t seconds = mktime(&t);
+     return seconds == (time_t)-1 ? 0 : timestampFromSeconds(seconds);
+ }
+ 
+ // Read back a "YYYY-MM-DD" date and optional "HH:MM" time as written by
+ // older data files; text that doesn't parse becomes 0
+ Timestamp timestampFromText(const char *date, const char *time)
+ {
+     struct tm t;
+     memset(&t, 0, sizeof(t));
+     if (sscanf(date, "%d-%d-%d", &t.tm_year, &t.tm_mon, &t.tm_mday) != 3)
+     {
+         return 0;
+     }
+     if (time != NULL && sscanf(time, "%d:%d", &t.tm_hour, &t.tm_min) != 2)
+     {
+         t.tm_hour = 0;
+         t.tm_min = 0;
+     }
+     t.tm_year -= 1900;
+     t.tm_mon -= 1;
+     t.tm_isdst = -1;
+     time_t seconds = mktime(&t);
+     return seconds == (time_t)-1 ? 0 : timestampFromSeconds(seconds);
+ }
+ 
+ // Local day of the last timestamp formatted on this thread, so localtime
+ // only runs when formatting moves on to another day
+ struct DayFormatCache
+ {
+     time_t dayStart; // Local midnight
+     time_t dayEnd;   // The next local midnight
+     bool uniform;    // No clock change in the day, so time of day is an offset
+     char date[TIMESTAMP_TEXT_SIZE];
+ };
+ 
+ _Thread_local struct DayFormatCache dayFormatCache = {0, 0, false, ""};
+ 
+ // Format as a local "YYYY-MM-DD" date and "HH:MM" time. Either buffer may be
+ // NULL; each must hold TIMESTAMP_TEXT_SIZE bytes.
+ void formatTimestamp(Timestamp timestamp, char *date, char *time)
+ {
+     struct DayFormatCache *cache = &dayFormatCache;
+     time_t seconds = timestampSeconds(timestamp);
+     if (seconds < cache->dayStart || seconds >= cache->dayEnd)
+     {
+         struct tm t;
+         localTimeOf(seconds, &t);
+         formatCalendarDate(&t, cache->date);
+ 
+         struct tm midnight = t;
+         midnight.tm_hour = 0;
+         midnight.tm_min = 0;
+         midnight.tm_sec = 0;
+         midnight.tm_isdst = -1;
+         cache->dayStart = mktime(&midnight);
+         midnight.tm_mday++;
+         midnight.tm_hour = 0;
+         midnight.tm_isdst = -1;
+         cache->dayEnd = mktime(&midnight);
+         cache->uniform = cache->dayEnd - cache->dayStart == 86400;
+         if (cache->dayStart == (time_t)-1 || seconds < cache->dayStart || seconds >= cache->dayEnd)
+         {
+             // Midnight doesn't exist that day; cache just this second
+             cache->dayStart = seconds;
+             cache->dayEnd = seconds + 1;
+             cache->uniform = false;
+         }
+     }
+ 
+     if (date != NULL)
+     {
+         memcpy(date, cache->date, sizeof(cache->date));
+     }
+     if (time != NULL)
+     {
+         int hour, minute;
+         if (cache->uniform)
+         {
+             int offset = (int)(seconds - cache->dayStart);
+             hour = offset / 3600;
+             minute = offset / 60 % 60;
+         }
+         else
+         {
+             struct tm t;
+             localTimeOf(seconds, &t);
+             hour = t.tm_hour;
+             minute = t.tm_min;
+         }
+         time[0] = (char)('0' + hour / 10);
+         time[1] = (char)('0' + hour % 10);
+         time[2] = ':';
+         time[3] = (char)('0' + minute / 10);
+         time[4] = (char)('0' + minute % 10);
+         time[5] = '\0';
+     }
+ }
+ 
+ // Node Pool Operations
+ size_t poolSlabHeaderSize()
+ {
+     // Keep the first node of each slab suitably aligned
+     return (sizeof(struct NodeSlab) + 15) & ~(size_t)15;
+ }
+ 
+ size_t poolStride(struct NodePool *pool)
+ {
+     size_t size = pool->nodeSize < sizeof(void *) ? sizeof(void *) : pool->nodeSize;
+     return (size + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+ }
+ 
+ void *poolAlloc(struct NodePool *pool)
+ {
+     pool->liveCount++;
+     if (pool->liveCount > pool->highWater)
+     {
+         pool->highWater = pool->liveCount;
+     }
+ 
+     if (pool->freeList != NULL)
+     {
+         void *node = pool->freeList;
+         pool->freeList = *(void **)node;
+         pool->freeListCount--;
+         return node;
+     }
+ 
+     if (pool->bumpLeft == 0)
+     {
+         // Reuse slabs kept by a previous reset before asking malloc for more
+         struct NodeSlab *slab = pool->currentSlab != NULL ? pool->currentSlab->next : pool->slabs;
+         if (slab == NULL)
+         {
+             slab = (struct NodeSlab *)malloc(poolSlabHeaderSize() + poolStride(pool) * pool->nodesPerSlab);
+             if (slab == NULL)
+             {
+                 pool->liveCount--;
+                 return NULL;
+             }
+             slab->next = NULL;
+             if (pool->currentSlab != NULL)
+             {
+                 pool->currentSlab->next = slab;
+             }
+             else
+             {
+                 pool->slabs = slab;
+             }
+             pool->slabCount++;
+         }
+ 
+         pool->currentSlab = slab;
+         pool->bumpNext = (char *)slab + poolSlabHeaderSize();
+         pool->bumpLeft = pool->nodesPerSlab;
+     }
+ 
+     void *node = pool->bumpNext;
+     pool->bumpNext += poolStride(pool);
+     pool->bumpLeft--;
+     return node;
+ }
+ 
+ void poolFree(struct NodePool *pool, void *node)
+ {
+     if (node == NULL)
+     {
+         return;
+     }
+ 
+     *(void **)node = pool->freeList;
+     pool->freeList = node;
+     pool->freeListCount++;
+     pool->liveCount--;
+ }
+ 
+ // Drop every node in one step; slabs are kept for the next fill
+ void poolReset(struct NodePool *pool)
+ {
+     pool->currentSlab = NULL;
+     pool->bumpNext = NULL;
+     pool->bumpLeft = 0;
+     pool->freeList = NULL;
+     pool->freeListCount = 0;
+     pool->liveCount = 0;
+ }
+ 
+ // Return all slabs to the system
+ void poolRelease(struct NodePool *pool)
+ {
+     while (pool->slabs != NULL)
+     {
+         struct NodeSlab *next = pool->slabs->next;
+         free(pool->slabs);
+         pool->slabs = next;
+     }
+     pool->slabCount = 0;
+     poolReset(pool);
+ }
+ 
+ // Nodes that can be handed out without another malloc
+ int poolFreeCount(struct NodePool *pool)
+ {
+     return pool->slabCount * pool->nodesPerSlab - pool->liveCount;
+ }
+ 
+ void printPoolStats()
+ {
+     struct NodePool *pools[] = {&transactionPool, &historyPool, &requestPool, &edgePool, &requestTaskPool};
+ 
+     printf("%s%s%-18s %-10s %-10s %-10s %-8s %-10s %s\n",
+            BG_CYAN, BLACK, "Pool", "Live", "Free", "HighWater", "Slabs", "Bytes", RESET);
+     for (size_t i = 0; i < sizeof(pools) / sizeof(pools[0]); i++)
+     {
+         struct NodePool *pool = pools[i];
+         size_t bytes = (size_t)pool->slabCount * (poolSlabHeaderSize() + poolStride(pool) * pool->nodesPerSlab);
+         printf("%-18s %-10d %-10d %-10d %-8d %-10zu\n",
+                pool->name, pool->liveCount, poolFreeCount(pool),
+                pool->highWater, pool->slabCount, bytes);
+     }
+ }
+ 
+ // Write-Ahead Log Operations
+ double monotonicNow()
+ {
+     struct timespec ts;
+     clock_gettime(CLOCK_MONOTONIC, &ts);
+     return ts.tv_sec + ts.tv_nsec / 1e9;
+ }
+ 
+ int compareLatencies(const void *a, const void *b)
+ {
+     double x = *(const double *)a, y = *(const double *)b;
+     return x < y ? -1 : x > y;
+ }
+ 
+ // Percentile of latencies sorted by compareLatencies
+ double latencyPercentile(const double *sorted, long long count, double percentile)
+ {
+     long long i = (long long)(percentile / 100.0 * (count - 1) + 0.5);
+     return sorted[i];
+ }
+ 
+ // Push a file's buffered writes all the way to the disk. Returns false if
+ // they may not have got there.
+ bool syncFile(FILE *file)
+ {
+     if (fflush(file) != 0)
+     {
+         return false;
+     }
+ #ifdef _WIN32
+     return _commit(_fileno(file)) == 0;
+ #else
+     return fsync(fileno(file)) == 0;
+ #endif
+ }
+ 
+ bool truncateFile(FILE *file, long size)
+ {
+     fflush(file);
+ #ifdef _WIN32
+     return _chsize(_fileno(file), size) == 0;
+ #else
+     return ftruncate(fileno(file), size) == 0;
+ #endif
+ }
+ 
+ // Covers everything after the checksum field, payload included
+ unsigned int walChecksum(const unsigned char *record, size_t size)
+ {
+     unsigned int hash = 2166136261u;
+     for (size_t i = sizeof(unsigned int); i < size; i++)
+     {
+         hash = (hash ^ record[i]) * 16777619u;
+     }
+     return hash;
+ }
+ 
+ // Commit at most groupRecords records per fsync, and hold none of them for
+ // longer than groupWindow seconds
+ void walConfigure(int groupRecords, double groupWindow)
+ {
+     wal.groupRecords = groupRecords < 1 ? 1 : groupRecords;
+     wal.groupWindow = groupWindow < 0 ? 0 : groupWindow;
+ }
+ 
+ // Write out and fsync every pending record as one group. If that fails,
+ // whatever reached the file is cut off again and the records stay pending
+ // for the next try; returns false.
+ bool walFlush()
+ {
+     if (wal.bufferUsed == 0)
+     {
+         return true;
+     }
+     if (wal.file != NULL)
+     {
+         long end = ftell(wal.file);
+         bool written = fwrite(wal.buffer, 1, wal.bufferUsed, wal.file) == wal.bufferUsed &&
+                        syncFile(wal.file) && !ferror(wal.file);
+         if (!written)
+         {
+             clearerr(wal.file);
+             truncateFile(wal.file, end);
+             fseek(wal.file, end, SEEK_SET);
+             return false;
+         }
+         wal.commits++;
+     }
+     wal.bufferUsed = 0;
+     wal.pendingRecords = 0;
+     return true;
+ }
+ 
+ // Log an operation before it is applied. The record is durable once its
+ // group commits, which happens here when the group is full or the window
+ // has run out, and otherwise at the next walFlush. Nothing is logged while
+ // the journal is closed (loading, replay, benchmarks).
+ bool walAppend(int type, const void *payload, int payloadSize)
+ {
+     if (wal.file == NULL)
+     {
+         return false;
+     }
+ 
+     size_t size = sizeof(struct WalRecordHeader) + payloadSize;
+     if (wal.bufferUsed + size > wal.bufferCapacity)
+     {
+         size_t capacity = wal.bufferCapacity > 0 ? wal.bufferCapacity : 65536;
+         while (capacity < wal.bufferUsed + size)
+         {
+             capacity *= 2;
+         }
+         unsigned char *buffer = (unsigned char *)realloc(wal.buffer, capacity);
+         if (buffer == NULL)
+         {
+             return false;
+         }
+         wal.buffer = buffer;
+         wal.bufferCapacity = capacity;
+     }
+ 
+     struct WalRecordHeader header = {0, (unsigned short)type, (unsigned short)payloadSize, ++wal.lastLsn};
+     unsigned char *record = wal.buffer + wal.bufferUsed;
+     memcpy(record, &header, sizeof(header));
+     if (payloadSize > 0)
+     {
+         memcpy(record + sizeof(header), payload, payloadSize);
+     }
+     header.checksum = walChecksum(record, size);
+     memcpy(record, &header.checksum, sizeof(header.checksum));
+     wal.bufferUsed += size;
+     wal.records++;
+ 
+     double now = monotonicNow();
+     if (wal.pendingRecords++ == 0)
+     {
+         wal.oldestPending = now;
+     }
+     if (wal.pendingRecords >= wal.groupRecords || now - wal.oldestPending >= wal.groupWindow)
+     {
+         walFlush();
+     }
+     return true;
+ }
+ 
+ // Open journal.wal for appending. Anything past validEnd (a torn tail left
+ // by a crash) is cut off; validEnd 0 starts a new, empty journal.
+ bool walOpen(long validEnd)
+ {
+     wal.file = fopen(WAL_FILE_NAME, validEnd > 0 ? "r+b" : "wb");
+     if (wal.file == NULL)
+     {
+         printf("%sCould not open %s; changes are only kept by Save All Data.%s\n", RED, WAL_FILE_NAME, RESET);
+         return false;
+     }
+ 
+     if (validEnd > 0)
+     {
+         truncateFile(wal.file, validEnd);
+         fseek(wal.file, validEnd, SEEK_SET);
+     }
+     else
+     {
+         struct DataFileHeader header = {{0}};
+         memcpy(header.magic, WAL_FILE_MAGIC, sizeof(header.magic));
+         header.version = WAL_FILE_VERSION;
+         header.recordSize = sizeof(struct WalRecordHeader);
+         fwrite(&header, sizeof(header), 1, wal.file);
+         if (!syncFile(wal.file))
+         {
+             printf("%sCould not write %s; changes are only kept by Save All Data.%s\n", RED, WAL_FILE_NAME, RESET);
+             fclose(wal.file);
+             wal.file = NULL;
+             return false;
+         }
+     }
+     return true;
+ }
+ 
+ // Returns false if records still pending couldn't be written
+ bool walClose()
+ {
+     if (wal.file == NULL)
+     {
+         return true;
+     }
+     bool flushed = walFlush();
+     if (!flushed)
+     {
+         fprintf(stderr, "Could not write the last changes to %s\n", WAL_FILE_NAME);
+     }
+     fclose(wal.file);
+     wal.file = NULL;
+     return flushed;
+ }
+ 
+ // The snapshot files now hold everything logged so far; empty the journal.
+ // LSNs keep counting up so replay can compare them with the snapshots.
+ void walCheckpoint()
+ {
+     if (wal.file == NULL)
+     {
+         return;
+     }
+     walFlush();
+     truncateFile(wal.file, sizeof(struct DataFileHeader));
+     fseek(wal.file, sizeof(struct DataFileHeader), SEEK_SET);
+     syncFile(wal.file);
+ }
+ 
+ // Hash Index Operations
+ unsigned int hashId(int id)
+ {
+     // Fibonacci hashing spreads sequential IDs across the table
+     return (unsigned int)id * 2654435761u;
+ }
+ 
+ void idIndexClear(struct IdIndex *index)
+ {
+     free(index->slots);
+     index->slots = NULL;
+     index->capacity = 0;
+     index->count = 0;
+ }
+ 
+ bool idIndexResize(struct IdIndex *index, int newCapacity)
+ {
+     struct IdIndexSlot *newSlots = (struct IdIndexSlot *)malloc(newCapacity * sizeof(struct IdIndexSlot));
+     if (newSlots == NULL)
+     {
+         return false;
+     }
+     memset(newSlots, 0xff, newCapacity * sizeof(struct IdIndexSlot)); // Every value becomes -1
+ 
+     unsigned int mask = (unsigned int)newCapacity - 1;
+     for (int i = 0; i < index->capacity; i++)
+     {
+         if (index->slots[i].value < 0)
+         {
+             continue;
+         }
+ 
+         unsigned int pos = hashId(index->slots[i].id) & mask;
+         while (newSlots[pos].value >= 0)
+         {
+             pos = (pos + 1) & mask;
+         }
+         newSlots[pos] = index->slots[i];
+     }
+ 
+     free(index->slots);
+     index->slots = newSlots;
+     index->capacity = newCapacity;
+     return true;
+ }
+ 
+ // Returns the value stored for id, or -1
+ int idIndexFind(const struct IdIndex *index, int id)
+ {
+     if (index->count == 0)
+     {
+         return -1;
+     }
+ 
+     unsigned int mask = (unsigned int)index->capacity - 1;
+     unsigned int pos = hashId(id) & mask;
+     while (index->slots[pos].value >= 0)
+     {
+         if (index->slots[pos].id == id)
+         {
+             return index->slots[pos].value;
+         }
+         pos = (pos + 1) & mask;
+     }
+     return -1;
+ }
+ 
+ // Grow the table up front so a bulk load doesn't rehash repeatedly
+ bool idIndexReserve(struct IdIndex *index, int expectedCount)
+ {
+     int capacity = index->capacity == 0 ? 64 : index->capacity;
+     while (capacity < expectedCount * 2)
+     {
+         capacity *= 2;
+     }
+     return capacity == index->capacity || idIndexResize(index, capacity);
+ }
+ 
+ bool idIndexInsert(struct IdIndex *index, int id, int value)
+ {
+     // Keep the load factor at or below 0.5 so probe sequences stay short
+     if ((index->count + 1) * 2 > index->capacity)
+     {
+         int newCapacity = index->capacity == 0 ? 64 : index->capacity * 2;
+         if (!idIndexResize(index, newCapacity))
+         {
+             return false;
+         }
+     }
+ 
+     unsigned int mask = (unsigned int)index->capacity - 1;
+     unsigned int pos = hashId(id) & mask;
+     while (index->slots[pos].value >= 0)
+     {
+         if (index->slots[pos].id == id)
+         {
+             return false; // Already indexed
+         }
+         pos = (pos + 1) & mask;
+     }
+ 
+     index->slots[pos].id = id;
+     index->slots[pos].value = value;
+     index->count++;
+     return true;
+ }
+ 
+ // Change the value stored for an indexed ID (after an account's row moves)
+ void idIndexUpdate(struct IdIndex *index, int id, int value)
+ {
+     if (index->count == 0)
+     {
+         return;
+     }
+ 
+     unsigned int mask = (unsigned int)index->capacity - 1;
+     unsigned int pos = hashId(id) & mask;
+     while (index->slots[pos].value >= 0)
+     {
+         if (index->slots[pos].id == id)
+         {
+             index->slots[pos].value = value;
+             return;
+         }
+         pos = (pos + 1) & mask;
+     }
+ }
+ 
+ void idIndexRemove(struct IdIndex *index, int id)
+ {
+     if (index->count == 0)
+     {
+         return;
+     }
+ 
+     unsigned int mask = (unsigned int)index->capacity - 1;
+     unsigned int pos = hashId(id) & mask;
+     while (index->slots[pos].value >= 0 && index->slots[pos].id != id)
+     {
+         pos = (pos + 1) & mask;
+     }
+ 
+     if (index->slots[pos].value < 0)
+     {
+         return; // Not indexed
+     }
+ 
+     // Backward-shift deletion: pull later entries of the probe run into the hole
+     // so lookups never need tombstones
+     unsigned int hole = pos;
+     unsigned int next = (hole + 1) & mask;
+     while (index->slots[next].value >= 0)
+     {
+         unsigned int home = hashId(index->slots[next].id) & mask;
+         if (((next - home) & mask) >= ((next - hole) & mask))
+         {
+             index->slots[hole] = index->slots[next];
+             hole = next;
+         }
+         next = (next + 1) & mask;
+     }
+ 
+     index->slots[hole].value = -1;
+     index->count--;
+ }
+ 
+ // Lock Operations
+ void mutexInit(Mutex *mutex)
+ {
+ #ifdef _WIN32
+     InitializeSRWLock(mutex);
+ #else
+     pthread_mutex_init(mutex, NULL);
+ #endif
+ }
+ 
+ void mutexLock(Mutex *mutex)
+ {
+ #ifdef _WIN32
+     AcquireSRWLockExclusive(mutex);
+ #else
+     pthread_mutex_lock(mutex);
+ #endif
+ }
+ 
+ void mutexUnlock(Mutex *mutex)
+ {
+ #ifdef _WIN32
+     ReleaseSRWLockExclusive(mutex);
+ #else
+     pthread_mutex_unlock(mutex);
+ #endif
+ }
+ 
+ void initializeLocks()
+ {
+     for (int i = 0; i < ACCOUNT_LOCK_STRIPES; i++)
+     {
+         mutexInit(&accountStripes[i].lock);
+     }
+     mutexInit(&journalLock);
+     mutexInit(&dirtyListLock);
+ }
+ 
+ void yieldThread()
+ {
+ #ifdef _WIN32
+     SwitchToThread();
+ #else
+     sched_yield();
+ #endif
+ }
+ 
+ // The top bits of the hash, so neighbouring account numbers land on
+ // different stripes
+ int accountStripe(int accNo)
+ {
+     return (int)(hashId(accNo) >> (32 - ACCOUNT_LOCK_STRIPE_BITS));
+ }
+ 
+ void lockAccount(int accNo)
+ {
+     mutexLock(&accountStripes[accountStripe(accNo)].lock);
+ }
+ 
+ void unlockAccount(int accNo)
+ {
+     mutexUnlock(&accountStripes[accountStripe(accNo)].lock);
+ }
+ 
+ // Two accounts' stripes, lower stripe first so two transfers in opposite
+ // directions can't deadlock
+ void lockAccountPair(int accNo, int otherAccNo)
+ {
+     int a = accountStripe(accNo);
+     int b = accountStripe(otherAccNo);
+     mutexLock(&accountStripes[a < b ? a : b].lock);
+     if (a != b)
+     {
+         mutexLock(&accountStripes[a < b ? b : a].lock);
+     }
+ }
+ 
+ void unlockAccountPair(int accNo, int otherAccNo)
+ {
+     int a = accountStripe(accNo);
+     int b = accountStripe(otherAccNo);
+     if (a != b)
+     {
+         mutexUnlock(&accountStripes[a < b ? b : a].lock);
+     }
+     mutexUnlock(&accountStripes[a < b ? a : b].lock);
+ }
+ 
+ // Stop every deposit, withdrawal and transfer, for work that touches the
+ // whole table
+ void lockAllAccounts()
+ {
+     for (int i = 0; i < ACCOUNT_LOCK_STRIPES; i++)
+     {
+         mutexLock(&accountStripes[i].lock);
+     }
+ }
+ 
+ void unlockAllAccounts()
+ {
+     for (int i = ACCOUNT_LOCK_STRIPES - 1; i >= 0; i--)
+     {
+         mutexUnlock(&accountStripes[i].lock);
+     }
+ }
+ 
+ #ifdef _WIN32
+ DWORD WINAPI threadEntry(LPVOID start)
+ {
+     ((struct ThreadStart *)start)->run(((struct ThreadStart *)start)->arg);
+     return 0;
+ }
+ #endif
+ 
+ // start must stay valid until the thread is joined
+ bool startThread(Thread *thread, struct ThreadStart *start)
+ {
+ #ifdef _WIN32
+     *thread = CreateThread(NULL, 0, threadEntry, start, 0, NULL);
+     return *thread != NULL;
+ #else
+     return pthread_create(thread, NULL, start->run, start->arg) == 0;
+ #endif
+ }
+ 
+ void joinThread(Thread thread)
+ {
+ #ifdef _WIN32
+     WaitForSingleObject(thread, INFINITE);
+     CloseHandle(thread);
+ #else
+     pthread_join(thread, NULL);
+ #endif
+ }
+ 
+ int processorCount()
+ {
+ #ifdef _WIN32
+     SYSTEM_INFO info;
+     GetSystemInfo(&info);
+     return (int)info.dwNumberOfProcessors;
+ #else
+     long count = sysconf(_SC_NPROCESSORS_ONLN);
+     return count < 1 ? 1 : (int)count;
+ #endif
+ }
+ 
+ // Account Table Operations
+ bool accountTableReserve(int capacity)
+ {
+     if (capacity <= accountTable.capacity)
+     {
+         return true;
+     }
+ 
+     // Each column is grown on its own; any that already grew stay valid at
+     // the old capacity if a later one fails
+     int *accountNo = (int *)realloc(accountTable.accountNo, capacity * sizeof(int));
+     if (accountNo == NULL)
+     {
+         return false;
+     }
+     accountTable.accountNo = accountNo;
+ 
+     Money *balance = (Money *)realloc(accountTable.balance, capacity * sizeof(Money));
+     if (balance == NULL)
+     {
+         return false;
+     }
+     accountTable.balance = balance;
+ 
+     unsigned char *flags = (unsigned char *)realloc(accountTable.flags, capacity);
+     if (flags == NULL)
+     {
+         return false;
+     }
+     accountTable.flags = flags;
+ 
+     struct TransactionHistory **history = (struct TransactionHistory **)realloc(accountTable.history, capacity * sizeof(*history));
+     if (history == NULL)
+     {
+         return false;
+     }
+     accountTable.history = history;
+ 
+     int *profileIndex = (int *)realloc(accountTable.profileIndex, capacity * sizeof(int));
+     if (profileIndex == NULL)
+     {
+         return false;
+     }
+     accountTable.profileIndex = profileIndex;
+ 
+     int *fileSlot = (int *)realloc(accountTable.fileSlot, capacity * sizeof(int));
+     if (fileSlot == NULL)
+     {
+         return false;
+     }
+     accountTable.fileSlot = fileSlot;
+ 
+     accountTable.capacity = capacity;
+     return true;
+ }
+ 
+ bool appendToIntArray(int **array, int *count, int *capacity, int value)
+ {
+     if (*count == *capacity)
+     {
+         int grownCapacity = *capacity == 0 ? 64 : *capacity * 2;
+         int *grown = (int *)realloc(*array, grownCapacity * sizeof(int));
+         if (grown == NULL)
+         {
+             return false;
+         }
+         *array = grown;
+         *capacity = grownCapacity;
+     }
+     (*array)[(*count)++] = value;
+     return true;
+ }
+ 
+ // Queue a changed account for the next checkpoint
+ void markAccountDirty(int row)
+ {
+     if (accountTable.flags[row] & ACCOUNT_DIRTY)
+     {
+         return;
+     }
+     accountTable.flags[row] |= ACCOUNT_DIRTY;
+ 
+     // The flag is covered by the row's stripe; the list is shared
+     mutexLock(&dirtyListLock);
+     if (!appendToIntArray(&accountsFile.dirtyAccounts, &accountsFile.dirtyCount,
+                           &accountsFile.dirtyCapacity, accountTable.accountNo[row]))
+     {
+         // The change can't be tracked, so the next checkpoint writes everything
+         accountsFile.valid = false;
+     }
+     mutexUnlock(&dirtyListLock);
+ }
+ 
+ // Hand out a profile slot, reusing one freed by deleteAccount if possible
+ int allocateProfile()
+ {
+     if (accountTable.freeProfileCount > 0)
+     {
+         return accountTable.freeProfiles[--accountTable.freeProfileCount];
+     }
+ 
+     if (accountTable.profileCount == accountTable.profileCapacity)
+     {
+         int capacity = accountTable.profileCapacity == 0 ? 64 : accountTable.profileCapacity * 2;
+         struct AccountProfile *profiles = (struct AccountProfile *)realloc(accountTable.profiles, capacity * sizeof(struct AccountProfile));
+         if (profiles == NULL)
+         {
+             return -1;
+         }
+         accountTable.profiles = profiles;
+ 
+         int *freeProfiles = (int *)realloc(accountTable.freeProfiles, capacity * sizeof(int));
+         if (freeProfiles == NULL)
+         {
+             return -1;
+         }
+         accountTable.freeProfiles = freeProfiles;
+         accountTable.profileCapacity = capacity;
+     }
+     return accountTable.profileCount++;
+ }
+ 
+ struct AccountProfile *accountProfile(int row)
+ {
+     return &accountTable.profiles[accountTable.profileIndex[row]];
+ }
+ 
+ // Append a row for an account that is known not to exist yet
+ bool appendAccountRow(int accNo, Money balance, unsigned char flags, const struct AccountProfile *profileData)
+ {
+     if (accountTable.count == accountTable.capacity &&
+         !accountTableReserve(accountTable.capacity == 0 ? 64 : accountTable.capacity * 2))
+     {
+         return false;
+     }
+ 
+     int profile = allocateProfile();
+     if (profile == -1)
+     {
+         return false;
+     }
+ 
+     int row = accountTable.count;
+     if (!idIndexInsert(&accountIndex, accNo, row))
+     {
+         accountTable.freeProfiles[accountTable.freeProfileCount++] = profile;
+         return false;
+     }
+ 
+     accountTable.accountNo[row] = accNo;
+     accountTable.balance[row] = balance;
+     accountTable.flags[row] = flags;
+     accountTable.history[row] = NULL;
+     accountTable.profileIndex[row] = profile;
+     accountTable.fileSlot[row] = -1;
+     accountTable.profiles[profile] = *profileData;
+     accountTable.count++;
+     return true;
+ }
+ 
+ void removeAccountRow(int row)
+ {
+     idIndexRemove(&accountIndex, accountTable.accountNo[row]);
+ 
+     // Its transactions stay in the bank's history but are no longer indexed
+     struct TransactionHistory *chunk = accountTable.history[row];
+     while (chunk != NULL)
+     {
+         struct TransactionHistory *older = chunk->older;
+         poolFree(&historyPool, chunk);
+         chunk = older;
+     }
+ 
+     // Release the profile slot for reuse
+     accountTable.freeProfiles[accountTable.freeProfileCount++] = accountTable.profileIndex[row];
+ 
+     // The next checkpoint leaves a tombstone in the account's file slot
+     if (accountTable.fileSlot[row] != -1 &&
+         !appendToIntArray(&accountsFile.releasedSlots, &accountsFile.releasedSlotCount,
+                           &accountsFile.releasedSlotCapacity, accountTable.fileSlot[row]))
+     {
+         accountsFile.valid = false;
+     }
+ 
+     // Keep the columns dense by moving the last row into the hole
+     int last = accountTable.count - 1;
+     if (row != last)
+     {
+         accountTable.accountNo[row] = accountTable.accountNo[last];
+         accountTable.balance[row] = accountTable.balance[last];
+         accountTable.flags[row] = accountTable.flags[last];
+         accountTable.history[row] = accountTable.history[last];
+         accountTable.profileIndex[row] = accountTable.profileIndex[last];
+         accountTable.fileSlot[row] = accountTable.fileSlot[last];
+         idIndexUpdate(&accountIndex, accountTable.accountNo[row], row);
+     }
+     accountTable.count--;
+ }
+ 
+ // Returns the account's table row, or -1 if there is no such account
+ int findAccount(int accNo)
+ {
+     return idIndexFind(&accountIndex, accNo);
+ }
+ 
+ void clearAccounts()
+ {
+     accountTable.count = 0;
+     accountTable.profileCount = 0;
+     accountTable.freeProfileCount = 0;
+     idIndexClear(&accountIndex);
+     poolReset(&historyPool);
+ 
+     // The table no longer matches accounts.dat
+     accountsFile.valid = false;
+     accountsFile.slotCount = 0;
+     accountsFile.checksum = 0;
+     accountsFile.freeSlotCount = 0;
+     accountsFile.releasedSlotCount = 0;
+     accountsFile.dirtyCount = 0;
+ }
+ 
+ // Transaction ID Operations
+ // Take the next ID from this thread's block, fetching a new block from the
+ // shared sequence when it runs out. Writers only meet on the sequence once
+ // every TRANSACTION_ID_BLOCK IDs; IDs left in a block are never used.
+ long long takeTransactionId()
+ {
+     if (transactionIdBlock.next == transactionIdBlock.end)
+     {
+         transactionIdBlock.next = atomic_fetch_add(&transactionIdSequence, TRANSACTION_ID_BLOCK);
+         transactionIdBlock.end = transactionIdBlock.next + TRANSACTION_ID_BLOCK;
+     }
+     return transactionIdBlock.next++;
+ }
+ 
+ // Make sure the sequence never hands out an ID at or below one already in
+ // use (loaded, replayed or restored from a saved counter)
+ void raiseTransactionIdSequence(long long next)
+ {
+     long long current = atomic_load_explicit(&transactionIdSequence, memory_order_relaxed);
+     while (current < next && !atomic_compare_exchange_weak(&transactionIdSequence, &current, next))
+     {
+     }
+ }
+ 
+ long long peekTransactionIdSequence()
+ {
+     return atomic_load(&transactionIdSequence);
+ }
+ 
+ struct TransactionNode **transactionIdSlot(long long id, bool create)
+ {
+     if (id < 0)
+     {
+         return NULL;
+     }
+ 
+     long long page = id / TRANSACTION_ID_PAGE_ENTRIES;
+     if (page >= transactionIdIndex.pageCount)
+     {
+         if (!create)
+         {
+             return NULL;
+         }
+         long long pageCount = transactionIdIndex.pageCount == 0 ? 16 : transactionIdIndex.pageCount;
+         while (pageCount <= page)
+         {
+             pageCount *= 2;
+         }
+         struct TransactionNode ***pages = (struct TransactionNode ***)realloc(transactionIdIndex.pages, pageCount * sizeof(*pages));
+         if (pages == NULL)
+         {
+             return NULL;
+         }
+         memset(pages + transactionIdIndex.pageCount, 0, (pageCount - transactionIdIndex.pageCount) * sizeof(*pages));
+         transactionIdIndex.pages = pages;
+         transactionIdIndex.pageCount = pageCount;
+     }
+ 
+     if (transactionIdIndex.pages[page] == NULL)
+     {
+         if (!create)
+         {
+             return NULL;
+         }
+         transactionIdIndex.pages[page] = (struct TransactionNode **)calloc(TRANSACTION_ID_PAGE_ENTRIES, sizeof(struct TransactionNode *));
+         if (transactionIdIndex.pages[page] == NULL)
+         {
+             return NULL;
+         }
+     }
+     return &transactionIdIndex.pages[page][id % TRANSACTION_ID_PAGE_ENTRIES];
+ }
+ 
+ // Returns the transaction with this ID, or NULL if it isn't in the history.
+ // Where old files repeat an ID, the newest transaction with it is found.
+ struct Transaction *findTransaction(long long id)
+ {
+     struct TransactionNode **slot = transactionIdSlot(id, false);
+     return slot != NULL && *slot != NULL ? &(*slot)->data : NULL;
+ }
+ 
+ void clearTransactionIdIndex()
+ {
+     for (long long page = 0; page < transactionIdIndex.pageCount; page++)
+     {
+         free(transactionIdIndex.pages[page]);
+     }
+     free(transactionIdIndex.pages);
+     transactionIdIndex.pages = NULL;
+     transactionIdIndex.pageCount = 0;
+ }
+ 
+ // Timeline Operations
+ void timelineAppend(struct TransactionNode *node)
+ {
+     struct TransactionTimeline *timeline = &transactionTimeline;
+     Timestamp timestamp = node->data.timestamp;
+     if (timeline->segmentCount == 0 || timeline->lastCount == TIMELINE_SEGMENT_ENTRIES)
+     {
+         if (timeline->segmentCount == timeline->segmentCapacity)
+         {
+             int capacity = timeline->segmentCapacity == 0 ? 64 : timeline->segmentCapacity * 2;
+             struct TransactionNode ***segments = (struct TransactionNode ***)realloc(timeline->segments, capacity * sizeof(*segments));
+             if (segments == NULL)
+             {
+                 return;
+             }
+             timeline->segments = segments;
+             struct TimelineBounds *bounds = (struct TimelineBounds *)realloc(timeline->bounds, capacity * sizeof(*bounds));
+             if (bounds == NULL)
+             {
+                 return;
+             }
+             timeline->bounds = bounds;
+             timeline->segmentCapacity = capacity;
+         }
+         struct TransactionNode **segment = (struct TransactionNode **)malloc(TIMELINE_SEGMENT_ENTRIES * sizeof(*segment));
+         if (segment == NULL)
+         {
+             return;
+         }
+         if (timeline->segmentCount > 0 && timestamp < timeline->bounds[timeline->segmentCount - 1].latest)
+         {
+             timeline->ordered = false;
+         }
+         timeline->segments[timeline->segmentCount] = segment;
+         timeline->bounds[timeline->segmentCount].earliest = timestamp;
+         timeline->bounds[timeline->segmentCount].latest = timestamp;
+         timeline->segmentCount++;
+         timeline->lastCount = 0;
+     }
+ 
+     struct TimelineBounds *bounds = &timeline->bounds[timeline->segmentCount - 1];
+     if (timestamp < bounds->latest)
+     {
+         timeline->ordered = false;
+     }
+     if (timestamp < bounds->earliest)
+     {
+         bounds->earliest = timestamp;
+     }
+     if (timestamp > bounds->latest)
+     {
+         bounds->latest = timestamp;
+     }
+     timeline->segments[timeline->segmentCount - 1][timeline->lastCount++] = node;
+ }
+ 
+ // A popped node is the newest on the timeline unless appending it failed.
+ // The bounds of its segment shrink back; ordered stays as it was.
+ void timelineRemoveLast(struct TransactionNode *node)
+ {
+     struct TransactionTimeline *timeline = &transactionTimeline;
+     if (timeline->segmentCount == 0)
+     {
+         return;
+     }
+     int last = timeline->segmentCount - 1;
+     struct TransactionNode **segment = timeline->segments[last];
+     if (segment[timeline->lastCount - 1] != node)
+     {
+         return;
+     }
+     if (--timeline->lastCount == 0)
+     {
+         free(segment);
+         timeline->segmentCount--;
+         timeline->lastCount = timeline->segmentCount > 0 ? TIMELINE_SEGMENT_ENTRIES : 0;
+         return;
+     }
+ 
+     struct TimelineBounds *bounds = &timeline->bounds[last];
+     bounds->earliest = bounds->latest = segment[0]->data.timestamp;
+     for (int i = 1; i < timeline->lastCount; i++)
+     {
+         Timestamp timestamp = segment[i]->data.timestamp;
+         if (timestamp < bounds->earliest)
+         {
+             bounds->earliest = timestamp;
+         }
+         if (timestamp > bounds->latest)
+         {
+             bounds->latest = timestamp;
+         }
+     }
+ }
+ 
+ void clearTimeline()
+ {
+     for (int i = 0; i < transactionTimeline.segmentCount; i++)
+     {
+         free(transactionTimeline.segments[i]);
+     }
+     free(transactionTimeline.segments);
+     free(transactionTimeline.bounds);
+     transactionTimeline.segments = NULL;
+     transactionTimeline.bounds = NULL;
+     transactionTimeline.segmentCount = 0;
+     transactionTimeline.segmentCapacity = 0;
+     transactionTimeline.lastCount = 0;
+     transactionTimeline.ordered = true;
+ }
+ 
+ int timelineSegmentEntries(int segment)
+ {
+     return segment == transactionTimeline.segmentCount - 1 ? transactionTimeline.lastCount : TIMELINE_SEGMENT_ENTRIES;
+ }
+ 
+ // Visit every transaction with from <= timestamp < to, newest first, and
+ // return how many there were. Only segments whose bounds overlap the range
+ // are read.
+ long long forEachTransactionBetween(Timestamp from, Timestamp to,
+                                     TransactionVisitor visit, void *context)
+ {
+     struct TransactionTimeline *timeline = &transactionTimeline;
+     int first = 0;
+     int end = timeline->segmentCount;
+     if (timeline->ordered)
+     {
+         // First segment reaching from, and first segment starting at or after to
+         int lo = 0, hi = end;
+         while (lo < hi)
+         {
+             int mid = lo + (hi - lo) / 2;
+             if (timeline->bounds[mid].latest < from)
+             {
+                 lo = mid + 1;
+             }
+             else
+             {
+                 hi = mid;
+             }
+         }
+         first = lo;
+         hi = end;
+         while (lo < hi)
+         {
+             int mid = lo + (hi - lo) / 2;
+             if (timeline->bounds[mid].earliest < to)
+             {
+                 lo = mid + 1;
+             }
+             else
+             {
+                 hi = mid;
+             }
+         }
+         end = lo;
+     }
+ 
+     long long visited = 0;
+     for (int s = end - 1; s >= first; s--)
+     {
+         if (timeline->bounds[s].latest < from || timeline->bounds[s].earliest >= to)
+         {
+             continue;
+         }
+         struct TransactionNode **segment = timeline->segments[s];
+         for (int i = timelineSegmentEntries(s) - 1; i >= 0; i--)
+         {
+             const struct Transaction *transaction = &segment[i]->data;
+             if (transaction->timestamp >= from && transaction->timestamp < to)
+             {
+                 visit(transaction, context);
+                 visited++;
+             }
+         }
+     }
+     return visited;
+ }
+ 
+ // The same for one account's transactions, from its own chain
+ long long forEachAccountTransactionBetween(int row, Timestamp from, Timestamp to,
+                                            TransactionVisitor visit, void *context)
+ {
+     long long visited = 0;
+     for (struct TransactionHistory *chunk = accountTable.history[row]; chunk != NULL; chunk = chunk->older)
+     {
+         if (chunk->latest < from)
+         {
+             break; // Every older chunk is before the range too
+         }
+         if (chunk->earliest >= to)
+         {
+             continue;
+         }
+         for (int i = chunk->count - 1; i >= 0; i--)
+         {
+             const struct Transaction *transaction = &chunk->entries[i]->data;
+             if (transaction->timestamp >= from && transaction->timestamp < to)
+             {
+                 visit(transaction, context);
+                 visited++;
+             }
+         }
+     }
+     return visited;
+ }
+ 
+ // Stack Operations
+ // File a new transaction under its account, if the account exists
+ void indexAccountTransaction(struct TransactionNode *node)
+ {
+     int row = findAccount(node->data.accountNo);
+     if (row == -1)
+     {
+         return;
+     }
+ 
+     struct TransactionHistory *chunk = accountTable.history[row];
+     if (chunk == NULL || chunk->count == HISTORY_CHUNK_ENTRIES)
+     {
+         struct TransactionHistory *newer = (struct TransactionHistory *)poolAlloc(&historyPool);
+         if (newer == NULL)
+         {
+             return;
+         }
+         newer->older = chunk;
+         newer->count = 0;
+         newer->earliest = node->data.timestamp;
+         newer->latest = chunk != NULL ? chunk->latest : node->data.timestamp;
+         accountTable.history[row] = newer;
+         chunk = newer;
+     }
+     if (node->data.timestamp < chunk->earliest)
+     {
+         chunk->earliest = node->data.timestamp;
+     }
+     if (node->data.timestamp > chunk->latest)
+     {
+         chunk->latest = node->data.timestamp;
+     }
+     chunk->entries[chunk->count++] = node;
+ }
+ 
+ // A popped node is always its account's newest entry, unless it was pushed
+ // before the account existed and so was never indexed
+ void unindexAccountTransaction(struct TransactionNode *node)
+ {
+     int row = findAccount(node->data.accountNo);
+     if (row == -1)
+     {
+         return;
+     }
+ 
+     struct TransactionHistory *chunk = accountTable.history[row];
+     if (chunk == NULL || chunk->entries[chunk->count - 1] != node)
+     {
+         return;
+     }
+     if (--chunk->count == 0)
+     {
+         accountTable.history[row] = chunk->older;
+         poolFree(&historyPool, chunk);
+         return;
+     }
+ 
+     chunk->earliest = chunk->entries[0]->data.timestamp;
+     chunk->latest = chunk->older != NULL ? chunk->older->latest : chunk->earliest;
+     for (int i = 0; i < chunk->count; i++)
+     {
+         Timestamp timestamp = chunk->entries[i]->data.timestamp;
+         if (timestamp < chunk->earliest)
+         {
+             chunk->earliest = timestamp;
+         }
+         if (timestamp > chunk->latest)
+         {
+             chunk->latest = timestamp;
+         }
+     }
+ }
+ 
+ void pushTransaction(struct Transaction transaction)
+ {
+     struct TransactionNode *newNode = (struct TransactionNode *)poolAlloc(&transactionPool);
+     if (newNode == NULL)
+     {
+         return;
+     }
+     newNode->data = transaction;
+     newNode->next = transactionStack;
+     transactionStack = newNode;
+     transactionCount++;
+     indexAccountTransaction(newNode);
+     timelineAppend(newNode);
+ 
+     struct TransactionNode **slot = transactionIdSlot(transaction.transactionId, true);
+     if (slot != NULL)
+     {
+         *slot = newNode;
+     }
+     if (transaction.transactionId >= peekTransactionIdSequence())
+     {
+         raiseTransactionIdSequence(transaction.transactionId + 1);
+     }
+ }
+ 
+ struct Transaction popTransaction()
+ {
+     struct Transaction transaction = {0};
+     if (transactionStack == NULL)
+     {
+         return transaction;
+     }
+ 
+     struct TransactionNode *temp = transactionStack;
+     transactionStack = transactionStack->next;
+     transaction = temp->data;
+     unindexAccountTransaction(temp);
+     timelineRemoveLast(temp);
+     struct TransactionNode **slot = transactionIdSlot(transaction.transactionId, false);
+     if (slot != NULL && *slot == temp)
+     {
+         *slot = NULL;
+     }
+     poolFree(&transactionPool, temp);
+ 
+     // An entry popped from saved history has to be dropped from the file too
+     transactionCount--;
+     if (transactionCount < transactionsFile.savedCount)
+     {
+         transactionsFile.savedCount = transactionCount;
+     }
+     return transaction;
+ }
+ 
+ // Drop the whole history in one step. The ID sequence carries on, so IDs
+ // stay unique across a reload.
+ void clearTransactions()
+ {
+     transactionStack = NULL;
+     transactionCount = 0;
+     poolReset(&transactionPool);
+     poolReset(&historyPool);
+     clearTransactionIdIndex();
+     clearTimeline();
+     for (int row = 0; row < accountTable.count; row++)
+     {
+         accountTable.history[row] = NULL;
+     }
+     transactionsFile.valid = false;
+     transactionsFile.fileCount = 0;
+     transactionsFile.savedCount = 0;
+ }
+ 
+ // Queue Operations
+ // Every pending request ages at the same rate, so "priority plus one level
+ // per REQUEST_AGING_MICROS waited" orders requests the same way at any
+ // moment as this fixed rank does. The heap never needs reordering as time
+ // passes.
+ long long requestRank(int priority, Timestamp submittedAt)
+ {
+     return priority * REQUEST_AGING_MICROS - submittedAt;
+ }
+ 
+ // Whether a is served before b; equal ranks go in the order submitted
+ bool requestBefore(const struct RequestNode *a, const struct RequestNode *b)
+ {
+     return a->rank != b->rank ? a->rank > b->rank : a->requestId < b->requestId;
+ }
+ 
+ // Encode a request as a record of just the size its texts need; returns
+ // the size. record needs room for a header and both texts.
+ size_t encodeRequest(const struct ServiceRequest *request, unsigned char *record)
+ {
+     struct RequestRecordHeader header = {0};
+     size_t typeLength = strnlen(request->requestType, sizeof(request->requestType) - 1);
+     size_t descriptionLength = strnlen(request->description, sizeof(request->description) - 1);
+     header.submittedAt = request->submittedAt;
+     header.requestId = request->requestId;
+     header.accountNo = request->accountNo;
+     header.priority = (unsigned char)request->priority;
+     header.typeLength = (unsigned char)typeLength;
+     header.descriptionLength = (unsigned char)descriptionLength;
+     memcpy(record, &header, sizeof(header));
+     memcpy(record + sizeof(header), request->requestType, typeLength);
+     memcpy(record + sizeof(header) + typeLength, request->description, descriptionLength);
+     return sizeof(header) + typeLength + descriptionLength;
+ }
+ 
+ size_t requestRecordSize(const struct RequestRecordHeader *header)
+ {
+     return sizeof(*header) + header->typeLength + header->descriptionLength;
+ }
+ 
+ // Returns false if the record is damaged or its size doesn't match
+ bool decodeRequest(const unsigned char *record, size_t size, struct ServiceRequest *request)
+ {
+     struct RequestRecordHeader header;
+     if (size < sizeof(header))
+     {
+         return false;
+     }
+     memcpy(&header, record, sizeof(header));
+     if (size != requestRecordSize(&header) || header.typeLength >= sizeof(request->requestType) ||
+         header.descriptionLength >= sizeof(request->description))
+     {
+         return false;
+     }
+     memset(request, 0, sizeof(*request));
+     request->requestId = header.requestId;
+     request->accountNo = header.accountNo;
+     request->priority = header.priority;
+     request->submittedAt = header.submittedAt;
+     memcpy(request->requestType, record + sizeof(header), header.typeLength);
+     memcpy(request->description, record + sizeof(header) + header.typeLength, header.descriptionLength);
+     return true;
+ }
+ 
+ // The full request a queue node holds
+ void requestFromNode(const struct RequestNode *node, struct ServiceRequest *request)
+ {
+     memset(request, 0, sizeof(*request));
+     request->requestId = node->requestId;
+     request->accountNo = node->accountNo;
+     request->priority = node->priority;
+     request->submittedAt = node->submittedAt;
+     const char *description = node->text + strlen(node->text) + 1;
+     snprintf(request->requestType, sizeof(request->requestType), "%s", node->text);
+     snprintf(request->description, sizeof(request->description), "%s", description);
+ }
+ 
+ // Log a change to the service queue; the queue isn't rebuilt from
+ // snapshots alone
+ void logRequestEvent(int type, const void *payload, int payloadSize)
+ {
+     mutexLock(&journalLock);
+     walAppend(type, payload, payloadSize);
+     mutexUnlock(&journalLock);
+ }
+ 
+ void requestHeapPlace(int pos, struct RequestNode *node)
+ {
+     serviceQueue.heap[pos] = node;
+     idIndexUpdate(&serviceQueue.positions, node->requestId, pos);
+ }
+ 
+ void requestSiftUp(int pos)
+ {
+     struct RequestNode *node = serviceQueue.heap[pos];
+     while (pos > 0 && requestBefore(node, serviceQueue.heap[(pos - 1) / 2]))
+     {
+         requestHeapPlace(pos, serviceQueue.heap[(pos - 1) / 2]);
+         pos = (pos - 1) / 2;
+     }
+     requestHeapPlace(pos, node);
+ }
+ 
+ void requestSiftDown(int pos)
+ {
+     struct RequestNode *node = serviceQueue.heap[pos];
+     while (2 * pos + 1 < serviceQueue.count)
+     {
+         int child = 2 * pos + 1;
+         if (child + 1 < serviceQueue.count && requestBefore(serviceQueue.heap[child + 1], serviceQueue.heap[child]))
+         {
+             child++;
+         }
+         if (!requestBefore(serviceQueue.heap[child], node))
+         {
+             break;
+         }
+         requestHeapPlace(pos, serviceQueue.heap[child]);
+         pos = child;
+     }
+     requestHeapPlace(pos, node);
+ }
+ 
+ // Take the request at a heap position out of the queue and return it
+ struct ServiceRequest removeRequestAt(int pos)
+ {
+     struct RequestNode *node = serviceQueue.heap[pos];
+     struct ServiceRequest request;
+     requestFromNode(node, &request);
+     idIndexRemove(&serviceQueue.positions, request.requestId);
+     free(node->text);
+     poolFree(&requestPool, node);
+     logRequestEvent(WAL_REQUEST_DEQUEUE, &request.requestId, sizeof(request.requestId));
+ 
+     struct RequestNode *last = serviceQueue.heap[--serviceQueue.count];
+     if (pos < serviceQueue.count)
+     {
+         requestHeapPlace(pos, last);
+         if (pos > 0 && requestBefore(last, serviceQueue.heap[(pos - 1) / 2]))
+         {
+             requestSiftUp(pos);
+         }
+         else
+         {
+             requestSiftDown(pos);
+         }
+     }
+     return request;
+ }
+ 
+ // Returns false if the ID is already queued or there is no memory
+ bool enqueueRequest(struct ServiceRequest request)
+ {
+     if (serviceQueue.count == serviceQueue.capacity)
+     {
+         int capacity = serviceQueue.capacity == 0 ? 64 : serviceQueue.capacity * 2;
+         struct RequestNode **heap = (struct RequestNode **)realloc(serviceQueue.heap, capacity * sizeof(*heap));
+         if (heap == NULL)
+         {
+             return false;
+         }
+         serviceQueue.heap = heap;
+         serviceQueue.capacity = capacity;
+     }
+ 
+     size_t typeLength = strnlen(request.requestType, sizeof(request.requestType) - 1);
+     size_t descriptionLength = strnlen(request.description, sizeof(request.description) - 1);
+     struct RequestNode *newNode = (struct RequestNode *)poolAlloc(&requestPool);
+     char *text = (char *)malloc(typeLength + descriptionLength + 2);
+     if (newNode == NULL || text == NULL)
+     {
+         if (newNode != NULL)
+         {
+             poolFree(&requestPool, newNode);
+         }
+         free(text);
+         return false;
+     }
+     if (!idIndexInsert(&serviceQueue.positions, request.requestId, serviceQueue.count))
+     {
+         poolFree(&requestPool, newNode);
+         free(text);
+         return false;
+     }
+     memcpy(text, request.requestType, typeLength);
+     text[typeLength] = '\0';
+     memcpy(text + typeLength + 1, request.description, descriptionLength);
+     text[typeLength + 1 + descriptionLength] = '\0';
+     newNode->text = text;
+     newNode->requestId = request.requestId;
+     newNode->accountNo = request.accountNo;
+     newNode->priority = request.priority;
+     newNode->submittedAt = request.submittedAt;
+     newNode->rank = requestRank(request.priority, request.submittedAt);
+     serviceQueue.heap[serviceQueue.count++] = newNode;
+     requestSiftUp(serviceQueue.count - 1);
+ 
+     unsigned char record[sizeof(struct RequestRecordHeader) + sizeof(request.requestType) + sizeof(request.description)];
+     logRequestEvent(WAL_REQUEST_ENQUEUE, record, (int)encodeRequest(&request, record));
+ 
+     // Keep IDs unique across reloads
+     if (request.requestId > lastRequestId)
+     {
+         lastRequestId = request.requestId;
+     }
+     return true;
+ }
+ 
+ // The request to serve next, taking priority and time waited into account
+ struct ServiceRequest dequeueRequest()
+ {
+     struct ServiceRequest request = {0};
+     if (serviceQueue.count == 0)
+     {
+         return request;
+     }
+     return removeRequestAt(0);
+ }
+ 
+ // Withdraw a pending request; false if there is none with this ID
+ bool cancelRequest(int requestId, struct ServiceRequest *cancelled)
+ {
+     int pos = idIndexFind(&serviceQueue.positions, requestId);
+     if (pos == -1)
+     {
+         return false;
+     }
+     *cancelled = removeRequestAt(pos);
+     return true;
+ }
+ 
+ bool reprioritizeRequest(int requestId, int priority)
+ {
+     int pos = idIndexFind(&serviceQueue.positions, requestId);
+     if (pos == -1)
+     {
+         return false;
+     }
+     struct RequestNode *node = serviceQueue.heap[pos];
+     long long oldRank = node->rank;
+     node->priority = priority;
+     node->rank = requestRank(priority, node->submittedAt);
+     if (node->rank > oldRank)
+     {
+         requestSiftUp(pos);
+     }
+     else
+     {
+         requestSiftDown(pos);
+     }
+     struct WalRequestPriorityPayload payload = {requestId, priority};
+     logRequestEvent(WAL_REQUEST_PRIORITY, &payload, sizeof(payload));
+     return true;
+ }
+ 
+ // Drop every pending request
+ void clearRequests()
+ {
+     for (int i = 0; i < serviceQueue.count; i++)
+     {
+         free(serviceQueue.heap[i]->text);
+     }
+     serviceQueue.count = 0;
+     idIndexClear(&serviceQueue.positions);
+     poolReset(&requestPool);
+ }
+ 
+ // Graph Operations
+ // Drop every branch and connection
+ void clearBranches()
+ {
+     branchCount = 0;
+     idIndexClear(&branchIndex);
+     poolReset(&edgePool);
+     branchRoutes.stale = true;
+     routeMatrix.stale = true;
+     routeHierarchy.ready = false;
+ }
+ 
+ // Make room for at least capacity branches
+ bool reserveBranches(int capacity)
+ {
+     if (capacity <= branchCapacity)
+     {
+         return true;
+     }
+     int newCapacity = branchCapacity == 0 ? 16 : branchCapacity;
+     while (newCapacity < capacity)
+     {
+         newCapacity *= 2;
+     }
+     struct BranchNode *graph = (struct BranchNode *)realloc(branchGraph, newCapacity * sizeof(struct BranchNode));
+     if (graph == NULL)
+     {
+         return false;
+     }
+     branchGraph = graph;
+     branchCapacity = newCapacity;
+     return true;
+ }
+ 
+ // Returns false if the branch ID is taken or there is no memory
+ bool addBranch(int branchId, char *branchName, char *location, char *managerName, char *phoneNumber, int employeeCount)
+ {
+     if (!reserveBranches(branchCount + 1) || !idIndexInsert(&branchIndex, branchId, branchCount))
+     {
+         return false;
+     }
+ 
+     branchGraph[branchCount].data.branchId = branchId;
+     strcpy(branchGraph[branchCount].data.branchName, branchName);
+     strcpy(branchGraph[branchCount].data.location, location);
+     strcpy(branchGraph[branchCount].data.managerName, managerName);
+     strcpy(branchGraph[branchCount].data.phoneNumber, phoneNumber);
+     branchGraph[branchCount].data.employeeCount = employeeCount;
+     branchGraph[branchCount].connections = NULL;
+     branchCount++;
+     branchRoutes.stale = true;
+     routeMatrix.stale = true;
+     routeHierarchy.ready = false;
+     return true;
+ }
+ 
+ int findBranchIndex(int branchId)
+ {
+     return idIndexFind(&branchIndex, branchId);
+ }
+ // Compile the connection lists into branchRoutes. Connections to branches
+ // that don't exist are left out. Returns false if there is no memory.
+ bool buildBranchRoutes()
+ {
+     int edgeCount = 0;
+     for (int i = 0; i < branchCount; i++)
+     {
+         for (struct EdgeList *edge = branchGraph[i].connections; edge != NULL; edge = edge->next)
+         {
+             edgeCount++;
+         }
+     }
+ 
+     int *offsets = (int *)malloc((branchCount + 1) * sizeof(int));
+     int *targets = (int *)malloc((edgeCount > 0 ? edgeCount : 1) * sizeof(int));
+     float *distances = (float *)malloc((edgeCount > 0 ? edgeCount : 1) * sizeof(float));
+     if (offsets == NULL || targets == NULL || distances == NULL)
+     {
+         free(offsets);
+         free(targets);
+         free(distances);
+         return false;
+     }
+ 
+     int used = 0;
+     for (int i = 0; i < branchCount; i++)
+     {
+         offsets[i] = used;
+         for (struct EdgeList *edge = branchGraph[i].connections; edge != NULL; edge = edge->next)
+         {
+             int targetIndex = findBranchIndex(edge->branchId);
+             if (targetIndex != -1)
+             {
+                 targets[used] = targetIndex;
+                 distances[used] = edge->distance;
+                 used++;
+             }
+         }
+     }
+     offsets[branchCount] = used;
+ 
+     free(branchRoutes.offsets);
+     free(branchRoutes.targets);
+     free(branchRoutes.distances);
+     branchRoutes.offsets = offsets;
+     branchRoutes.targets = targets;
+     branchRoutes.distances = distances;
+     branchRoutes.branchCount = branchCount;
+     branchRoutes.edgeCount = used;
+     branchRoutes.stale = false;
+     return true;
+ }
+ 
+ // Grow a search's scratch space to the compiled graph. Returns false if
+ // there is no memory.
+ bool reserveRouteSearch(struct RouteSearch *search)
+ {
+     if (search->branchCapacity < branchRoutes.branchCount)
+     {
+         int capacity = branchRoutes.branchCount;
+         free(search->labels);
+         free(search->path);
+         free(search->order);
+         free(search->wanted);
+         search->labels = (struct RouteLabel *)calloc(capacity, sizeof(struct RouteLabel));
+         search->path = (int *)malloc(capacity * sizeof(int));
+         search->order = (int *)malloc(capacity * sizeof(int));
+         search->wanted = (unsigned int *)calloc(capacity, sizeof(unsigned int));
+         search->search = 0;
+         if (search->labels == NULL || search->path == NULL || search->order == NULL || search->wanted == NULL)
+         {
+             search->branchCapacity = 0;
+             return false;
+         }
+         search->branchCapacity = capacity;
+     }
+     if (search->heapCapacity < branchRoutes.edgeCount + 1)
+     {
+         int capacity = branchRoutes.edgeCount + 1;
+         free(search->heap);
+         search->heap = (struct RouteHeapEntry *)malloc(capacity * sizeof(struct RouteHeapEntry));
+         if (search->heap == NULL)
+         {
+             search->heapCapacity = 0;
+             return false;
+         }
+         search->heapCapacity = capacity;
+     }
+     return true;
+ }
+ 
+ void routeHeapPush(struct RouteHeapEntry *heap, int *count, float distance, int branch)
+ {
+     int pos = (*count)++;
+     while (pos > 0 && distance < heap[(pos - 1) / 2].distance)
+     {
+         heap[pos] = heap[(pos - 1) / 2];
+         pos = (pos - 1) / 2;
+     }
+     heap[pos].distance = distance;
+     heap[pos].branch = branch;
+ }
+ 
+ struct RouteHeapEntry routeHeapPop(struct RouteHeapEntry *heap, int *count)
+ {
+     struct RouteHeapEntry top = heap[0];
+     struct RouteHeapEntry last = heap[--(*count)];
+     int pos = 0;
+     while (2 * pos + 1 < *count)
+     {
+         int child = 2 * pos + 1;
+         if (child + 1 < *count && heap[child + 1].distance < heap[child].distance)
+         {
+             child++;
+         }
+         if (!(heap[child].distance < last.distance))
+         {
+             break;
+         }
+         heap[pos] = heap[child];
+         pos = child;
+     }
+     heap[pos] = last;
+     return top;
+ }
+ 
+ // Dijkstra's algorithm from a branch index over the compiled graph, which
+ // must be current. Stops once every branch in ends is settled, or runs
+ // until every reachable branch is if endCount is 0. Returns the number of
+ // branches settled, listed in search->order, or -1 if there is no memory.
+ int settleRoutes(struct RouteSearch *search, int startIndex, const int *ends, int endCount)
+ {
+     if (!reserveRouteSearch(search))
+     {
+         return -1;
+     }
+     if (++search->search == 0)
+     {
+         // Numbers wrapped; forget every earlier search
+         memset(search->labels, 0, search->branchCapacity * sizeof(struct RouteLabel));
+         memset(search->wanted, 0, search->branchCapacity * sizeof(unsigned int));
+         search->search = 1;
+     }
+     unsigned int number = search->search;
+     struct RouteLabel *labels = search->labels;
+     int settledCount = 0;
+     int unsettledEnds = 0;
+     for (int i = 0; i < endCount; i++)
+     {
+         if (search->wanted[ends[i]] != number)
+         {
+             search->wanted[ends[i]] = number;
+             unsettledEnds++;
+         }
+     }
+     
+     labels[startIndex].distance = 0.0;
+     labels[startIndex].previous = -1;
+     labels[startIndex].reached = number;
+     int frontier = 0;
+     routeHeapPush(search->heap, &frontier, 0.0f, startIndex);
+     
+     while (frontier > 0)
+     {
+         int current = routeHeapPop(search->heap, &frontier).branch;
+         if (labels[current].settled == number) continue; // Superseded by a shorter distance
+         labels[current].settled = number;
+         search->order[settledCount++] = current;
+         if (endCount > 0 && search->wanted[current] == number && --unsettledEnds == 0)
+         {
+             break; // All settled; nothing can improve on them
+         }
+         
+         // Update distances of adjacent vertices
+         for (int e = branchRoutes.offsets[current]; e < branchRoutes.offsets[current + 1]; e++)
+         {
+             struct RouteLabel *target = &labels[branchRoutes.targets[e]];
+             float newDist = labels[current].distance + branchRoutes.distances[e];
+             if ((target->reached != number || newDist < target->distance) && target->settled != number)
+             {
+                 target->reached = number;
+                 target->distance = newDist;
+                 target->previous = current;
+                 routeHeapPush(search->heap, &frontier, newDist, branchRoutes.targets[e]);
+             }
+         }
+     }
+     return settledCount;
+ }
+ 
+ // Dijkstra's algorithm between two branch indices over the compiled graph,
+ // which must be current. Leaves the branch indices along the way in
+ // search->path, start first, and returns the distance, or FLT_MAX if end
+ // can't be reached.
+ float searchRoute(struct RouteSearch *search, int startIndex, int endIndex, int *pathLength)
+ {
+     *pathLength = 0;
+     if (settleRoutes(search, startIndex, &endIndex, 1) == -1)
+     {
+         return FLT_MAX;
+     }
+     struct RouteLabel *labels = search->labels;
+     
+     if (labels[endIndex].settled != search->search)
+     {
+         return FLT_MAX;
+     }
+     
+     // Walk back from the end, then reverse
+     int *path = search->path;
+     for (int at = endIndex; at != -1; at = labels[at].previous)
+     {
+         path[(*pathLength)++] = at;
+     }
+     for (int i = 0, j = *pathLength - 1; i < j; i++, j--)
+     {
+         int swap = path[i];
+         path[i] = path[j];
+         path[j] = swap;
+     }
+     return labels[endIndex].distance;
+ }
+ 
+ void freeRouteSearch(struct RouteSearch *search)
+ {
+     free(search->labels);
+     free(search->path);
+     free(search->order);
+     free(search->wanted);
+     free(search->heap);
+     memset(search, 0, sizeof(*search));
+ }
+ 
+ // Fill a row of the route matrix from a search that settled every branch
+ // reachable from source
+ void fillRouteMatrixRow(const struct RouteSearch *search, int source, int settledCount)
+ {
+     int n = routeMatrix.branchCount;
+     float *distance = routeMatrix.distance + (size_t)source * n;
+     int *nextHop = routeMatrix.nextHop + (size_t)source * n;
+     for (int i = 0; i < n; i++)
+     {
+         distance[i] = FLT_MAX;
+         nextHop[i] = -1;
+     }
+     // A branch is settled after the one it's reached from, whose first hop
+     // is then already known
+     for (int k = 0; k < settledCount; k++)
+     {
+         int at = search->order[k];
+         int previous = search->labels[at].previous;
+         distance[at] = search->labels[at].distance;
+         nextHop[at] = previous == -1 || previous == source ? at : nextHop[previous];
+     }
+ }
+ 
+ void *runRouteMatrixWorker(void *arg)
+ {
+     struct RouteMatrixWorker *worker = (struct RouteMatrixWorker *)arg;
+     int source;
+     while ((source = atomic_fetch_add(&routeMatrix.nextSource, 1)) < routeMatrix.branchCount)
+     {
+         int settledCount = settleRoutes(&worker->search, source, NULL, 0);
+         if (settledCount == -1)
+         {
+             worker->failed = true;
+             break;
+         }
+         fillRouteMatrixRow(&worker->search, source, settledCount);
+     }
+     return NULL;
+ }
+ 
+ // Fill the route matrix with a Dijkstra search from every branch, handed
+ // out to workerCount threads. Returns false if there is no memory.
+ bool buildRouteMatrix(int workerCount)
+ {
+     if (branchRoutes.stale && !buildBranchRoutes())
+     {
+         return false;
+     }
+     int n = branchCount;
+     if (routeMatrix.distance == NULL || routeMatrix.branchCount != n)
+     {
+         free(routeMatrix.distance);
+         free(routeMatrix.nextHop);
+         free(routeMatrix.path);
+         size_t cells = n > 0 ? (size_t)n * n : 1;
+         routeMatrix.distance = (float *)malloc(cells * sizeof(float));
+         routeMatrix.nextHop = (int *)malloc(cells * sizeof(int));
+         routeMatrix.path = (int *)malloc((n > 0 ? n : 1) * sizeof(int));
+         routeMatrix.branchCount = n;
+         if (routeMatrix.distance == NULL || routeMatrix.nextHop == NULL || routeMatrix.path == NULL)
+         {
+             free(routeMatrix.distance);
+             free(routeMatrix.nextHop);
+             free(routeMatrix.path);
+             routeMatrix.distance = NULL;
+             routeMatrix.nextHop = NULL;
+             routeMatrix.path = NULL;
+             routeMatrix.branchCount = 0;
+             return false;
+         }
+     }
+ 
+     if (workerCount > ROUTE_MATRIX_MAX_WORKERS)
+     {
+         workerCount = ROUTE_MATRIX_MAX_WORKERS;
+     }
+     // Threads cost more than small graphs
+     if (workerCount > n / 64 + 1)
+     {
+         workerCount = n / 64 + 1;
+     }
+     if (workerCount < 1)
+     {
+         workerCount = 1;
+     }
+     struct RouteMatrixWorker workers[ROUTE_MATRIX_MAX_WORKERS];
+     memset(workers, 0, workerCount * sizeof(struct RouteMatrixWorker));
+     atomic_store(&routeMatrix.nextSource, 0);
+ 
+     // This thread is worker 0
+     int started = 1;
+     while (started < workerCount)
+     {
+         struct RouteMatrixWorker *worker = &workers[started];
+         worker->start = (struct ThreadStart){runRouteMatrixWorker, worker};
+         if (!startThread(&worker->thread, &worker->start))
+         {
+             break;
+         }
+         started++;
+     }
+     runRouteMatrixWorker(&workers[0]);
+ 
+     bool failed = false;
+     for (int i = 0; i < started; i++)
+     {
+         if (i > 0)
+         {
+             joinThread(workers[i].thread);
+         }
+         failed = failed || workers[i].failed;
+         freeRouteSearch(&workers[i].search);
+     }
+     routeMatrix.stale = failed;
+     return !failed;
+ }
+ 
+ // A connection from sourceIndex to targetIndex was added. Routes through it
+ // that beat the known ones replace them; nothing gets longer, so this is
+ // all the matrix needs.
+ void relaxRouteMatrix(int sourceIndex, int targetIndex, float distance)
+ {
+     int n = routeMatrix.branchCount;
+     const float *fromTarget = routeMatrix.distance + (size_t)targetIndex * n;
+     for (int i = 0; i < n; i++)
+     {
+         float *row = routeMatrix.distance + (size_t)i * n;
+         int *hops = routeMatrix.nextHop + (size_t)i * n;
+         if (row[sourceIndex] == FLT_MAX)
+         {
+             continue;
+         }
+         float viaEdge = row[sourceIndex] + distance;
+         if (!(viaEdge < row[targetIndex]))
+         {
+             continue; // Doesn't get to the target sooner, so nothing past it either
+         }
+         int firstHop = i == sourceIndex ? targetIndex : hops[sourceIndex];
+         for (int j = 0; j < n; j++)
+         {
+             if (fromTarget[j] != FLT_MAX && viaEdge + fromTarget[j] < row[j])
+             {
+                 row[j] = viaEdge + fromTarget[j];
+                 hops[j] = firstHop;
+             }
+         }
+     }
+ }
+ 
+ // Follow the matrix's first hops from start to end, which must be
+ // reachable, into path, which has room for every branch. Returns false if
+ // the hops don't lead there, possible with ties over zero-length links.
+ bool walkRouteMatrix(int startIndex, int endIndex, int *path, int *pathLength)
+ {
+     int n = routeMatrix.branchCount;
+     *pathLength = 0;
+     for (int at = startIndex; at != endIndex; at = routeMatrix.nextHop[(size_t)at * n + endIndex])
+     {
+         if (at == -1 || *pathLength == n)
+         {
+             return false;
+         }
+         path[(*pathLength)++] = at;
+     }
+     path[(*pathLength)++] = endIndex;
+     return true;
+ }
+ 
+ // Answer a route from the matrix, building it first if needed. Leaves the
+ // path in routeMatrix.path. Returns false if the matrix isn't kept for
+ // this network or can't be built, leaving the route to Dijkstra.
+ bool matrixRoute(int startIndex, int endIndex, float *distance, int *pathLength)
+ {
+     *pathLength = 0;
+     if (!routeMatrix.enabled || branchCount > ROUTE_MATRIX_MAX_BRANCHES)
+     {
+         return false;
+     }
+     if (routeMatrix.stale && !buildRouteMatrix(processorCount()))
+     {
+         return false;
+     }
+     *distance = routeMatrix.distance[(size_t)startIndex * routeMatrix.branchCount + endIndex];
+     return *distance == FLT_MAX || walkRouteMatrix(startIndex, endIndex, routeMatrix.path, pathLength);
+ }
+ 
+ // Route searches need link distances that are finite and not negative;
+ // NaN fails both comparisons
+ bool validLinkDistance(float distance)
+ {
+     return distance >= 0.0f && distance <= FLT_MAX;
+ }
+ 
+ // Add a link from one branch to another. Returns false if the source
+ // branch doesn't exist, the distance isn't one routes can use, or there is
+ // no memory.
+ bool addConnection(int sourceBranchId, int targetBranchId, float distance)
+ {
+     int sourceIndex = findBranchIndex(sourceBranchId);
+ 
+     if (sourceIndex == -1 || !validLinkDistance(distance))
+     {
+         return false;
+     }
+ 
+     // Create new connection
+     struct EdgeList *newEdge = (struct EdgeList *)poolAlloc(&edgePool);
+     if (newEdge == NULL)
+     {
+         return false;
+     }
+     newEdge->branchId = targetBranchId;
+     newEdge->distance = distance;
+     newEdge->next = branchGraph[sourceIndex].connections;
+     branchGraph[sourceIndex].connections = newEdge;
+     branchRoutes.stale = true;
+     routeHierarchy.ready = false;
+ 
+     int targetIndex = findBranchIndex(targetBranchId);
+     if (!routeMatrix.stale && targetIndex != -1)
+     {
+         relaxRouteMatrix(sourceIndex, targetIndex, distance);
+     }
+     return true;
+ }
+ 
+ // Route Hierarchy
+ // Add a link to a list, or shorten the one to the same branch
+ void hierarchyArcAdd(struct HierarchyBuilder *builder, struct HierarchyArcList *list, int node, float distance, int middle)
+ {
+     for (int i = 0; i < list->count; i++)
+     {
+         if (list->arcs[i].node == node)
+         {
+             if (distance < list->arcs[i].distance)
+             {
+                 list->arcs[i].distance = distance;
+                 list->arcs[i].middle = middle;
+             }
+             return;
+         }
+     }
+     if (list->count == list->capacity)
+     {
+         int capacity = list->capacity == 0 ? 4 : list->capacity * 2;
+         struct HierarchyArc *arcs = (struct HierarchyArc *)realloc(list->arcs, capacity * sizeof(struct HierarchyArc));
+         if (arcs == NULL)
+         {
+             builder->failed = true;
+             return;
+         }
+         list->arcs = arcs;
+         list->capacity = capacity;
+     }
+     list->arcs[list->count].node = node;
+     list->arcs[list->count].distance = distance;
+     list->arcs[list->count].middle = middle;
+     list->count++;
+ }
+ 
+ void hierarchyLink(struct HierarchyBuilder *builder, int from, int to, float distance, int middle)
+ {
+     if (from != to)
+     {
+         hierarchyArcAdd(builder, &builder->out[from], to, distance, middle);
+         hierarchyArcAdd(builder, &builder->in[to], from, distance, middle);
+     }
+ }
+ 
+ void hierarchyArcRemove(struct HierarchyArcList *list, int node)
+ {
+     for (int i = 0; i < list->count; i++)
+     {
+         if (list->arcs[i].node == node)
+         {
+             list->arcs[i] = list->arcs[--list->count];
+             return;
+         }
+     }
+ }
+ 
+ // Distances from source over the branches not yet contracted, avoiding
+ // skip, out to limit. Stops once the wanted branches are all settled, or
+ // after settling settleLimit branches. A distance only counts where reached
+ // matches the builder's search number.
+ void witnessSearch(struct HierarchyBuilder *builder, int source, int skip, float limit, int wanted, int settleLimit)
+ {
+     unsigned int number = builder->search;
+     builder->distance[source] = 0.0f;
+     builder->reached[source] = number;
+     int frontier = 0;
+     routeHeapPush(builder->heap, &frontier, 0.0f, source);
+ 
+     int settled = 0;
+     while (frontier > 0 && settled < settleLimit && wanted > 0)
+     {
+         struct RouteHeapEntry top = routeHeapPop(builder->heap, &frontier);
+         if (top.distance > builder->distance[top.branch])
+         {
+             continue; // Superseded by a shorter distance
+         }
+         if (top.distance > limit)
+         {
+             break;
+         }
+         settled++;
+         if (builder->wanted[top.branch] == number)
+         {
+             builder->wanted[top.branch] = 0;
+             wanted--;
+         }
+         const struct HierarchyArcList *out = &builder->out[top.branch];
+         for (int i = 0; i < out->count; i++)
+         {
+             int node = out->arcs[i].node;
+             float distance = top.distance + out->arcs[i].distance;
+             if (node == skip || (builder->reached[node] == number && !(distance < builder->distance[node])))
+             {
+                 continue;
+             }
+             if (frontier == builder->heapCapacity)
+             {
+                 struct RouteHeapEntry *heap = (struct RouteHeapEntry *)realloc(builder->heap, 2 * builder->heapCapacity * sizeof(struct RouteHeapEntry));
+                 if (heap == NULL)
+                 {
+                     return; // A shorter search only means more shortcuts
+                 }
+                 builder->heap = heap;
+                 builder->heapCapacity *= 2;
+             }
+             builder->reached[node] = number;
+             builder->distance[node] = distance;
+             routeHeapPush(builder->heap, &frontier, distance, node);
+         }
+     }
+ }
+ 
+ // Contracting branch v needs a shortcut from each branch linking to it to
+ // each branch it links to, unless a route avoiding v is as short. Returns
+ // how many, adding them if apply is set.
+ int contractBranch(struct HierarchyBuilder *builder, int v, bool apply)
+ {
+     const struct HierarchyArcList *in = &builder->in[v];
+     const struct HierarchyArcList *out = &builder->out[v];
+     int shortcuts = 0;
+     for (int i = 0; i < in->count && out->count > 0; i++)
+     {
+         int from = in->arcs[i].node;
+         if (++builder->search == 0)
+         {
+             memset(builder->reached, 0, branchRoutes.branchCount * sizeof(unsigned int));
+             memset(builder->wanted, 0, branchRoutes.branchCount * sizeof(unsigned int));
+             builder->search = 1;
+         }
+         float limit = 0.0f;
+         int wanted = 0;
+         for (int j = 0; j < out->count; j++)
+         {
+             float via = in->arcs[i].distance + out->arcs[j].distance;
+             if (out->arcs[j].node != from)
+             {
+                 limit = via > limit ? via : limit;
+                 builder->wanted[out->arcs[j].node] = builder->search;
+                 wanted++;
+             }
+         }
+         witnessSearch(builder, from, v, limit, wanted, apply ? HIERARCHY_WITNESS_LIMIT : HIERARCHY_ESTIMATE_LIMIT);
+         for (int j = 0; j < out->count; j++)
+         {
+             int to = out->arcs[j].node;
+             float via = in->arcs[i].distance + out->arcs[j].distance;
+             if (to == from || (builder->reached[to] == builder->search && builder->distance[to] <= via))
+             {
+                 continue;
+             }
+             shortcuts++;
+             if (apply)
+             {
+                 hierarchyLink(builder, from, to, via, v);
+             }
+         }
+     }
+     return shortcuts;
+ }
+ 
+ // Branches that add the fewest links by going next go first; spreading
+ // out from the ones already contracted keeps the hierarchy shallow
+ float contractionPriority(struct HierarchyBuilder *builder, int v)
+ {
+     int removed = builder->in[v].count + builder->out[v].count;
+     return (float)(2 * (contractBranch(builder, v, false) - removed) + builder->contractedNeighbours[v] + builder->level[v]);
+ }
+ 
+ void freeRouteHierarchy()
+ {
+     free(routeHierarchy.rank);
+     free(routeHierarchy.upOffsets);
+     free(routeHierarchy.upArcs);
+     free(routeHierarchy.downOffsets);
+     free(routeHierarchy.downArcs);
+     memset(&routeHierarchy, 0, sizeof(routeHierarchy));
+ }
+ 
+ // Gather a list per branch into offsets and one array of links
+ bool packHierarchyArcs(const struct HierarchyArcList *lists, int n, int **offsets, struct HierarchyArc **arcs, int *count)
+ {
+     *count = 0;
+     for (int i = 0; i < n; i++)
+     {
+         *count += lists[i].count;
+     }
+     *offsets = (int *)malloc((n + 1) * sizeof(int));
+     *arcs = (struct HierarchyArc *)malloc((*count > 0 ? *count : 1) * sizeof(struct HierarchyArc));
+     if (*offsets == NULL || *arcs == NULL)
+     {
+         free(*offsets);
+         free(*arcs);
+         *offsets = NULL;
+         *arcs = NULL;
+         return false;
+     }
+     int used = 0;
+     for (int i = 0; i < n; i++)
+     {
+         (*offsets)[i] = used;
+         if (lists[i].count > 0)
+         {
+             memcpy(*arcs + used, lists[i].arcs, lists[i].count * sizeof(struct HierarchyArc));
+         }
+         used += lists[i].count;
+     }
+     (*offsets)[n] = used;
+     return true;
+ }
+ 
+ // Rank every branch and add the shortcuts routes need to only go up, then
+ // down. Returns false if there is no memory; routes then keep using
+ // Dijkstra.
+ bool buildRouteHierarchy()
+ {
+     if (branchRoutes.stale && !buildBranchRoutes())
+     {
+         return false;
+     }
+     int n = branchRoutes.branchCount;
+     struct HierarchyBuilder builder = {0};
+     builder.out = (struct HierarchyArcList *)calloc(n + 1, sizeof(struct HierarchyArcList));
+     builder.in = (struct HierarchyArcList *)calloc(n + 1, sizeof(struct HierarchyArcList));
+     builder.contracted = (bool *)calloc(n + 1, sizeof(bool));
+     builder.contractedNeighbours = (int *)calloc(n + 1, sizeof(int));
+     builder.level = (int *)calloc(n + 1, sizeof(int));
+     builder.distance = (float *)malloc((n + 1) * sizeof(float));
+     builder.reached = (unsigned int *)calloc(n + 1, sizeof(unsigned int));
+     builder.wanted = (unsigned int *)calloc(n + 1, sizeof(unsigned int));
+     builder.heapCapacity = 256;
+     builder.heap = (struct RouteHeapEntry *)malloc(builder.heapCapacity * sizeof(struct RouteHeapEntry));
+     struct RouteHeapEntry *queue = (struct RouteHeapEntry *)malloc((n + 1) * sizeof(struct RouteHeapEntry));
+     int *rank = (int *)malloc((n + 1) * sizeof(int));
+     builder.failed = builder.out == NULL || builder.in == NULL || builder.contracted == NULL ||
+                      builder.contractedNeighbours == NULL || builder.level == NULL || builder.distance == NULL || builder.reached == NULL ||
+                      builder.wanted == NULL ||
+                      builder.heap == NULL || queue == NULL || rank == NULL;
+ 
+     for (int u = 0; u < n && !builder.failed; u++)
+     {
+         for (int e = branchRoutes.offsets[u]; e < branchRoutes.offsets[u + 1]; e++)
+         {
+             hierarchyLink(&builder, u, branchRoutes.targets[e], branchRoutes.distances[e], -1);
+         }
+     }
+     int queued = 0;
+     for (int v = 0; v < n && !builder.failed; v++)
+     {
+         routeHeapPush(queue, &queued, contractionPriority(&builder, v), v);
+     }
+ 
+     int contracted = 0;
+     while (queued > 0 && !builder.failed)
+     {
+         int v = routeHeapPop(queue, &queued).branch;
+         // Priorities go stale as neighbours are contracted; check this one
+         // again before going ahead
+         float priority = contractionPriority(&builder, v);
+         if (queued > 0 && priority > queue[0].distance)
+         {
+             routeHeapPush(queue, &queued, priority, v);
+             continue;
+         }
+         contractBranch(&builder, v, true);
+         builder.contracted[v] = true;
+         rank[v] = contracted++;
+         // v's lists now hold exactly its links to higher-ranked branches
+         for (int i = 0; i < builder.out[v].count; i++)
+         {
+             int node = builder.out[v].arcs[i].node;
+             hierarchyArcRemove(&builder.in[node], v);
+             builder.contractedNeighbours[node]++;
+             builder.level[node] = builder.level[v] + 1 > builder.level[node] ? builder.level[v] + 1 : builder.level[node];
+         }
+         for (int i = 0; i < builder.in[v].count; i++)
+         {
+             int node = builder.in[v].arcs[i].node;
+             hierarchyArcRemove(&builder.out[node], v);
+             builder.contractedNeighbours[node]++;
+             builder.level[node] = builder.level[v] + 1 > builder.level[node] ? builder.level[v] + 1 : builder.level[node];
+         }
+     }
+ 
+     int *upOffsets = NULL, *downOffsets = NULL;
+     struct HierarchyArc *upArcs = NULL, *downArcs = NULL;
+     int upCount = 0, downCount = 0;
+     bool built = !builder.failed && packHierarchyArcs(builder.out, n, &upOffsets, &upArcs, &upCount) &&
+                  packHierarchyArcs(builder.in, n, &downOffsets, &downArcs, &downCount);
+ 
+     for (int i = 0; i < n && builder.out != NULL && builder.in != NULL; i++)
+     {
+         free(builder.out[i].arcs);
+         free(builder.in[i].arcs);
+     }
+     free(builder.out);
+     free(builder.in);
+     free(builder.contracted);
+     free(builder.contractedNeighbours);
+     free(builder.level);
+     free(builder.distance);
+     free(builder.reached);
+     free(builder.wanted);
+     free(builder.heap);
+     free(queue);
+ 
+     freeRouteHierarchy();
+     if (!built)
+     {
+         free(rank);
+         free(upOffsets);
+         free(upArcs);
+         free(downOffsets);
+         free(downArcs);
+         return false;
+     }
+     routeHierarchy.rank = rank;
+     routeHierarchy.upOffsets = upOffsets;
+     routeHierarchy.upArcs = upArcs;
+     routeHierarchy.downOffsets = downOffsets;
+     routeHierarchy.downArcs = downArcs;
+     routeHierarchy.branchCount = n;
+     routeHierarchy.upCount = upCount;
+     routeHierarchy.downCount = downCount;
+     routeHierarchy.ready = true;
+     return true;
+ }
+ 
+ bool reserveHierarchySearch(struct HierarchySearch *search)
+ {
+     if (search->branchCapacity < routeHierarchy.branchCount)
+     {
+         int capacity = routeHierarchy.branchCount;
+         free(search->labels[0]);
+         free(search->labels[1]);
+         free(search->path);
+         free(search->climb);
+         search->labels[0] = (struct HierarchyLabel *)calloc(capacity, sizeof(struct HierarchyLabel));
+         search->labels[1] = (struct HierarchyLabel *)calloc(capacity, sizeof(struct HierarchyLabel));
+         search->path = (int *)malloc(capacity * sizeof(int));
+         search->climb = (int *)malloc(capacity * sizeof(int));
+         search->search = 0;
+         if (search->labels[0] == NULL || search->labels[1] == NULL || search->path == NULL || search->climb == NULL)
+         {
+             search->branchCapacity = 0;
+             return false;
+         }
+         search->branchCapacity = capacity;
+     }
+     int needed[2] = {routeHierarchy.upCount + 1, routeHierarchy.downCount + 1};
+     for (int side = 0; side < 2; side++)
+     {
+         if (search->heapCapacity[side] < needed[side])
+         {
+             free(search->heap[side]);
+             search->heap[side] = (struct RouteHeapEntry *)malloc(needed[side] * sizeof(struct RouteHeapEntry));
+             if (search->heap[side] == NULL)
+             {
+                 search->heapCapacity[side] = 0;
+                 return false;
+             }
+             search->heapCapacity[side] = needed[side];
+         }
+     }
+     return true;
+ }
+ 
+ void freeHierarchySearch(struct HierarchySearch *search)
+ {
+     for (int side = 0; side < 2; side++)
+     {
+         free(search->labels[side]);
+         free(search->heap[side]);
+     }
+     free(search->path);
+     free(search->climb);
+     memset(search, 0, sizeof(*search));
+ }
+ 
+ const struct HierarchyArc *findHierarchyArc(const int *offsets, const struct HierarchyArc *arcs, int at, int node)
+ {
+     for (int e = offsets[at]; e < offsets[at + 1]; e++)
+     {
+         if (arcs[e].node == node)
+         {
+             return &arcs[e];
+         }
+     }
+     return NULL;
+ }
+ 
+ // Append the branches after from along a link, ending with to. A shortcut
+ // is the link into its middle branch, from that branch's downward list,
+ // and the one out of it, from its upward list.
+ bool unpackHierarchyArc(struct HierarchySearch *search, int from, int to, int middle, int *pathLength)
+ {
+     if (middle == -1)
+     {
+         if (*pathLength == routeHierarchy.branchCount)
+         {
+             return false;
+         }
+         search->path[(*pathLength)++] = to;
+         return true;
+     }
+     const struct HierarchyArc *first = findHierarchyArc(routeHierarchy.downOffsets, routeHierarchy.downArcs, middle, from);
+     const struct HierarchyArc *second = findHierarchyArc(routeHierarchy.upOffsets, routeHierarchy.upArcs, middle, to);
+     return first != NULL && second != NULL && unpackHierarchyArc(search, from, middle, first->middle, pathLength) &&
+            unpackHierarchyArc(search, middle, to, second->middle, pathLength);
+ }
+ 
+ // Route between two branch indices through the hierarchy, which must be
+ // ready: searches up from both ends, alternating, until neither side can
+ // beat the best meeting point. Leaves the path in search->path. Returns
+ // false if there is no memory or the path doesn't unpack, leaving the
+ // route to Dijkstra.
+ bool hierarchyRoute(struct HierarchySearch *search, int startIndex, int endIndex, float *distance, int *pathLength)
+ {
+     *pathLength = 0;
+     if (!reserveHierarchySearch(search))
+     {
+         return false;
+     }
+     if (++search->search == 0)
+     {
+         memset(search->labels[0], 0, search->branchCapacity * sizeof(struct HierarchyLabel));
+         memset(search->labels[1], 0, search->branchCapacity * sizeof(struct HierarchyLabel));
+         search->search = 1;
+     }
+     unsigned int number = search->search;
+     const int *offsets[2] = {routeHierarchy.upOffsets, routeHierarchy.downOffsets};
+     const struct HierarchyArc *arcs[2] = {routeHierarchy.upArcs, routeHierarchy.downArcs};
+     int ends[2] = {startIndex, endIndex};
+     int frontier[2] = {0, 0};
+     for (int side = 0; side < 2; side++)
+     {
+         struct HierarchyLabel *label = &search->labels[side][ends[side]];
+         label->distance = 0.0f;
+         label->parent = -1;
+         label->arc = -1;
+         label->reached = number;
+         routeHeapPush(search->heap[side], &frontier[side], 0.0f, ends[side]);
+     }
+     float best = startIndex == endIndex ? 0.0f : FLT_MAX;
+     int meet = startIndex == endIndex ? startIndex : -1;
+ 
+     while (true)
+     {
+         float nearest[2];
+         for (int side = 0; side < 2; side++)
+         {
+             nearest[side] = frontier[side] > 0 ? search->heap[side][0].distance : FLT_MAX;
+         }
+         if (!(nearest[0] < best) && !(nearest[1] < best))
+         {
+             break;
+         }
+         int side = nearest[0] <= nearest[1] ? 0 : 1;
+         struct HierarchyLabel *labels = search->labels[side];
+         const struct HierarchyLabel *other = search->labels[1 - side];
+         int current = routeHeapPop(search->heap[side], &frontier[side]).branch;
+         if (labels[current].settled == number) continue; // Superseded by a shorter distance
+         labels[current].settled = number;
+ 
+         // A higher branch this side has reached may get here for less
+         // through a link of the other direction; then no shortest route
+         // climbs on from here, and the branch isn't expanded
+         bool stalled = false;
+         for (int e = offsets[1 - side][current]; e < offsets[1 - side][current + 1] && !stalled; e++)
+         {
+             int node = arcs[1 - side][e].node;
+             stalled = labels[node].reached == number &&
+                       labels[node].distance + arcs[1 - side][e].distance < labels[current].distance;
+         }
+         if (stalled)
+         {
+             continue;
+         }
+ 
+         for (int e = offsets[side][current]; e < offsets[side][current + 1]; e++)
+         {
+             int node = arcs[side][e].node;
+             float newDist = labels[current].distance + arcs[side][e].distance;
+             if ((labels[node].reached == number && !(newDist < labels[node].distance)) || labels[node].settled == number)
+             {
+                 continue;
+             }
+             labels[node].reached = number;
+             labels[node].distance = newDist;
+             labels[node].parent = current;
+             labels[node].arc = e;
+             routeHeapPush(search->heap[side], &frontier[side], newDist, node);
+             if (other[node].reached == number && newDist + other[node].distance < best)
+             {
+                 best = newDist + other[node].distance;
+                 meet = node;
+             }
+         }
+     }
+     *distance = best;
+     if (meet == -1)
+     {
+         return true; // No route
+     }
+ 
+     // Up from the start to the meeting point, then down to the end
+     const struct HierarchyLabel *up = search->labels[0];
+     const struct HierarchyLabel *down = search->labels[1];
+     int climbed = 0;
+     for (int at = meet; at != startIndex; at = up[at].parent)
+     {
+         search->climb[climbed++] = at;
+     }
+     search->path[(*pathLength)++] = startIndex;
+     for (int i = climbed - 1; i >= 0; i--)
+     {
+         int at = search->climb[i];
+         if (!unpackHierarchyArc(search, up[at].parent, at, routeHierarchy.upArcs[up[at].arc].middle, pathLength))
+         {
+             return false;
+         }
+     }
+     for (int at = meet; at != endIndex; at = down[at].parent)
+     {
+         if (!unpackHierarchyArc(search, at, down[at].parent, routeHierarchy.downArcs[down[at].arc].middle, pathLength))
+         {
+             return false;
+         }
+     }
+     return true;
+ }
+ 
+ // Shortest route between two branch indices. path is left pointing at the
+ // branch indices along the way, valid until the next call.
+ float shortestPath(int startIndex, int endIndex, const int **path, int *pathLength)
+ {
+     float distance;
+     if (matrixRoute(startIndex, endIndex, &distance, pathLength))
+     {
+         *path = routeMatrix.path;
+         return distance;
+     }
+     if (routeHierarchy.ready && hierarchyRoute(&hierarchySearch, startIndex, endIndex, &distance, pathLength))
+     {
+         *path = hierarchySearch.path;
+         return distance;
+     }
+     *path = NULL;
+     if (branchRoutes.stale && !buildBranchRoutes())
+     {
+         return FLT_MAX;
+     }
+     distance = searchRoute(&routeSearch, startIndex, endIndex, pathLength);
+     *path = routeSearch.path;
+     return distance;
+ }
+ 
+ // Room for count more branches at the end of a worker's paths. Returns
+ // NULL if there is no memory.
+ int *reserveBatchPath(struct RouteBatchWorker *worker, int count)
+ {
+     if (worker->paths == NULL || worker->pathsCapacity - worker->pathsUsed < (size_t)count)
+     {
+         size_t capacity = worker->pathsCapacity > 0 ? worker->pathsCapacity : 1024;
+         while (capacity - worker->pathsUsed < (size_t)count)
+         {
+             capacity *= 2;
+         }
+         int *paths = (int *)realloc(worker->paths, capacity * sizeof(int));
+         if (paths == NULL)
+         {
+             return NULL;
+         }
+         worker->paths = paths;
+         worker->pathsCapacity = capacity;
+     }
+     return worker->paths + worker->pathsUsed;
+ }
+ 
+ // Answer a query with the path just written at the end of the worker's
+ // paths
+ void keepBatchRoute(struct RouteBatchWorker *worker, int query, float distance, int pathLength)
+ {
+     struct RouteQuery *route = &worker->batch->queries[query];
+     route->distance = distance;
+     route->pathLength = pathLength;
+     worker->batch->pathStart[query] = worker->pathsUsed;
+     worker->pathsUsed += pathLength;
+ }
+ 
+ // Answer a query from the worker's last search, which settled its end if
+ // the end can be reached
+ bool keepSearchedRoute(struct RouteBatchWorker *worker, int query, int endIndex)
+ {
+     const struct RouteLabel *labels = worker->search.labels;
+     if (labels[endIndex].settled != worker->search.search)
+     {
+         keepBatchRoute(worker, query, FLT_MAX, 0);
+         return true;
+     }
+     int pathLength = 0;
+     for (int at = endIndex; at != -1; at = labels[at].previous)
+     {
+         pathLength++;
+     }
+     int *path = reserveBatchPath(worker, pathLength);
+     if (path == NULL)
+     {
+         return false;
+     }
+     int i = pathLength;
+     for (int at = endIndex; at != -1; at = labels[at].previous)
+     {
+         path[--i] = at;
+     }
+     keepBatchRoute(worker, query, labels[endIndex].distance, pathLength);
+     return true;
+ }
+ 
+ // Answer a group of a batch, whose queries all start at the same branch.
+ // Queries the matrix or hierarchy can't answer share one search that stops
+ // once all their ends are settled. Returns false if there is no memory.
+ bool answerRouteGroup(struct RouteBatchWorker *worker, int group)
+ {
+     struct RouteBatch *batch = worker->batch;
+     int first = batch->groups[group];
+     int size = batch->groups[group + 1] - first;
+     int startIndex = batch->queries[batch->order[first]].startIndex;
+     bool searched = false;
+     for (int i = first; i < first + size; i++)
+     {
+         int query = batch->order[i];
+         int endIndex = batch->ends[i];
+         float distance;
+         int pathLength;
+         if (batch->useMatrix)
+         {
+             distance = routeMatrix.distance[(size_t)startIndex * routeMatrix.branchCount + endIndex];
+             int *path = reserveBatchPath(worker, routeMatrix.branchCount);
+             if (path == NULL)
+             {
+                 return false;
+             }
+             if (distance == FLT_MAX || walkRouteMatrix(startIndex, endIndex, path, &pathLength))
+             {
+                 keepBatchRoute(worker, query, distance, distance == FLT_MAX ? 0 : pathLength);
+                 continue;
+             }
+         }
+         else if (batch->useHierarchy && size <= ROUTE_BATCH_HIERARCHY_LIMIT &&
+                  hierarchyRoute(&worker->hierarchy, startIndex, endIndex, &distance, &pathLength))
+         {
+             int *path = reserveBatchPath(worker, pathLength);
+             if (path == NULL)
+             {
+                 return false;
+             }
+             memcpy(path, worker->hierarchy.path, pathLength * sizeof(int));
+             keepBatchRoute(worker, query, distance, pathLength);
+             continue;
+         }
+         if (!searched)
+         {
+             if (settleRoutes(&worker->search, startIndex, batch->ends + first, size) == -1)
+             {
+                 return false;
+             }
+             searched = true;
+         }
+         if (!keepSearchedRoute(worker, query, endIndex))
+         {
+             return false;
+         }
+     }
+     return true;
+ }
+ 
+ void *runRouteBatchWorker(void *arg)
+ {
+     struct RouteBatchWorker *worker = (struct RouteBatchWorker *)arg;
+     struct RouteBatch *batch = worker->batch;
+     int group;
+     while ((group = atomic_fetch_add(&batch->nextGroup, 1)) < batch->groupCount)
+     {
+         batch->groupWorker[group] = worker->number;
+         if (!answerRouteGroup(worker, group))
+         {
+             worker->failed = true;
+             break;
+         }
+     }
+     return NULL;
+ }
+ 
+ void freeRouteBatch(struct RouteBatch *batch)
+ {
+     free(batch->order);
+     free(batch->ends);
+     free(batch->groups);
+     free(batch->groupWorker);
+     free(batch->pathStart);
+     free(batch->paths);
+     batch->order = NULL;
+     batch->ends = NULL;
+     batch->groups = NULL;
+     batch->groupWorker = NULL;
+     batch->pathStart = NULL;
+     batch->paths = NULL;
+ }
+ 
+ // Plan a batch of routes between branch indices on up to workerCount
+ // threads. Queries are grouped by start branch and the groups handed out
+ // to the threads, so each start is searched from once. The paths stay
+ // valid until freeRouteBatch. Returns false if there is no memory.
+ bool planRoutes(struct RouteBatch *batch, struct RouteQuery *queries, int count, int workerCount)
+ {
+     memset(batch, 0, sizeof(*batch));
+     batch->queries = queries;
+     batch->count = count;
+     if (branchRoutes.stale && !buildBranchRoutes())
+     {
+         return false;
+     }
+     batch->useMatrix = routeMatrix.enabled && branchCount <= ROUTE_MATRIX_MAX_BRANCHES &&
+                        (!routeMatrix.stale || buildRouteMatrix(workerCount));
+     batch->useHierarchy = routeHierarchy.ready;
+ 
+     // Counting sort on the start branch; starts[b] becomes where b's
+     // queries begin
+     int *starts = (int *)calloc(branchCount + 1, sizeof(int));
+     batch->order = (int *)malloc((count + 1) * sizeof(int));
+     batch->ends = (int *)malloc((count + 1) * sizeof(int));
+     batch->groups = (int *)malloc((count + 1) * sizeof(int));
+     batch->groupWorker = (int *)malloc((count + 1) * sizeof(int));
+     batch->pathStart = (size_t *)malloc((count + 1) * sizeof(size_t));
+     if (starts == NULL || batch->order == NULL || batch->ends == NULL || batch->groups == NULL ||
+         batch->groupWorker == NULL || batch->pathStart == NULL)
+     {
+         free(starts);
+         freeRouteBatch(batch);
+         return false;
+     }
+     for (int q = 0; q < count; q++)
+     {
+         if (queries[q].startIndex == -1 || queries[q].endIndex == -1)
+         {
+             queries[q].distance = FLT_MAX; // Names no branch
+             queries[q].path = NULL;
+             queries[q].pathLength = 0;
+             continue;
+         }
+         starts[queries[q].startIndex + 1]++;
+     }
+     for (int b = 0; b < branchCount; b++)
+     {
+         if (starts[b + 1] > 0)
+         {
+             batch->groups[batch->groupCount++] = starts[b];
+         }
+         starts[b + 1] += starts[b];
+     }
+     batch->groups[batch->groupCount] = starts[branchCount];
+     for (int q = 0; q < count; q++)
+     {
+         if (queries[q].startIndex == -1 || queries[q].endIndex == -1)
+         {
+             continue;
+         }
+         int at = starts[queries[q].startIndex]++;
+         batch->order[at] = q;
+         batch->ends[at] = queries[q].endIndex;
+     }
+     free(starts);
+ 
+     if (workerCount > ROUTE_BATCH_MAX_WORKERS)
+     {
+         workerCount = ROUTE_BATCH_MAX_WORKERS;
+     }
+     if (workerCount > batch->groupCount)
+     {
+         workerCount = batch->groupCount;
+     }
+     // Answers from the matrix cost less than starting a thread
+     if (batch->useMatrix && workerCount > count / 1024 + 1)
+     {
+         workerCount = count / 1024 + 1;
+     }
+     if (workerCount < 1)
+     {
+         workerCount = 1;
+     }
+     struct RouteBatchWorker workers[ROUTE_BATCH_MAX_WORKERS];
+     memset(workers, 0, workerCount * sizeof(struct RouteBatchWorker));
+     atomic_store(&batch->nextGroup, 0);
+ 
+     // This thread is worker 0
+     workers[0].batch = batch;
+     int started = 1;
+     while (started < workerCount)
+     {
+         struct RouteBatchWorker *worker = &workers[started];
+         worker->batch = batch;
+         worker->number = started;
+         worker->start = (struct ThreadStart){runRouteBatchWorker, worker};
+         if (!startThread(&worker->thread, &worker->start))
+         {
+             break;
+         }
+         started++;
+     }
+     runRouteBatchWorker(&workers[0]);
+ 
+     bool failed = false;
+     size_t pathBase[ROUTE_BATCH_MAX_WORKERS];
+     size_t pathsUsed = 0;
+     for (int i = 0; i < started; i++)
+     {
+         if (i > 0)
+         {
+             joinThread(workers[i].thread);
+         }
+         failed = failed || workers[i].failed;
+         pathBase[i] = pathsUsed;
+         pathsUsed += workers[i].pathsUsed;
+         freeRouteSearch(&workers[i].search);
+         freeHierarchySearch(&workers[i].hierarchy);
+     }
+ 
+     // Gather the workers' paths into one block
+     batch->paths = failed ? NULL : (int *)malloc((pathsUsed + 1) * sizeof(int));
+     if (batch->paths != NULL)
+     {
+         for (int i = 0; i < started; i++)
+         {
+             if (workers[i].pathsUsed > 0)
+             {
+                 memcpy(batch->paths + pathBase[i], workers[i].paths, workers[i].pathsUsed * sizeof(int));
+             }
+         }
+         for (int g = 0; g < batch->groupCount; g++)
+         {
+             for (int i = batch->groups[g]; i < batch->groups[g + 1]; i++)
+             {
+                 int q = batch->order[i];
+                 queries[q].path = batch->paths + pathBase[batch->groupWorker[g]] + batch->pathStart[q];
+             }
+         }
+     }
+     for (int i = 0; i < started; i++)
+     {
+         free(workers[i].paths);
+     }
+     int *paths = batch->paths;
+     batch->paths = NULL;
+     freeRouteBatch(batch); // The scratch space; only the paths are kept
+     batch->paths = paths;
+     return paths != NULL;
+ }
+ 
+ void findShortestPath(int startBranchId, int endBranchId)
+ {
+     int startIndex = findBranchIndex(startBranchId);
+     int endIndex = findBranchIndex(endBranchId);
+     
+     if (startIndex == -1 || endIndex == -1)
+     {
+         printf("%sOne or both branches not found.%s\n", RED, RESET);
+         return;
+     }
+     
+     const int *path;
+     int pathLength;
+     float distance = shortestPath(startIndex, endIndex, &path, &pathLength);
+     
+     // Print result
+     if (distance == FLT_MAX)
+     {
+         printf("%sThere is no path from %s to %s.%s\n", 
+                RED, branchGraph[startIndex].data.branchName, 
+                branchGraph[endIndex].data.branchName, RESET);
+         return;
+     }
+     
+     printf("\n%s%sShortest Path from %s to %s:%s\n", 
+            BG_GREEN, BLACK, branchGraph[startIndex].data.branchName, 
+            branchGraph[endIndex].data.branchName, RESET);
+     printf("%sTotal Distance: %.2f units%s\n", YELLOW, distance, RESET);
+     
+     printf("%sPath: %s", GREEN, RESET);
+     for (int i = 0; i < pathLength; i++)
+     {
+         printf("%s%s%s", CYAN, branchGraph[path[i]].data.branchName, RESET);
+         if (i < pathLength - 1) printf(" %s→%s ", YELLOW, RESET);
+     }
+     printf("\n");
+ }
+ 
+ // File Handling Operations
+ enum DataFileFormat
+ {
+     DATA_FILE_CURRENT,
+     DATA_FILE_LEGACY,     // Headerless records with float amounts
+     DATA_FILE_UNSUPPORTED
+ };
+ 
+ // Size of one record in a transactions.dat of the given version
+ size_t transactionRecordSize(int version)
+ {
+     if (version < 4)
+     {
+         return sizeof(struct TransactionRecordV3);
+     }
+     return version == 4 ? sizeof(struct TransactionRecordV4) : sizeof(struct Transaction);
+ }
+ 
+ void writeTransactionsFileHeader(FILE *file, int version, long long recordCount, unsigned long long walLsn)
+ {
+     struct TransactionsFileHeader header;
+     memset(&header, 0, sizeof(header));
+     memcpy(header.magic, TRANSACTIONS_FILE_MAGIC, sizeof(header.magic));
+     header.version = version;
+     header.recordSize = (int)transactionRecordSize(version);
+     header.walLsn = walLsn;
+     header.recordCount = recordCount;
+     header.nextTransactionId = peekTransactionIdSequence();
+     fwrite(&header, sizeof(header), 1, file);
+ }
+ 
+ // Bring a record read from a file of the given version up to date
+ void upgradeTransactionRecord(int version, const unsigned char *record, struct Transaction *transaction)
+ {
+     if (version > 4)
+     {
+         memcpy(transaction, record, sizeof(*transaction));
+         return;
+     }
+ 
+     memset(transaction, 0, sizeof(*transaction));
+     if (version == 4)
+     {
+         struct TransactionRecordV4 old;
+         memcpy(&old, record, sizeof(old));
+         transaction->transactionId = old.transactionId;
+         transaction->accountNo = old.accountNo;
+         memcpy(transaction->type, old.type, sizeof(transaction->type));
+         transaction->amount = old.amount;
+         transaction->timestamp = timestampFromText(old.date, old.time);
+         return;
+     }
+ 
+     struct TransactionRecordV3 old;
+     memcpy(&old, record, sizeof(old));
+     transaction->transactionId = old.transactionId;
+     transaction->accountNo = old.accountNo;
+     memcpy(transaction->type, old.type, sizeof(transaction->type));
+     transaction->amount = old.amount;
+     transaction->timestamp = timestampFromText(old.date, old.time);
+ }
+ 
+ // Identify the file format and leave the file positioned at its first record.
+ // Version 1 files have the short header and are read with walLsn 0.
+ int readTransactionsFileHeader(FILE *file, struct TransactionsFileHeader *header)
+ {
+     struct DataFileHeader common;
+     memset(header, 0, sizeof(*header));
+     if (fread(&common, sizeof(common), 1, file) != 1 ||
+         strncmp(common.magic, TRANSACTIONS_FILE_MAGIC, sizeof(common.magic)) != 0)
+     {
+         fseek(file, 0, SEEK_SET);
+         return DATA_FILE_LEGACY;
+     }
+ 
+     memcpy(header->magic, common.magic, sizeof(header->magic));
+     header->version = common.version;
+     header->recordSize = common.recordSize;
+     if (common.version < 1 || common.version > TRANSACTIONS_FILE_VERSION ||
+         common.recordSize != (int)transactionRecordSize(common.version))
+     {
+         return DATA_FILE_UNSUPPORTED;
+     }
+     if (common.version == 1)
+     {
+         return DATA_FILE_CURRENT;
+     }
+     if (fread((char *)header + sizeof(common), sizeof(*header) - sizeof(common), 1, file) == 1)
+     {
+         return DATA_FILE_CURRENT;
+     }
+     return DATA_FILE_UNSUPPORTED;
+ }
+ 
+ // Rewrite a headerless float-amount transactions.dat in the current format;
+ // the original is kept next to it with a ".legacy" suffix
+ bool convertLegacyTransactionsFile()
+ {
+     const char *path = "transactions.dat";
+     FILE *in = fopen(path, "rb");
+     if (in == NULL)
+     {
+         return false;
+     }
+ 
+     struct TransactionsFileHeader header;
+     if (readTransactionsFileHeader(in, &header) != DATA_FILE_LEGACY)
+     {
+         fclose(in);
+         return false; // Already converted
+     }
+ 
+     char tempPath[256], legacyPath[256];
+     snprintf(tempPath, sizeof(tempPath), "%s.tmp", path);
+     snprintf(legacyPath, sizeof(legacyPath), "%s.legacy", path);
+ 
+     FILE *out = fopen(tempPath, "wb");
+     if (out == NULL)
+     {
+         fclose(in);
+         return false;
+     }
+ 
+     int converted = 0;
+     // Legacy files are newest first, which version 2 keeps
+     writeTransactionsFileHeader(out, 2, 0, 0);
+     struct LegacyTransaction old;
+     while (fread(&old, sizeof(old), 1, in) == 1)
+     {
+         struct TransactionRecordV3 transaction = {0};
+         transaction.transactionId = old.transactionId;
+         transaction.accountNo = old.accountNo;
+         memcpy(transaction.type, old.type, sizeof(transaction.type));
+         transaction.amount = moneyFromFloat(old.amount);
+         memcpy(transaction.date, old.date, sizeof(transaction.date));
+         memcpy(transaction.time, old.time, sizeof(transaction.time));
+         fwrite(&transaction, sizeof(transaction), 1, out);
+         converted++;
+     }
+ 
+     fclose(in);
+     fclose(out);
+ 
+     if (rename(path, legacyPath) != 0 || rename(tempPath, path) != 0)
+     {
+         printf("%sCould not replace %s with its converted copy.%s\n", RED, path, RESET);
+         return false;
+     }
+ 
+     printf("%sConverted %d records in %s (original kept as %s).%s\n",
+            YELLOW, converted, path, legacyPath, RESET);
+     return true;
+ }
+ 
+ // Read-only view of a whole file: mmap where available, one bulk read elsewhere
+ const unsigned char *mapFile(const char *path, size_t *size)
+ {
+     *size = 0;
+ #ifdef _WIN32
+     FILE *file = fopen(path, "rb");
+     if (file == NULL)
+     {
+         return NULL;
+     }
+     fseek(file, 0, SEEK_END);
+     long length = ftell(file);
+     fseek(file, 0, SEEK_SET);
+     unsigned char *data = length > 0 ? (unsigned char *)malloc(length) : NULL;
+     if (data != NULL && fread(data, 1, length, file) != (size_t)length)
+     {
+         free(data);
+         data = NULL;
+     }
+     fclose(file);
+     if (data != NULL)
+     {
+         *size = length;
+     }
+     return data;
+ #else
+     int fd = open(path, O_RDONLY);
+     if (fd < 0)
+     {
+         return NULL;
+     }
+ 
+     struct stat st;
+     if (fstat(fd, &st) != 0 || st.st_size == 0)
+     {
+         close(fd);
+         return NULL;
+     }
+ 
+     void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+     close(fd);
+     if (data == MAP_FAILED)
+     {
+         return NULL;
+     }
+     madvise(data, st.st_size, MADV_SEQUENTIAL);
+     *size = st.st_size;
+     return (const unsigned char *)data;
+ #endif
+ }
+ 
+ void unmapFile(const unsigned char *data, size_t size)
+ {
+ #ifdef _WIN32
+     free((void *)data);
+ #else
+     munmap((void *)data, size);
+ #endif
+ }
+ 
+ // Hash of one record. The file checksum is the sum of these, so one record
+ // can be replaced without rehashing the rest of the file.
+ unsigned long long hashRecordBytes(const void *record, size_t size)
+ {
+     const unsigned char *bytes = (const unsigned char *)record;
+     unsigned long long hash = 14695981039346656037ull;
+     for (size_t i = 0; i + 8 <= size; i += 8)
+     {
+         unsigned long long word;
+         memcpy(&word, bytes + i, 8);
+         hash = (hash ^ word) * 1099511628211ull;
+     }
+     return hash;
+ }
+ 
+ unsigned long long hashAccountRecord(const struct AccountRecord *record)
+ {
+     return hashRecordBytes(record, sizeof(*record));
+ }
+ 
+ // Size of one record in an accounts.dat of the given version (2 or later)
+ size_t accountRecordSize(int version)
+ {
+     return version == 2 ? sizeof(struct AccountRecordV2) : sizeof(struct AccountRecord);
+ }
+ 
+ void makeAccountRecord(int row, struct AccountRecord *record)
+ {
+     memset(record, 0, sizeof(*record));
+     record->accountNo = accountTable.accountNo[row];
+     record->flags = accountTable.flags[row] & ~ACCOUNT_DIRTY;
+     record->balance = accountTable.balance[row];
+     record->profile = *accountProfile(row);
+ }
+ 
+ bool reserveAccountSlots(int count)
+ {
+     if (count <= accountsFile.slotCapacity)
+     {
+         return true;
+     }
+ 
+     int capacity = accountsFile.slotCapacity == 0 ? 64 : accountsFile.slotCapacity;
+     while (capacity < count)
+     {
+         capacity *= 2;
+     }
+     unsigned long long *slotHash = (unsigned long long *)realloc(accountsFile.slotHash, capacity * sizeof(*slotHash));
+     if (slotHash == NULL)
+     {
+         return false;
+     }
+     accountsFile.slotHash = slotHash;
+     accountsFile.slotCapacity = capacity;
+     return true;
+ }
+ 
+ // Pick the slot for an account's first checkpoint: a tombstone if there is
+ // one, otherwise a new slot at the end of the file
+ int allocateAccountSlot()
+ {
+     if (accountsFile.freeSlotCount > 0)
+     {
+         return accountsFile.freeSlots[--accountsFile.freeSlotCount];
+     }
+     if (!reserveAccountSlots(accountsFile.slotCount + 1))
+     {
+         return -1;
+     }
+     accountsFile.slotHash[accountsFile.slotCount] = 0;
+     return accountsFile.slotCount++;
+ }
+ 
+ bool isCurrentAccountsFile(const unsigned char *data, size_t size)
+ {
+     const struct AccountsFileHeader *header = (const struct AccountsFileHeader *)data;
+     return size >= sizeof(*header) &&
+            strncmp(header->magic, ACCOUNTS_FILE_MAGIC, sizeof(header->magic)) == 0 &&
+            header->version == ACCOUNTS_FILE_VERSION;
+ }
+ 
+ // Rewrite the whole file; checkpointAccounts writes just the changes. The
+ // new file is written beside the old one and renamed over it, so a crash
+ // leaves one or the other.
+ bool saveAccountsToFile()
+ {
+     FILE *file = fopen("accounts.dat.tmp", "wb");
+     if (file == NULL)
+     {
+         printf("%sError opening file for saving accounts.%s\n", RED, RESET);
+         return false;
+     }
+     setvbuf(file, NULL, _IOFBF, 1 << 20);
+ 
+     // The header is rewritten with the count and checksum once the records are out
+     struct AccountsFileHeader header;
+     memset(&header, 0, sizeof(header));
+     memcpy(header.magic, ACCOUNTS_FILE_MAGIC, sizeof(header.magic));
+     header.version = ACCOUNTS_FILE_VERSION;
+     header.recordSize = sizeof(struct AccountRecord);
+     header.walLsn = wal.lastLsn;
+     fwrite(&header, sizeof(header), 1, file);
+ 
+     // Rows land in slots matching their order, with no tombstones
+     bool tracked = reserveAccountSlots(accountTable.count);
+     struct AccountRecord record;
+     for (int row = 0; row < accountTable.count; row++)
+     {
+         makeAccountRecord(row, &record);
+         unsigned long long hash = hashAccountRecord(&record);
+         header.checksum += hash;
+         fwrite(&record, sizeof(record), 1, file);
+         if (tracked)
+         {
+             accountsFile.slotHash[row] = hash;
+             accountTable.fileSlot[row] = row;
+         }
+         accountTable.flags[row] &= ~ACCOUNT_DIRTY;
+     }
+     bool written = syncFile(file);
+ 
+     if (written)
+     {
+         header.recordCount = accountTable.count;
+         fseek(file, 0, SEEK_SET);
+         fwrite(&header, sizeof(header), 1, file);
+         written = syncFile(file) && !ferror(file);
+     }
+     fclose(file);
+ 
+     if (written)
+     {
+ #ifdef _WIN32
+         remove("accounts.dat");
+ #endif
+         written = rename("accounts.dat.tmp", "accounts.dat") == 0;
+     }
+ 
+     accountsFile.valid = tracked && written;
+     accountsFile.slotCount = accountTable.count;
+     accountsFile.checksum = header.checksum;
+     accountsFile.freeSlotCount = 0;
+     accountsFile.releasedSlotCount = 0;
+     accountsFile.dirtyCount = 0;
+     return written;
+ }
+ 
+ // Copy the records in accounts.dat.delta into their slots in accounts.dat and
+ // then drop the delta. A delta whose header never made it to disk is simply
+ // discarded, as accounts.dat wasn't touched yet. Returns true if a delta was
+ // applied. A delta left by an older version is applied in that version's
+ // layout, before accounts.dat itself is upgraded.
+ bool applyAccountsDelta()
+ {
+     size_t size;
+     const unsigned char *data = mapFile(ACCOUNTS_DELTA_FILE_NAME, &size);
+     if (data == NULL)
+     {
+         return false;
+     }
+ 
+     // Each entry is its slot number followed by the record
+     const struct AccountsDeltaHeader *header = (const struct AccountsDeltaHeader *)data;
+     const unsigned char *entries = data + sizeof(*header);
+     bool complete = size >= sizeof(*header) &&
+                     strncmp(header->magic, ACCOUNTS_DELTA_FILE_MAGIC, sizeof(header->magic)) == 0 &&
+                     header->version >= 2 && header->version <= ACCOUNTS_FILE_VERSION &&
+                     header->recordSize == (int)(sizeof(long long) + accountRecordSize(header->version)) &&
+                     header->entryCount >= 0 &&
+                     (size - sizeof(*header)) / header->recordSize >= (size_t)header->entryCount;
+     size_t recordSize = complete ? accountRecordSize(header->version) : 0;
+     if (complete)
+     {
+         unsigned long long entriesChecksum = 0;
+         for (long long i = 0; i < header->entryCount; i++)
+         {
+             long long slot;
+             memcpy(&slot, entries + i * header->recordSize, sizeof(slot));
+             entriesChecksum += hashRecordBytes(entries + i * header->recordSize + sizeof(slot), recordSize) + slot;
+         }
+         complete = entriesChecksum == header->entriesChecksum;
+     }
+ 
+     bool applied = false;
+     FILE *file = complete ? fopen("accounts.dat", "r+b") : NULL;
+     if (file != NULL)
+     {
+         for (long long i = 0; i < header->entryCount; i++)
+         {
+             long long slot;
+             memcpy(&slot, entries + i * header->recordSize, sizeof(slot));
+             fseek(file, sizeof(struct AccountsFileHeader) + slot * recordSize, SEEK_SET);
+             fwrite(entries + i * header->recordSize + sizeof(slot), recordSize, 1, file);
+         }
+ 
+         struct AccountsFileHeader fileHeader;
+         memset(&fileHeader, 0, sizeof(fileHeader));
+         memcpy(fileHeader.magic, ACCOUNTS_FILE_MAGIC, sizeof(fileHeader.magic));
+         fileHeader.version = header->version;
+         fileHeader.recordSize = (int)recordSize;
+         fileHeader.recordCount = header->slotCount;
+         fileHeader.checksum = header->checksum;
+         fileHeader.walLsn = header->walLsn;
+         fseek(file, 0, SEEK_SET);
+         fwrite(&fileHeader, sizeof(fileHeader), 1, file);
+         applied = syncFile(file) && !ferror(file);
+         fclose(file);
+     }
+     unmapFile(data, size);
+ 
+     // A complete delta that couldn't be applied is kept for the next load
+     if (applied || !complete)
+     {
+         remove(ACCOUNTS_DELTA_FILE_NAME);
+     }
+     return applied;
+ }
+ 
+ void writeAccountDeltaEntry(FILE *file, struct AccountsDeltaHeader *header, const struct AccountDeltaEntry *entry)
+ {
+     unsigned long long hash = hashAccountRecord(&entry->record);
+     accountsFile.checksum += hash - accountsFile.slotHash[entry->slot];
+     accountsFile.slotHash[entry->slot] = hash;
+     header->entriesChecksum += hash + entry->slot;
+     header->entryCount++;
+     fwrite(entry, sizeof(*entry), 1, file);
+ }
+ 
+ // Write out only the accounts changed since the last checkpoint, so the cost
+ // follows the amount of change rather than the size of the book. Falls back
+ // to a full rewrite when the file's layout isn't known.
+ bool checkpointAccounts()
+ {
+     if (!accountsFile.valid)
+     {
+         return saveAccountsToFile();
+     }
+ 
+     FILE *file = fopen(ACCOUNTS_DELTA_FILE_NAME, "wb");
+     if (file == NULL)
+     {
+         printf("%sError opening file for saving accounts.%s\n", RED, RESET);
+         return false;
+     }
+     setvbuf(file, NULL, _IOFBF, 1 << 20);
+ 
+     struct AccountsDeltaHeader header;
+     memset(&header, 0, sizeof(header));
+     fwrite(&header, sizeof(header), 1, file);
+     memcpy(header.magic, ACCOUNTS_DELTA_FILE_MAGIC, sizeof(header.magic));
+     header.version = ACCOUNTS_FILE_VERSION;
+     header.recordSize = sizeof(struct AccountDeltaEntry);
+     header.walLsn = wal.lastLsn;
+ 
+     // Deleted accounts leave tombstones, which new accounts can then reuse
+     struct AccountDeltaEntry entry;
+     for (int i = 0; i < accountsFile.releasedSlotCount; i++)
+     {
+         memset(&entry, 0, sizeof(entry));
+         entry.slot = accountsFile.releasedSlots[i];
+         writeAccountDeltaEntry(file, &header, &entry);
+         appendToIntArray(&accountsFile.freeSlots, &accountsFile.freeSlotCount,
+                          &accountsFile.freeSlotCapacity, (int)entry.slot);
+     }
+     accountsFile.releasedSlotCount = 0;
+ 
+     bool tracked = true;
+     for (int i = 0; i < accountsFile.dirtyCount; i++)
+     {
+         int row = findAccount(accountsFile.dirtyAccounts[i]);
+         if (row == -1 || !(accountTable.flags[row] & ACCOUNT_DIRTY))
+         {
+             continue; // Deleted since, or listed twice
+         }
+         if (accountTable.fileSlot[row] == -1)
+         {
+             accountTable.fileSlot[row] = allocateAccountSlot();
+             if (accountTable.fileSlot[row] == -1)
+             {
+                 tracked = false;
+                 break;
+             }
+         }
+ 
+         memset(&entry, 0, sizeof(entry));
+         entry.slot = accountTable.fileSlot[row];
+         makeAccountRecord(row, &entry.record);
+         writeAccountDeltaEntry(file, &header, &entry);
+         accountTable.flags[row] &= ~ACCOUNT_DIRTY;
+     }
+     accountsFile.dirtyCount = 0;
+ 
+     // The entries must be on disk before the header that vouches for them
+     header.slotCount = accountsFile.slotCount;
+     header.checksum = accountsFile.checksum;
+     bool written = tracked && syncFile(file);
+     if (written)
+     {
+         fseek(file, 0, SEEK_SET);
+         fwrite(&header, sizeof(header), 1, file);
+         written = syncFile(file) && !ferror(file);
+     }
+     fclose(file);
+ 
+     if (!written || !applyAccountsDelta())
+     {
+         remove(ACCOUNTS_DELTA_FILE_NAME);
+         printf("%sCould not checkpoint accounts; writing the whole file instead.%s\n", YELLOW, RESET);
+         return saveAccountsToFile();
+     }
+     return true;
+ }
+ 
+ // Build the table from a mapped version 3 file in a single pass. The hot
+ // fields and profiles are read straight from the mapping, but each profile
+ // is still copied into the slab: checkpoints rewrite accounts.dat in place
+ // and hand tombstoned slots to new accounts, so the mapping can't outlive
+ // the load.
+ bool loadAccountRecords(const unsigned char *data, size_t size)
+ {
+     const struct AccountsFileHeader *header = (const struct AccountsFileHeader *)data;
+     if (header->recordSize != sizeof(struct AccountRecord) || header->recordCount < 0 ||
+         header->recordCount > INT_MAX ||
+         (size - sizeof(*header)) / sizeof(struct AccountRecord) < (size_t)header->recordCount)
+     {
+         printf("%saccounts.dat is truncated or has an unsupported layout.%s\n", RED, RESET);
+         return false;
+     }
+ 
+     int count = (int)header->recordCount;
+     const struct AccountRecord *records = (const struct AccountRecord *)(data + sizeof(*header));
+ 
+     clearAccounts();
+     idIndexReserve(&accountIndex, count);
+     accountTableReserve(count);
+ 
+     bool tracked = reserveAccountSlots(count);
+     unsigned long long checksum = 0;
+     for (int i = 0; i < count; i++)
+     {
+         unsigned long long hash = hashAccountRecord(&records[i]);
+         checksum += hash;
+         if (tracked)
+         {
+             accountsFile.slotHash[i] = hash;
+         }
+ 
+         if (!(records[i].flags & ACCOUNT_ACTIVE))
+         {
+             tracked = tracked && appendToIntArray(&accountsFile.freeSlots, &accountsFile.freeSlotCount,
+                                                   &accountsFile.freeSlotCapacity, i);
+         }
+         else if (idIndexFind(&accountIndex, records[i].accountNo) == -1 &&
+                  appendAccountRow(records[i].accountNo, records[i].balance,
+                                   (unsigned char)records[i].flags, &records[i].profile))
+         {
+             accountTable.fileSlot[accountTable.count - 1] = i;
+         }
+     }
+ 
+     if (checksum != header->checksum)
+     {
+         printf("%saccounts.dat failed its checksum; no accounts were loaded.%s\n", RED, RESET);
+         clearAccounts();
+         return false;
+     }
+     wal.accountsLsn = header->walLsn;
+     accountsFile.valid = tracked;
+     accountsFile.slotCount = count;
+     accountsFile.checksum = checksum;
+     return true;
+ }
+ 
+ // Load a version 1 or 2 or a headerless float-era accounts.dat into the table
+ bool loadOlderAccountRecords(const unsigned char *data, size_t size)
+ {
+     const struct DataFileHeader *header = (const struct DataFileHeader *)data;
+     struct AccountProfile profile;
+     clearAccounts();
+ 
+     if (size >= sizeof(struct AccountsFileHeader) && strncmp(header->magic, ACCOUNTS_FILE_MAGIC, sizeof(header->magic)) == 0 &&
+         header->version == 2)
+     {
+         const struct AccountsFileHeader *fileHeader = (const struct AccountsFileHeader *)data;
+         if (fileHeader->recordSize != sizeof(struct AccountRecordV2) || fileHeader->recordCount < 0 ||
+             (size - sizeof(*fileHeader)) / sizeof(struct AccountRecordV2) < (size_t)fileHeader->recordCount)
+         {
+             return false;
+         }
+ 
+         size_t count = (size_t)fileHeader->recordCount;
+         unsigned long long checksum = 0;
+         idIndexReserve(&accountIndex, (int)count);
+         accountTableReserve((int)count);
+         for (size_t i = 0; i < count; i++)
+         {
+             struct AccountRecordV2 record;
+             memcpy(&record, data + sizeof(*fileHeader) + i * sizeof(record), sizeof(record));
+             checksum += hashRecordBytes(&record, sizeof(record));
+             if (!(record.flags & ACCOUNT_ACTIVE) || idIndexFind(&accountIndex, record.accountNo) != -1)
+             {
+                 continue;
+             }
+             memset(&profile, 0, sizeof(profile));
+             memcpy(profile.name, record.profile.name, sizeof(profile.name));
+             memcpy(profile.address, record.profile.address, sizeof(profile.address));
+             memcpy(profile.phoneNumber, record.profile.phoneNumber, sizeof(profile.phoneNumber));
+             memcpy(profile.email, record.profile.email, sizeof(profile.email));
+             profile.createdAt = timestampFromText(record.profile.dateCreated, NULL);
+             appendAccountRow(record.accountNo, record.balance, ACCOUNT_ACTIVE, &profile);
+         }
+ 
+         if (checksum != fileHeader->checksum)
+         {
+             clearAccounts();
+             return false;
+         }
+         wal.accountsLsn = fileHeader->walLsn;
+         return true;
+     }
+ 
+     if (size >= sizeof(*header) && strncmp(header->magic, ACCOUNTS_FILE_MAGIC, sizeof(header->magic)) == 0)
+     {
+         if (header->version != 1 || header->recordSize != sizeof(struct Account))
+         {
+             return false;
+         }
+ 
+         size_t count = (size - sizeof(*header)) / sizeof(struct Account);
+         idIndexReserve(&accountIndex, (int)count);
+         accountTableReserve((int)count);
+         for (size_t i = 0; i < count; i++)
+         {
+             struct Account account;
+             memcpy(&account, data + sizeof(*header) + i * sizeof(account), sizeof(account));
+             memset(&profile, 0, sizeof(profile));
+             memcpy(profile.name, account.name, sizeof(profile.name));
+             memcpy(profile.address, account.address, sizeof(profile.address));
+             memcpy(profile.phoneNumber, account.phoneNumber, sizeof(profile.phoneNumber));
+             memcpy(profile.email, account.email, sizeof(profile.email));
+             profile.createdAt = timestampFromText(account.dateCreated, NULL);
+             if (idIndexFind(&accountIndex, account.accountNo) == -1)
+             {
+                 appendAccountRow(account.accountNo, account.balance, ACCOUNT_ACTIVE, &profile);
+             }
+         }
+         return true;
+     }
+ 
+     size_t count = size / sizeof(struct LegacyAccount);
+     idIndexReserve(&accountIndex, (int)count);
+     accountTableReserve((int)count);
+     for (size_t i = 0; i < count; i++)
+     {
+         struct LegacyAccount old;
+         memcpy(&old, data + i * sizeof(old), sizeof(old));
+         memset(&profile, 0, sizeof(profile));
+         memcpy(profile.name, old.name, sizeof(profile.name));
+         memcpy(profile.address, old.address, sizeof(profile.address));
+         memcpy(profile.phoneNumber, old.phoneNumber, sizeof(profile.phoneNumber));
+         memcpy(profile.email, old.email, sizeof(profile.email));
+         profile.createdAt = timestampFromText(old.dateCreated, NULL);
+         if (idIndexFind(&accountIndex, old.accountNo) == -1)
+         {
+             appendAccountRow(old.accountNo, moneyFromFloat(old.balance), ACCOUNT_ACTIVE, &profile);
+         }
+     }
+     return true;
+ }
+ 
+ // Rewrite an older accounts.dat in the current format, keeping the original
+ // as accounts.dat.legacy. Leaves the upgraded accounts loaded. Returns false
+ // if there was nothing to upgrade or the upgraded file couldn't be written.
+ bool upgradeAccountsFile()
+ {
+     size_t size;
+     const unsigned char *data = mapFile("accounts.dat", &size);
+     if (data == NULL)
+     {
+         return false;
+     }
+ 
+     if (isCurrentAccountsFile(data, size))
+     {
+         unmapFile(data, size);
+         return false;
+     }
+ 
+     bool loaded = loadOlderAccountRecords(data, size);
+     unmapFile(data, size);
+     if (!loaded)
+     {
+         printf("%saccounts.dat has an unsupported format.%s\n", RED, RESET);
+         return false;
+     }
+ 
+     if (rename("accounts.dat", "accounts.dat.legacy") != 0)
+     {
+         printf("%sCould not keep a copy of the old accounts.dat.%s\n", RED, RESET);
+         return false;
+     }
+ 
+     // The upgraded file covers the same journal records as the old one
+     unsigned long long lastLsn = wal.lastLsn;
+     wal.lastLsn = wal.accountsLsn;
+     bool saved = saveAccountsToFile();
+     wal.lastLsn = lastLsn;
+     if (!saved)
+     {
+         // Put the original back so the next run tries the upgrade again
+         rename("accounts.dat.legacy", "accounts.dat");
+         printf("%sCould not write the upgraded accounts.dat.%s\n", RED, RESET);
+         return false;
+     }
+     printf("%sUpgraded %d accounts in accounts.dat (original kept as accounts.dat.legacy).%s\n",
+            YELLOW, accountTable.count, RESET);
+     return true;
+ }
+ 
+ void convertLegacyDataFiles()
+ {
+     bool accounts = upgradeAccountsFile();
+     bool transactions = convertLegacyTransactionsFile();
+ 
+     if (!accounts && !transactions)
+     {
+         printf("No legacy data files to convert.\n");
+     }
+ }
+ 
+ void loadAccountsFromFile()
+ {
+     // Finish a checkpoint that was cut short after its delta was written
+     if (applyAccountsDelta())
+     {
+         printf("%sCompleted an interrupted checkpoint of accounts.dat.%s\n", YELLOW, RESET);
+     }
+ 
+     size_t size;
+     const unsigned char *data = mapFile("accounts.dat", &size);
+     if (data == NULL)
+     {
+         printf("%sNo previous account data found.%s\n", YELLOW, RESET);
+         return;
+     }
+ 
+     if (!isCurrentAccountsFile(data, size))
+     {
+         // Older formats are migrated on first load; the upgrade loads them too
+         unmapFile(data, size);
+         upgradeAccountsFile();
+         return;
+     }
+ 
+     bool loaded = loadAccountRecords(data, size);
+     unmapFile(data, size);
+ 
+     // Move a damaged file aside so the next save can't overwrite it
+     if (!loaded && rename("accounts.dat", "accounts.dat.corrupt") == 0)
+     {
+         printf("%sThe damaged file was kept as accounts.dat.corrupt.%s\n", YELLOW, RESET);
+     }
+ }
+ 
+ // Save transactions to file. The file is kept oldest first, so a save only
+ // appends what was pushed since the last one. If undo has reached back into
+ // saved history, a new file is written and renamed over the old one.
+ bool saveTransactionsToFile()
+ {
+     bool append = transactionsFile.valid && transactionsFile.savedCount == transactionsFile.fileCount;
+     long long first = append ? transactionsFile.fileCount : 0;
+     long long pending = transactionCount - first;
+ 
+     // The stack has the newest entry on top; collect the unsaved ones so
+     // they can be written oldest first
+     struct TransactionNode **nodes = NULL;
+     if (pending > 0)
+     {
+         nodes = (struct TransactionNode **)malloc(pending * sizeof(*nodes));
+         if (nodes == NULL)
+         {
+             printf("%sNot enough memory to save transactions.%s\n", RED, RESET);
+             return false;
+         }
+         struct TransactionNode *temp = transactionStack;
+         for (long long i = 0; i < pending; i++)
+         {
+             nodes[i] = temp;
+             temp = temp->next;
+         }
+     }
+ 
+     const char *path = append ? "transactions.dat" : "transactions.dat.tmp";
+     FILE *file = fopen(path, append ? "r+b" : "wb");
+     if (file == NULL)
+     {
+         printf("%sError opening file for saving transactions.%s\n", RED, RESET);
+         free(nodes);
+         return false;
+     }
+     setvbuf(file, NULL, _IOFBF, 1 << 20);
+ 
+     // Appended records only become part of the file once the header's count
+     // includes them, so the header is written last
+     if (!append)
+     {
+         writeTransactionsFileHeader(file, TRANSACTIONS_FILE_VERSION, 0, 0);
+     }
+     fseek(file, sizeof(struct TransactionsFileHeader) + first * sizeof(struct Transaction), SEEK_SET);
+     for (long long i = pending - 1; i >= 0; i--)
+     {
+         fwrite(&nodes[i]->data, sizeof(struct Transaction), 1, file);
+     }
+     free(nodes);
+     bool written = syncFile(file);
+ 
+     if (written)
+     {
+         fseek(file, 0, SEEK_SET);
+         writeTransactionsFileHeader(file, TRANSACTIONS_FILE_VERSION, transactionCount, wal.lastLsn);
+         written = syncFile(file) && !ferror(file);
+     }
+     fclose(file);
+ 
+     if (!append && written)
+     {
+ #ifdef _WIN32
+         remove("transactions.dat");
+ #endif
+         written = rename(path, "transactions.dat") == 0;
+     }
+ 
+     transactionsFile.valid = written;
+     transactionsFile.fileCount = written ? transactionCount : 0;
+     transactionsFile.savedCount = transactionsFile.fileCount;
+     return written;
+ }
+ 
+ // Load transactions from file. Records are streamed in chunks and pushed
+ // oldest first, so there is no limit on the size of the history.
+ void loadTransactionsFromFile()
+ {
+     clearTransactions();
+     FILE *file = fopen("transactions.dat", "rb");
+     if (file == NULL)
+     {
+         return; // No previous transactions data
+     }
+ 
+     struct TransactionsFileHeader header;
+     int format = readTransactionsFileHeader(file, &header);
+     if (format == DATA_FILE_LEGACY)
+     {
+         // Migrate pre-cents files before loading them
+         fclose(file);
+         convertLegacyTransactionsFile();
+         file = fopen("transactions.dat", "rb");
+         if (file == NULL)
+         {
+             return;
+         }
+         format = readTransactionsFileHeader(file, &header);
+     }
+ 
+     if (format != DATA_FILE_CURRENT)
+     {
+         printf("%stransactions.dat has an unsupported format.%s\n", RED, RESET);
+         fclose(file);
+         return;
+     }
+ 
+     size_t recordSize = transactionRecordSize(header.version);
+     unsigned char *chunk = (unsigned char *)malloc(TRANSACTION_LOAD_CHUNK * recordSize);
+     if (chunk == NULL)
+     {
+         printf("%sNot enough memory to load transactions.%s\n", RED, RESET);
+         fclose(file);
+         return;
+     }
+     wal.transactionsLsn = header.walLsn;
+     raiseTransactionIdSequence(header.nextTransactionId);
+ 
+     // A partial record at the end is a torn write and is left out
+     long dataStart = ftell(file);
+     fseek(file, 0, SEEK_END);
+     long long count = (ftell(file) - dataStart) / (long long)recordSize;
+     bool oldestFirst = header.version >= 3;
+     if (oldestFirst && header.recordCount < count)
+     {
+         count = header.recordCount;
+     }
+ 
+     double start = monotonicNow();
+     long long loaded = 0;
+     while (loaded < count)
+     {
+         long long n = count - loaded < TRANSACTION_LOAD_CHUNK ? count - loaded : TRANSACTION_LOAD_CHUNK;
+ 
+         // Older files have the newest record first and are read back to front
+         long long first = oldestFirst ? loaded : count - loaded - n;
+         fseek(file, dataStart + first * (long)recordSize, SEEK_SET);
+         if (fread(chunk, recordSize, n, file) != (size_t)n)
+         {
+             break;
+         }
+ 
+         struct Transaction transaction;
+         for (long long i = 0; i < n; i++)
+         {
+             upgradeTransactionRecord(header.version, chunk + (oldestFirst ? i : n - 1 - i) * recordSize, &transaction);
+             pushTransaction(transaction);
+         }
+         loaded += n;
+     }
+     double elapsed = monotonicNow() - start;
+ 
+     free(chunk);
+     fclose(file);
+ 
+     // Older files are rewritten in the current format by the next save
+     transactionsFile.valid = header.version == TRANSACTIONS_FILE_VERSION && loaded == count;
+     transactionsFile.fileCount = loaded;
+     transactionsFile.savedCount = loaded;
+ 
+     if (loaded > 0)
+     {
+         printf("Loaded %lld transactions in %.3f s (%.0f records/s).\n",
+                loaded, elapsed, elapsed > 0 ? loaded / elapsed : 0.0);
+     }
+ }
+ 
+ // Identifies a branch network: its branch IDs and compiled links, hashed
+ // one at a time and summed, so the order connections were added in (which
+ // reverses each time connections.dat is written and read) doesn't matter
+ unsigned long long branchNetworkSignature()
+ {
+     if (branchRoutes.stale && !buildBranchRoutes())
+     {
+         return 0;
+     }
+     long long count = branchRoutes.branchCount;
+     unsigned long long signature = hashRecordBytes(&count, sizeof(count));
+     for (int i = 0; i < branchRoutes.branchCount; i++)
+     {
+         int branch[2] = {i, branchGraph[i].data.branchId};
+         signature += hashRecordBytes(branch, sizeof(branch));
+         for (int e = branchRoutes.offsets[i]; e < branchRoutes.offsets[i + 1]; e++)
+         {
+             struct
+             {
+                 int source;
+                 int target;
+                 float distance;
+                 int reserved;
+             } link = {i, branchRoutes.targets[e], branchRoutes.distances[e], 0};
+             signature += hashRecordBytes(&link, sizeof(link));
+         }
+     }
+     return signature;
+ }
+ 
+ // Save the route hierarchy, if there is one for the network as it is
+ void saveHierarchyToFile()
+ {
+     if (!routeHierarchy.ready)
+     {
+         return;
+     }
+     FILE *file = fopen(HIERARCHY_FILE_NAME, "wb");
+     if (file == NULL)
+     {
+         printf("%sError opening %s for saving.%s\n", RED, HIERARCHY_FILE_NAME, RESET);
+         return;
+     }
+     struct HierarchyFileHeader header;
+     memset(&header, 0, sizeof(header));
+     memcpy(header.magic, HIERARCHY_FILE_MAGIC, sizeof(header.magic));
+     header.version = HIERARCHY_FILE_VERSION;
+     header.branchCount = routeHierarchy.branchCount;
+     header.upCount = routeHierarchy.upCount;
+     header.downCount = routeHierarchy.downCount;
+     header.signature = branchNetworkSignature();
+     int n = routeHierarchy.branchCount;
+     bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                    fwrite(routeHierarchy.rank, sizeof(int), n, file) == (size_t)n &&
+                    fwrite(routeHierarchy.upOffsets, sizeof(int), n + 1, file) == (size_t)n + 1 &&
+                    fwrite(routeHierarchy.upArcs, sizeof(struct HierarchyArc), header.upCount, file) == (size_t)header.upCount &&
+                    fwrite(routeHierarchy.downOffsets, sizeof(int), n + 1, file) == (size_t)n + 1 &&
+                    fwrite(routeHierarchy.downArcs, sizeof(struct HierarchyArc), header.downCount, file) == (size_t)header.downCount;
+     if (fclose(file) != 0 || !written)
+     {
+         printf("%sError writing %s.%s\n", RED, HIERARCHY_FILE_NAME, RESET);
+         remove(HIERARCHY_FILE_NAME);
+     }
+ }
+ 
+ // Whether one direction's lists read from hierarchy.dat are well formed:
+ // offsets in order, links between branches that exist, and shortcuts
+ // whose middle ranks below both ends, so unpacking one always finishes
+ bool hierarchyArcsValid(const int *offsets, const struct HierarchyArc *arcs, int count, int n, const int *rank)
+ {
+     if (offsets[0] != 0 || offsets[n] != count)
+     {
+         return false;
+     }
+     for (int i = 0; i < n; i++)
+     {
+         if (offsets[i] > offsets[i + 1])
+         {
+             return false;
+         }
+         for (int e = offsets[i]; e < offsets[i + 1]; e++)
+         {
+             int node = arcs[e].node;
+             int middle = arcs[e].middle;
+             if (node < 0 || node >= n || middle < -1 || middle >= n ||
+                 (middle != -1 && (rank[middle] >= rank[i] || rank[middle] >= rank[node])))
+             {
+                 return false;
+             }
+         }
+     }
+     return true;
+ }
+ 
+ // Load the route hierarchy saved for the branch network just loaded.
+ // One saved for another network, or that doesn't read back whole, is
+ // ignored; routes then use Dijkstra until the hierarchy is built again.
+ void loadHierarchyFromFile()
+ {
+     freeRouteHierarchy();
+     FILE *file = fopen(HIERARCHY_FILE_NAME, "rb");
+     if (file == NULL)
+     {
+         return; // Never built
+     }
+     struct HierarchyFileHeader header;
+     if (fread(&header, sizeof(header), 1, file) != 1 ||
+         strncmp(header.magic, HIERARCHY_FILE_MAGIC, sizeof(header.magic)) != 0 ||
+         header.version != HIERARCHY_FILE_VERSION || header.branchCount != branchCount || header.upCount < 0 ||
+         header.downCount < 0 || header.signature != branchNetworkSignature())
+     {
+         fclose(file);
+         return; // Out of date
+     }
+ 
+     int n = header.branchCount;
+     int *rank = (int *)malloc((n > 0 ? n : 1) * sizeof(int));
+     int *upOffsets = (int *)malloc((n + 1) * sizeof(int));
+     int *downOffsets = (int *)malloc((n + 1) * sizeof(int));
+     struct HierarchyArc *upArcs = (struct HierarchyArc *)malloc((header.upCount > 0 ? header.upCount : 1) * sizeof(struct HierarchyArc));
+     struct HierarchyArc *downArcs = (struct HierarchyArc *)malloc((header.downCount > 0 ? header.downCount : 1) * sizeof(struct HierarchyArc));
+     bool loaded = rank != NULL && upOffsets != NULL && downOffsets != NULL && upArcs != NULL && downArcs != NULL &&
+                   fread(rank, sizeof(int), n, file) == (size_t)n &&
+                   fread(upOffsets, sizeof(int), n + 1, file) == (size_t)n + 1 &&
+                   fread(upArcs, sizeof(struct HierarchyArc), header.upCount, file) == (size_t)header.upCount &&
+                   fread(downOffsets, sizeof(int), n + 1, file) == (size_t)n + 1 &&
+                   fread(downArcs, sizeof(struct HierarchyArc), header.downCount, file) == (size_t)header.downCount;
+     fclose(file);
+     for (int i = 0; i < n && loaded; i++)
+     {
+         loaded = rank[i] >= 0 && rank[i] < n;
+     }
+     loaded = loaded && hierarchyArcsValid(upOffsets, upArcs, header.upCount, n, rank) &&
+              hierarchyArcsValid(downOffsets, downArcs, header.downCount, n, rank);
+     if (!loaded)
+     {
+         printf("%s%s is damaged; routes will be searched directly until they are prepared again.%s\n", YELLOW, HIERARCHY_FILE_NAME, RESET);
+         free(rank);
+         free(upOffsets);
+         free(downOffsets);
+         free(upArcs);
+         free(downArcs);
+         return;
+     }
+     routeHierarchy.rank = rank;
+     routeHierarchy.upOffsets = upOffsets;
+     routeHierarchy.upArcs = upArcs;
+     routeHierarchy.downOffsets = downOffsets;
+     routeHierarchy.downArcs = downArcs;
+     routeHierarchy.branchCount = n;
+     routeHierarchy.upCount = header.upCount;
+     routeHierarchy.downCount = header.downCount;
+     routeHierarchy.ready = true;
+ }
+ 
+ // Save branches and connections to file
+ void saveBranchesToFile()
+ {
+     FILE *branchFile = fopen("branches.dat", "wb");
+     FILE *connectionFile = fopen("connections.dat", "wb");
+     
+     if (branchFile == NULL || connectionFile == NULL)
+     {
+         printf("%sError opening files for saving branch data.%s\n", RED, RESET);
+         if (branchFile) fclose(branchFile);
+         if (connectionFile) fclose(connectionFile);
+         return;
+     }
+ 
+     // Save branch count
+     fwrite(&branchCount, sizeof(int), 1, branchFile);
+     
+     // Save branches
+     for (int i = 0; i < branchCount; i++)
+     {
+         fwrite(&branchGraph[i].data, sizeof(struct Branch), 1, branchFile);
+         
+         // Count connections
+         int connectionCount = 0;
+         struct EdgeList *edge = branchGraph[i].connections;
+         while (edge != NULL)
+         {
+             connectionCount++;
+             edge = edge->next;
+         }
+         
+         // Save connection count for this branch
+         fwrite(&connectionCount, sizeof(int), 1, connectionFile);
+         
+         // Save connections
+         edge = branchGraph[i].connections;
+         while (edge != NULL)
+         {
+             fwrite(&branchGraph[i].data.branchId, sizeof(int), 1, connectionFile);
+             fwrite(&edge->branchId, sizeof(int), 1, connectionFile);
+             fwrite(&edge->distance, sizeof(float), 1, connectionFile);
+             edge = edge->next;
+         }
+     }
+ 
+     fclose(branchFile);
+     fclose(connectionFile);
+     saveHierarchyToFile();
+ }
+ 
+ // Save the service queue to requests.dat, one record of just the size
+ // its texts need per request
+ bool saveRequestsToFile()
+ {
+     FILE *file = fopen("requests.dat.tmp", "wb");
+     if (file == NULL)
+     {
+         printf("%sError opening file for saving service requests.%s\n", RED, RESET);
+         return false;
+     }
+ 
+     struct RequestsFileHeader header = {{0}};
+     memcpy(header.magic, REQUESTS_FILE_MAGIC, sizeof(header.magic));
+     header.version = REQUESTS_FILE_VERSION;
+     header.recordSize = sizeof(struct RequestRecordHeader);
+     header.walLsn = wal.lastLsn;
+     header.recordCount = serviceQueue.count;
+     header.lastRequestId = lastRequestId;
+     fwrite(&header, sizeof(header), 1, file);
+ 
+     struct ServiceRequest request;
+     unsigned char record[sizeof(struct RequestRecordHeader) + sizeof(request.requestType) + sizeof(request.description)];
+     for (int i = 0; i < serviceQueue.count; i++)
+     {
+         requestFromNode(serviceQueue.heap[i], &request);
+         fwrite(record, encodeRequest(&request, record), 1, file);
+     }
+     bool written = syncFile(file) && !ferror(file);
+     fclose(file);
+ 
+     if (written)
+     {
+ #ifdef _WIN32
+         remove("requests.dat");
+ #endif
+         written = rename("requests.dat.tmp", "requests.dat") == 0;
+     }
+     return written;
+ }
+ 
+ // Load service requests from file
+ void loadRequestsFromFile()
+ {
+     clearRequests();
+     wal.requestsLsn = 0;
+ 
+     FILE *file = fopen("requests.dat", "rb");
+     if (file == NULL)
+     {
+         return; // No previous requests data
+     }
+ 
+     struct DataFileHeader header;
+     bool headerless = fread(&header, sizeof(header), 1, file) != 1 ||
+                       strncmp(header.magic, REQUESTS_FILE_MAGIC, sizeof(header.magic)) != 0;
+     bool fixedRecords = !headerless && header.version == 2 && header.recordSize == sizeof(struct ServiceRequest);
+     bool current = !headerless && header.version == REQUESTS_FILE_VERSION &&
+                    header.recordSize == sizeof(struct RequestRecordHeader);
+     if (!headerless && !fixedRecords && !current)
+     {
+         printf("%srequests.dat has an unsupported format.%s\n", RED, RESET);
+         fclose(file);
+         return;
+     }
+ 
+     struct ServiceRequest request;
+     if (current)
+     {
+         struct RequestsFileHeader fileHeader;
+         fseek(file, 0, SEEK_SET);
+         if (fread(&fileHeader, sizeof(fileHeader), 1, file) != 1)
+         {
+             fclose(file);
+             return;
+         }
+         unsigned char record[sizeof(struct RequestRecordHeader) + 2 * 255];
+         struct RequestRecordHeader recordHeader;
+         for (long long i = 0; i < fileHeader.recordCount; i++)
+         {
+             if (fread(&recordHeader, sizeof(recordHeader), 1, file) != 1)
+             {
+                 break;
+             }
+             size_t size = requestRecordSize(&recordHeader);
+             memcpy(record, &recordHeader, sizeof(recordHeader));
+             if (fread(record + sizeof(recordHeader), 1, size - sizeof(recordHeader), file) != size - sizeof(recordHeader))
+             {
+                 break;
+             }
+             if (decodeRequest(record, size, &request))
+             {
+                 enqueueRequest(request);
+             }
+         }
+         wal.requestsLsn = fileHeader.walLsn;
+         if (fileHeader.lastRequestId > lastRequestId)
+         {
+             lastRequestId = fileHeader.lastRequestId;
+         }
+     }
+     else if (headerless)
+     {
+         // Files from before the header hold the old record with a date string
+         fseek(file, 0, SEEK_SET);
+         struct ServiceRequestV1 old;
+         while (fread(&old, sizeof(old), 1, file) == 1)
+         {
+             memset(&request, 0, sizeof(request));
+             request.requestId = old.requestId;
+             request.accountNo = old.accountNo;
+             memcpy(request.requestType, old.requestType, sizeof(request.requestType));
+             memcpy(request.description, old.description, sizeof(request.description));
+             request.isProcessed = old.isProcessed;
+             request.priority = old.priority;
+             request.submittedAt = timestampFromText(old.dateSubmitted, NULL);
+             enqueueRequest(request);
+         }
+     }
+     else
+     {
+         // Version 2 files hold the whole fixed-size ServiceRequest
+         while (fread(&request, sizeof(struct ServiceRequest), 1, file) == 1)
+         {
+             enqueueRequest(request);
+         }
+     }
+ 
+     fclose(file);
+ }
+ 
+ // Load branches and connections from file
+ void loadBranchesFromFile()
+ {
+     FILE *branchFile = fopen("branches.dat", "rb");
+     FILE *connectionFile = fopen("connections.dat", "rb");
+     
+     if (branchFile == NULL || connectionFile == NULL)
+     {
+         if (branchFile) fclose(branchFile);
+         if (connectionFile) fclose(connectionFile);
+         return; // No previous branch data
+     }
+ 
+     clearBranches();
+     
+     // Load branch count
+     int fileBranchCount = 0;
+     if (fread(&fileBranchCount, sizeof(int), 1, branchFile) != 1)
+     {
+         fileBranchCount = 0;
+     }
+     
+     // Load branches. The count isn't trusted for sizing; the store grows as
+     // records are actually read. Connections stop at the first short read,
+     // since what follows it can't be lined up.
+     bool connectionsIntact = true;
+     for (int i = 0; i < fileBranchCount; i++)
+     {
+         if (!reserveBranches(branchCount + 1) ||
+             fread(&branchGraph[i].data, sizeof(struct Branch), 1, branchFile) != 1)
+         {
+             break;
+         }
+         branchGraph[i].connections = NULL;
+         idIndexInsert(&branchIndex, branchGraph[i].data.branchId, i); // First of a repeated ID wins
+         branchCount++;
+         
+         // Load connection count for this branch
+         int connectionCount = 0;
+         if (connectionsIntact && fread(&connectionCount, sizeof(int), 1, connectionFile) != 1)
+         {
+             connectionsIntact = false;
+         }
+         
+         // Load connections; addConnection drops any a route search can't use
+         for (int j = 0; j < connectionCount && connectionsIntact; j++)
+         {
+             int sourceBranchId, targetBranchId;
+             float distance;
+             
+             if (fread(&sourceBranchId, sizeof(int), 1, connectionFile) != 1 ||
+                 fread(&targetBranchId, sizeof(int), 1, connectionFile) != 1 ||
+                 fread(&distance, sizeof(float), 1, connectionFile) != 1)
+             {
+                 connectionsIntact = false;
+                 break;
+             }
+             addConnection(sourceBranchId, targetBranchId, distance);
+         }
+     }
+     if (!connectionsIntact)
+     {
+         printf("%sconnections.dat is truncated; connections after the damage were not loaded.%s\n", YELLOW, RESET);
+     }
+ 
+     fclose(branchFile);
+     fclose(connectionFile);
+     loadHierarchyFromFile();
+ }
+ 
+ // Journal Replay
+ // The balance side of a deposit, withdrawal or transfer
+ void applyMoneyBalances(int type, const struct WalMoneyPayload *entry)
+ {
+     int row = findAccount(entry->accountNo);
+     int toRow = type == WAL_TRANSFER ? findAccount(entry->toAccountNo) : -1;
+     if (row != -1 && type == WAL_DEPOSIT)
+     {
+         accountTable.balance[row] += entry->amount;
+         markAccountDirty(row);
+     }
+     else if (row != -1 && type == WAL_WITHDRAW)
+     {
+         accountTable.balance[row] -= entry->amount;
+         markAccountDirty(row);
+     }
+     else if (row != -1 && toRow != -1)
+     {
+         accountTable.balance[row] -= entry->amount;
+         accountTable.balance[toRow] += entry->amount;
+         markAccountDirty(row);
+         markAccountDirty(toRow);
+     }
+ }
+ 
+ // The history side: one entry, or for a transfer one for each account
+ void recordMoneyHistory(int type, const struct WalMoneyPayload *entry)
+ {
+     struct Transaction transaction = {0};
+     transaction.transactionId = entry->transactionId;
+     transaction.accountNo = entry->accountNo;
+     transaction.amount = entry->amount;
+     transaction.timestamp = entry->timestamp;
+     if (type == WAL_DEPOSIT)
+     {
+         strcpy(transaction.type, "deposit");
+     }
+     else if (type == WAL_WITHDRAW)
+     {
+         strcpy(transaction.type, "withdraw");
+     }
+     else
+     {
+         sprintf(transaction.type, "transfer to %d", entry->toAccountNo);
+     }
+     pushTransaction(transaction);
+ 
+     // The receiving side goes on top of the sender's entry
+     if (type == WAL_TRANSFER)
+     {
+         transaction.transactionId = entry->toTransactionId;
+         transaction.accountNo = entry->toAccountNo;
+         sprintf(transaction.type, "receive from %d", entry->accountNo);
+         pushTransaction(transaction);
+     }
+ }
+ 
+ // Apply a logged deposit, withdrawal or transfer. Replay can ask for just
+ // the balances or just the history when one snapshot file already has it.
+ void applyMoneyRecord(int type, const struct WalMoneyPayload *entry, bool updateBalances, bool recordHistory)
+ {
+     if (updateBalances)
+     {
+         applyMoneyBalances(type, entry);
+     }
+     if (recordHistory)
+     {
+         recordMoneyHistory(type, entry);
+     }
+     else
+     {
+         // transactions.dat has these entries, but its saved counter may not
+         // cover their IDs if it was written before them
+         raiseTransactionIdSequence((type == WAL_TRANSFER ? entry->toTransactionId : entry->transactionId) + 1);
+     }
+ }
+ 
+ // Reverse the newest history entry, and the other half of it if it was a
+ // transfer. *undone gets the newest entry; returns how many were popped.
+ int applyUndo(struct Transaction *undone)
+ {
+     struct Transaction lastTrans = popTransaction();
+     int popped = 1;
+     int row = findAccount(lastTrans.accountNo);
+     *undone = lastTrans;
+ 
+     if (row == -1)
+     {
+         return popped;
+     }
+     markAccountDirty(row);
+ 
+     if (strcmp(lastTrans.type, "deposit") == 0)
+     {
+         accountTable.balance[row] -= lastTrans.amount;
+     }
+     else if (strcmp(lastTrans.type, "withdraw") == 0)
+     {
+         accountTable.balance[row] += lastTrans.amount;
+     }
+     else if (strncmp(lastTrans.type, "transfer to", 11) == 0)
+     {
+         // Extract to account number
+         int toAccountNo;
+         sscanf(lastTrans.type + 11, "%d", &toAccountNo);
+         int toRow = findAccount(toAccountNo);
+         
+         if (toRow != -1)
+         {
+             accountTable.balance[row] += lastTrans.amount;
+             accountTable.balance[toRow] -= lastTrans.amount;
+             markAccountDirty(toRow);
+             
+             // Pop the receive transaction as well
+             popTransaction();
+             popped++;
+         }
+     }
+     else if (strncmp(lastTrans.type, "receive from", 12) == 0)
+     {
+         // Extract from account number
+         int fromAccountNo;
+         sscanf(lastTrans.type + 12, "%d", &fromAccountNo);
+         int fromRow = findAccount(fromAccountNo);
+         
+         if (fromRow != -1)
+         {
+             accountTable.balance[row] -= lastTrans.amount;
+             accountTable.balance[fromRow] += lastTrans.amount;
+             markAccountDirty(fromRow);
+             
+             // Pop the transfer transaction as well
+             popTransaction();
+             popped++;
+         }
+     }
+     return popped;
+ }
+ 
+ // Read a deposit, withdraw or transfer payload from a journal of the given
+ // version, including the smaller one written before transaction IDs were
+ // 64-bit
+ bool readMoneyPayload(int version, const struct WalRecordHeader *header, const unsigned char *payload,
+                       struct WalMoneyPayload *entry)
+ {
+     if (header->payloadSize == sizeof(*entry))
+     {
+         memcpy(entry, payload, sizeof(*entry));
+         if (version == 1)
+         {
+             entry->timestamp = timestampFromSeconds((time_t)entry->timestamp);
+         }
+         return true;
+     }
+     if (header->payloadSize == sizeof(struct WalMoneyPayloadV1))
+     {
+         struct WalMoneyPayloadV1 old;
+         memcpy(&old, payload, sizeof(old));
+         entry->accountNo = old.accountNo;
+         entry->toAccountNo = old.toAccountNo;
+         entry->transactionId = old.transactionId;
+         entry->toTransactionId = old.toTransactionId;
+         entry->amount = old.amount;
+         entry->timestamp = timestampFromSeconds((time_t)old.timestamp);
+         return true;
+     }
+     return false;
+ }
+ 
+ // Read an account open or update payload, including the larger one written
+ // before creation dates were timestamps
+ bool readAccountPayload(const struct WalRecordHeader *header, const unsigned char *payload, struct AccountRecord *record)
+ {
+     if (header->payloadSize == sizeof(*record))
+     {
+         memcpy(record, payload, sizeof(*record));
+         return true;
+     }
+     if (header->payloadSize == sizeof(struct AccountRecordV2))
+     {
+         struct AccountRecordV2 old;
+         memcpy(&old, payload, sizeof(old));
+         memset(record, 0, sizeof(*record));
+         record->accountNo = old.accountNo;
+         record->flags = old.flags;
+         record->balance = old.balance;
+         memcpy(record->profile.name, old.profile.name, sizeof(record->profile.name));
+         memcpy(record->profile.address, old.profile.address, sizeof(record->profile.address));
+         memcpy(record->profile.phoneNumber, old.profile.phoneNumber, sizeof(record->profile.phoneNumber));
+         memcpy(record->profile.email, old.profile.email, sizeof(record->profile.email));
+         record->profile.createdAt = timestampFromText(old.profile.dateCreated, NULL);
+         return true;
+     }
+     return false;
+ }
+ 
+ void walReplayRecord(int version, const struct WalRecordHeader *header, const unsigned char *payload,
+                      bool updateAccounts, bool recordHistory, bool updateRequests)
+ {
+     int type = header->type;
+     struct WalMoneyPayload entry;
+     struct AccountRecord record;
+     struct ServiceRequest request;
+     if ((type == WAL_DEPOSIT || type == WAL_WITHDRAW || type == WAL_TRANSFER) &&
+         readMoneyPayload(version, header, payload, &entry))
+     {
+         applyMoneyRecord(type, &entry, updateAccounts, recordHistory);
+     }
+     else if (type == WAL_UNDO && header->payloadSize == sizeof(struct WalUndoPayload) && recordHistory)
+     {
+         struct WalUndoPayload undo;
+         memcpy(&undo, payload, sizeof(undo));
+         if (updateAccounts)
+         {
+             struct Transaction undone;
+             applyUndo(&undone);
+         }
+         else
+         {
+             for (int i = 0; i < undo.popped; i++)
+             {
+                 popTransaction();
+             }
+         }
+     }
+     else if ((type == WAL_ACCOUNT_OPEN || type == WAL_ACCOUNT_UPDATE) && updateAccounts &&
+              readAccountPayload(header, payload, &record))
+     {
+         int row = findAccount(record.accountNo);
+         if (type == WAL_ACCOUNT_OPEN && row == -1 &&
+             appendAccountRow(record.accountNo, record.balance, (unsigned char)record.flags, &record.profile))
+         {
+             markAccountDirty(accountTable.count - 1);
+         }
+         else if (type == WAL_ACCOUNT_UPDATE && row != -1)
+         {
+             *accountProfile(row) = record.profile;
+             markAccountDirty(row);
+         }
+     }
+     else if (type == WAL_ACCOUNT_CLOSE && header->payloadSize == sizeof(int) && updateAccounts)
+     {
+         int accountNo;
+         memcpy(&accountNo, payload, sizeof(accountNo));
+         int row = findAccount(accountNo);
+         if (row != -1)
+         {
+             removeAccountRow(row);
+         }
+     }
+     else if (type == WAL_REQUEST_ENQUEUE && updateRequests && decodeRequest(payload, header->payloadSize, &request))
+     {
+         enqueueRequest(request);
+     }
+     else if (type == WAL_REQUEST_DEQUEUE && updateRequests && header->payloadSize == sizeof(int))
+     {
+         int requestId;
+         memcpy(&requestId, payload, sizeof(requestId));
+         cancelRequest(requestId, &request);
+         if (requestId > lastRequestId)
+         {
+             lastRequestId = requestId; // Served before the crash; not to be reused
+         }
+     }
+     else if (type == WAL_REQUEST_PRIORITY && updateRequests &&
+              header->payloadSize == sizeof(struct WalRequestPriorityPayload))
+     {
+         struct WalRequestPriorityPayload change;
+         memcpy(&change, payload, sizeof(change));
+         reprioritizeRequest(change.requestId, change.priority);
+     }
+ }
+ 
+ // Replay journal.wal on top of the loaded snapshot files; each record is
+ // applied only to the files whose walLsn is older than it. Stops at the
+ // first torn or damaged record and returns the offset just before it (0 if
+ // there is no usable journal). *version gets the journal's format version.
+ long walRecover(int *replayed, int *version)
+ {
+     *replayed = 0;
+     *version = WAL_FILE_VERSION;
+     wal.lastLsn = wal.accountsLsn > wal.transactionsLsn ? wal.accountsLsn : wal.transactionsLsn;
+     wal.lastLsn = wal.requestsLsn > wal.lastLsn ? wal.requestsLsn : wal.lastLsn;
+ 
+     size_t size;
+     const unsigned char *data = mapFile(WAL_FILE_NAME, &size);
+     if (data == NULL)
+     {
+         return 0;
+     }
+ 
+     const struct DataFileHeader *fileHeader = (const struct DataFileHeader *)data;
+     if (size < sizeof(*fileHeader) ||
+         strncmp(fileHeader->magic, WAL_FILE_MAGIC, sizeof(fileHeader->magic)) != 0 ||
+         fileHeader->version < 1 || fileHeader->version > WAL_FILE_VERSION)
+     {
+         unmapFile(data, size);
+         if (rename(WAL_FILE_NAME, WAL_FILE_NAME ".corrupt") == 0)
+         {
+             printf("%s%s is not a journal this version can read; kept as %s.corrupt.%s\n",
+                    RED, WAL_FILE_NAME, WAL_FILE_NAME, RESET);
+         }
+         return 0;
+     }
+ 
+     *version = fileHeader->version;
+     size_t offset = sizeof(*fileHeader);
+     unsigned long long previousLsn = 0;
+     while (offset + sizeof(struct WalRecordHeader) <= size)
+     {
+         struct WalRecordHeader header;
+         memcpy(&header, data + offset, sizeof(header));
+         size_t recordSize = sizeof(header) + header.payloadSize;
+         if (offset + recordSize > size || header.lsn <= previousLsn ||
+             walChecksum(data + offset, recordSize) != header.checksum)
+         {
+             break;
+         }
+ 
+         bool updateAccounts = header.lsn > wal.accountsLsn;
+         bool recordHistory = header.lsn > wal.transactionsLsn;
+         bool updateRequests = header.lsn > wal.requestsLsn;
+         if (updateAccounts || recordHistory || updateRequests)
+         {
+             walReplayRecord(*version, &header, data + offset + sizeof(header), updateAccounts, recordHistory,
+                             updateRequests);
+             (*replayed)++;
+         }
+         if (header.lsn > wal.lastLsn)
+         {
+             wal.lastLsn = header.lsn;
+         }
+         previousLsn = header.lsn;
+         offset += recordSize;
+     }
+ 
+     unmapFile(data, size);
+     return (long)offset;
+ }
+ 
+ // Journal Queue Operations
+ // Take a ring for this thread, reusing one an exited thread handed back
+ struct JournalRing *acquireJournalRing()
+ {
+     for (struct JournalRing *ring = atomic_load(&journalRings); ring != NULL; ring = ring->next)
+     {
+         bool idle = false;
+         if (atomic_compare_exchange_strong(&ring->inUse, &idle, true))
+         {
+             return ring;
+         }
+     }
+ 
+     // calloc only guarantees max_align_t, so round up to the cache line the
+     // struct asks for; rings are never freed, so the original pointer can go
+     unsigned char *memory = (unsigned char *)calloc(1, sizeof(struct JournalRing) + CACHE_LINE_SIZE);
+     if (memory == NULL)
+     {
+         return NULL;
+     }
+     struct JournalRing *ring = (struct JournalRing *)(memory + CACHE_LINE_SIZE - (uintptr_t)memory % CACHE_LINE_SIZE);
+     atomic_init(&ring->tail, 0);
+     atomic_init(&ring->head, 0);
+     atomic_init(&ring->inUse, true);
+     ring->next = atomic_load(&journalRings);
+     while (!atomic_compare_exchange_weak(&journalRings, &ring->next, ring))
+     {
+     }
+     return ring;
+ }
+ 
+ // Threads that queue operations call this before they exit. Anything still
+ // queued is drained as usual.
+ void releaseJournalRing()
+ {
+     if (journalRing != NULL)
+     {
+         atomic_store(&journalRing->inUse, false);
+         journalRing = NULL;
+     }
+ }
+ 
+ bool journalEntryDue(const struct JournalEntry *entry)
+ {
+     for (int i = 0; i < entry->stripeCount; i++)
+     {
+         if (entry->sequences[i] != journalDrained[entry->stripes[i]])
+         {
+             return false;
+         }
+     }
+     return true;
+ }
+ 
+ // Move every queued operation that is due into the journal and the history.
+ // An operation waits while an earlier one on the same stripe sits in another
+ // ring; that one was queued first, so a later pass always finds it.
+ // Called with journalLock held; returns how many were drained.
+ long long drainJournalRings()
+ {
+     long long drained = 0;
+     bool progress = true;
+     while (progress)
+     {
+         progress = false;
+         for (struct JournalRing *ring = atomic_load(&journalRings); ring != NULL; ring = ring->next)
+         {
+             unsigned long long head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+             unsigned long long tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+             while (head != tail)
+             {
+                 const struct JournalEntry *entry = &ring->entries[head % JOURNAL_RING_ENTRIES];
+                 if (!journalEntryDue(entry))
+                 {
+                     break;
+                 }
+                 walAppend(entry->type, &entry->payload, sizeof(entry->payload));
+                 recordMoneyHistory(entry->type, &entry->payload);
+                 for (int i = 0; i < entry->stripeCount; i++)
+                 {
+                     journalDrained[entry->stripes[i]]++;
+                 }
+                 head++;
+                 drained++;
+                 progress = true;
+             }
+             atomic_store_explicit(&ring->head, head, memory_order_release);
+         }
+     }
+ 
+     // Commit a group whose window ran out while no new records came in
+     if (wal.pendingRecords > 0 && monotonicNow() - wal.oldestPending >= wal.groupWindow)
+     {
+         walFlush();
+     }
+     return drained;
+ }
+ 
+ bool journalRingsEmpty()
+ {
+     for (struct JournalRing *ring = atomic_load(&journalRings); ring != NULL; ring = ring->next)
+     {
+         if (atomic_load(&ring->head) != atomic_load(&ring->tail))
+         {
+             return false;
+         }
+     }
+     return true;
+ }
+ 
+ // Drain unless another thread already is
+ void tryDrainJournal()
+ {
+ #ifdef _WIN32
+     if (!TryAcquireSRWLockExclusive(&journalLock))
+ #else
+     if (pthread_mutex_trylock(&journalLock) != 0)
+ #endif
+     {
+         return;
+     }
+     drainJournalRings();
+     mutexUnlock(&journalLock);
+ }
+ 
+ // Take the journal with nothing left queued, to write a record directly or
+ // read the history. Called with every stripe held so the rings stay empty.
+ void lockJournal()
+ {
+     mutexLock(&journalLock);
+     while (!journalRingsEmpty())
+     {
+         drainJournalRings();
+     }
+ }
+ 
+ void unlockJournal()
+ {
+     mutexUnlock(&journalLock);
+ }
+ 
+ // Opening an account can grow the table's columns and rehash the index.
+ // Callers with the engine busy on other threads hold lockAllAccounts so no
+ // operation is using them; the journal drainer indexes history through
+ // them too, so the row is added with the journal held.
+ bool addAccount(int accNo, char *name, Money balance, char *address, char *phone, char *email)
+ {
+     if (balance < 0)
+     {
+         return false;
+     }
+ 
+     // Check if account already exists
+     if (idIndexFind(&accountIndex, accNo) != -1)
+     {
+         return false; // Account already exists
+     }
+ 
+     // Zero the profile so unused string bytes are stable on disk
+     struct AccountProfile profile;
+     memset(&profile, 0, sizeof(profile));
+     strcpy(profile.name, name);
+     strcpy(profile.address, address);
+     strcpy(profile.phoneNumber, phone);
+     strcpy(profile.email, email);
+     profile.createdAt = timestampNow();
+ 
+     struct AccountRecord record;
+     memset(&record, 0, sizeof(record));
+     record.accountNo = accNo;
+     record.flags = ACCOUNT_ACTIVE;
+     record.balance = balance;
+     record.profile = profile;
+ 
+     lockJournal();
+     bool added = appendAccountRow(accNo, balance, ACCOUNT_ACTIVE, &profile);
+     if (added)
+     {
+         markAccountDirty(accountTable.count - 1);
+         walAppend(WAL_ACCOUNT_OPEN, &record, sizeof(record));
+     }
+     unlockJournal();
+     return added;
+ }
+ 
+ // Queue a money operation on this thread's ring. Called with the stripes of
+ // its accounts held, so stripe sequences follow the order balances changed.
+ void queueMoneyOperation(int type, const struct WalMoneyPayload *payload)
+ {
+     if (journalRing == NULL)
+     {
+         journalRing = acquireJournalRing();
+         if (journalRing == NULL)
+         {
+             // No memory for a ring; fall back to writing it directly
+             mutexLock(&journalLock);
+             drainJournalRings();
+             walAppend(type, payload, sizeof(*payload));
+             recordMoneyHistory(type, payload);
+             mutexUnlock(&journalLock);
+             return;
+         }
+     }
+ 
+     struct JournalRing *ring = journalRing;
+     unsigned long long tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+     while (tail - atomic_load_explicit(&ring->head, memory_order_acquire) == JOURNAL_RING_ENTRIES)
+     {
+         // Full: help the drainer along, or let it run
+         tryDrainJournal();
+         yieldThread();
+     }
+ 
+     struct JournalEntry *entry = &ring->entries[tail % JOURNAL_RING_ENTRIES];
+     entry->type = type;
+     entry->payload = *payload;
+     entry->stripeCount = 0;
+     int a = accountStripe(payload->accountNo);
+     entry->stripes[entry->stripeCount] = a;
+     entry->sequences[entry->stripeCount++] = accountStripes[a].sequence++;
+     if (type == WAL_TRANSFER && accountStripe(payload->toAccountNo) != a)
+     {
+         int b = accountStripe(payload->toAccountNo);
+         entry->stripes[entry->stripeCount] = b;
+         entry->sequences[entry->stripeCount++] = accountStripes[b].sequence++;
+     }
+     atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+ 
+     // Without a drainer thread, operations go into the journal before
+     // returning, as they did before there were rings
+     if (!atomic_load_explicit(&journalDrainerRunning, memory_order_relaxed))
+     {
+         tryDrainJournal();
+     }
+ }
+ 
+ void *runJournalDrainer(void *arg)
+ {
+     (void)arg;
+     while (atomic_load(&journalDrainerRunning))
+     {
+         mutexLock(&journalLock);
+         long long drained = drainJournalRings();
+         mutexUnlock(&journalLock);
+         if (drained == 0)
+         {
+ #ifdef _WIN32
+             Sleep(0);
+ #else
+             usleep(50);
+ #endif
+         }
+     }
+     return NULL;
+ }
+ 
+ // Move journal writing to a thread of its own while many threads run
+ // operations
+ bool startJournalDrainer()
+ {
+     static struct ThreadStart start = {runJournalDrainer, NULL};
+     if (atomic_load(&journalDrainerRunning))
+     {
+         return true;
+     }
+     atomic_store(&journalDrainerRunning, true);
+     if (!startThread(&journalDrainer, &start))
+     {
+         atomic_store(&journalDrainerRunning, false);
+         return false;
+     }
+     return true;
+ }
+ 
+ void stopJournalDrainer()
+ {
+     if (!atomic_load(&journalDrainerRunning))
+     {
+         return;
+     }
+     atomic_store(&journalDrainerRunning, false);
+     joinThread(journalDrainer);
+     mutexLock(&journalLock);
+     while (!journalRingsEmpty())
+     {
+         drainJournalRings();
+     }
+     mutexUnlock(&journalLock);
+ }
+ 
+ // Write every snapshot file; returns false if accounts, transactions or
+ // service requests couldn't be saved
+ bool writeAllData()
+ {
+     // accounts.dat goes first so transactions.dat is never ahead of it; if
+     // it can't be saved the other journaled files keep their older state,
+     // and the journal is only emptied once every one is safely on disk
+     lockAllAccounts();
+     lockJournal();
+     walFlush();
+     bool accountsSaved = checkpointAccounts();
+     bool transactionsSaved = accountsSaved && saveTransactionsToFile();
+     bool requestsSaved = accountsSaved && saveRequestsToFile();
+     saveBranchesToFile();
+     if (accountsSaved && transactionsSaved && requestsSaved)
+     {
+         walCheckpoint();
+     }
+     unlockJournal();
+     unlockAllAccounts();
+     return accountsSaved && transactionsSaved && requestsSaved;
+ }
+ 
+ void saveAllData()
+ {
+     if (writeAllData())
+     {
+         printf("%sAll data saved successfully!%s\n", GREEN, RESET);
+     }
+     else
+     {
+         printf("%sSome data could not be saved; the journal still holds the changes.%s\n", RED, RESET);
+     }
+ }
+ 
+ void loadAllData()
+ {
+     // Close the journal so replaying it doesn't log the records again
+     walClose();
+     wal.accountsLsn = 0;
+     wal.transactionsLsn = 0;
+ 
+     loadAccountsFromFile();
+     loadTransactionsFromFile();
+     loadBranchesFromFile();
+     loadRequestsFromFile();
+ 
+     int replayed, version;
+     long validEnd = walRecover(&replayed, &version);
+     if (replayed > 0)
+     {
+         printf("%sRecovered %d operations from %s.%s\n", YELLOW, replayed, WAL_FILE_NAME, RESET);
+     }
+ 
+     // New records can't go into an older journal; fold it into the snapshot
+     // files and start a current one
+     if (validEnd > 0 && version < WAL_FILE_VERSION && checkpointAccounts() && saveTransactionsToFile() &&
+         saveRequestsToFile())
+     {
+         validEnd = 0;
+     }
+     walOpen(validEnd);
+ }
+ 
+ /***************************************************
+  * SECTION 4: TRANSACTION FUNCTIONS
+  ***************************************************/
+ 
+ // Apply a money operation and queue it for the journal and the history.
+ // Called with the operation's account stripes held.
+ void commitMoneyOperation(int type, const struct WalMoneyPayload *entry)
+ {
+     applyMoneyBalances(type, entry);
+     queueMoneyOperation(type, entry);
+ }
+ 
+ // Deposits, withdrawals and transfers are safe to call from many threads
+ bool deposit(int accountNo, Money amount)
+ {
+     if (!moneyAmountValid(amount))
+     {
+         return false;
+     }
+ 
+     lockAccount(accountNo);
+     int row = findAccount(accountNo);
+     bool done = row != -1 && moneyCreditFits(accountTable.balance[row], amount);
+     if (done)
+     {
+         struct WalMoneyPayload entry = {accountNo, 0, takeTransactionId(), 0, amount, timestampNow()};
+         commitMoneyOperation(WAL_DEPOSIT, &entry);
+     }
+     unlockAccount(accountNo);
+     return done;
+ }
+ 
+ bool withdraw(int accountNo, Money amount)
+ {
+     if (!moneyAmountValid(amount))
+     {
+         return false;
+     }
+ 
+     lockAccount(accountNo);
+     int row = findAccount(accountNo);
+     bool done = row != -1 && accountTable.balance[row] >= amount;
+     if (done)
+     {
+         struct WalMoneyPayload entry = {accountNo, 0, takeTransactionId(), 0, amount, timestampNow()};
+         commitMoneyOperation(WAL_WITHDRAW, &entry);
+     }
+     unlockAccount(accountNo);
+     return done;
+ }
+ 
+ bool transfer(int fromAccountNo, int toAccountNo, Money amount)
+ {
+     if (!moneyAmountValid(amount))
+     {
+         return false;
+     }
+ 
+     lockAccountPair(fromAccountNo, toAccountNo);
+     int fromRow = findAccount(fromAccountNo);
+     int toRow = findAccount(toAccountNo);
+     bool done = fromRow != -1 && toRow != -1 && accountTable.balance[fromRow] >= amount &&
+                 moneyCreditFits(accountTable.balance[toRow], amount);
+     if (done)
+     {
+         // Both sides go in one record so a transfer is replayed whole or not at all
+         long long senderId = takeTransactionId();
+         long long receiverId = takeTransactionId();
+         struct WalMoneyPayload entry = {fromAccountNo, toAccountNo, senderId, receiverId, amount, timestampNow()};
+         commitMoneyOperation(WAL_TRANSFER, &entry);
+     }
+     unlockAccountPair(fromAccountNo, toAccountNo);
+     return done;
+ }
+ 
+ int compareBatchAccountRefs(const void *a, const void *b)
+ {
+     int x = ((const struct BatchAccountRef *)a)->accountNo;
+     int y = ((const struct BatchAccountRef *)b)->accountNo;
+     return (x > y) - (x < y);
+ }
+ 
+ const char *batchStatusName(int status)
+ {
+     switch (status)
+     {
+         case BATCH_POSTED:
+             return "OK";
+         case BATCH_NO_ACCOUNT:
+             return "NO_ACCOUNT";
+         case BATCH_INSUFFICIENT_FUNDS:
+             return "INSUFFICIENT_FUNDS";
+         case BATCH_BAD_AMOUNT:
+             return "BAD_AMOUNT";
+         default:
+             return "BAD_LINE";
+     }
+ }
+ 
+ // Post many operations at once, in the order given. Each account is looked
+ // up once and each stripe the batch touches is locked once. All records go
+ // into the journal as one group with a single fsync. statuses gets a
+ // BatchStatus per operation; returns how many were posted, or -1 if there
+ // was no memory for the batch.
+ int postBatch(const struct BatchOperation *operations, int count, unsigned char *statuses)
+ {
+     int *rows = (int *)malloc(2 * (size_t)count * sizeof(int));
+     struct BatchAccountRef *refs = (struct BatchAccountRef *)malloc(2 * (size_t)count * sizeof(*refs));
+     if (rows == NULL || refs == NULL)
+     {
+         free(rows);
+         free(refs);
+         return -1;
+     }
+ 
+     // Lock every stripe the batch needs, in stripe order like lockAccountPair
+     bool held[ACCOUNT_LOCK_STRIPES] = {false};
+     int refCount = 0;
+     for (int i = 0; i < count; i++)
+     {
+         refs[refCount++] = (struct BatchAccountRef){operations[i].accountNo, i, false};
+         held[accountStripe(operations[i].accountNo)] = true;
+         if (operations[i].type == WAL_TRANSFER)
+         {
+             refs[refCount++] = (struct BatchAccountRef){operations[i].toAccountNo, i, true};
+             held[accountStripe(operations[i].toAccountNo)] = true;
+         }
+     }
+     for (int stripe = 0; stripe < ACCOUNT_LOCK_STRIPES; stripe++)
+     {
+         if (held[stripe])
+         {
+             mutexLock(&accountStripes[stripe].lock);
+         }
+     }
+ 
+     // Resolve each account once; rows[2i] is the sending or only side
+     qsort(refs, refCount, sizeof(*refs), compareBatchAccountRefs);
+     for (int i = 0; i < refCount;)
+     {
+         int row = findAccount(refs[i].accountNo);
+         int accountNo = refs[i].accountNo;
+         for (; i < refCount && refs[i].accountNo == accountNo; i++)
+         {
+             rows[2 * refs[i].operation + refs[i].receiving] = row;
+         }
+     }
+ 
+     // Apply in order, so a withdrawal can spend an earlier deposit
+     Timestamp now = timestampNow();
+     int posted = 0;
+     for (int i = 0; i < count; i++)
+     {
+         const struct BatchOperation *operation = &operations[i];
+         int row = rows[2 * i];
+         int toRow = operation->type == WAL_TRANSFER ? rows[2 * i + 1] : row;
+         if (!moneyAmountValid(operation->amount))
+         {
+             statuses[i] = BATCH_BAD_AMOUNT;
+         }
+         else if (row == -1 || toRow == -1)
+         {
+             statuses[i] = BATCH_NO_ACCOUNT;
+         }
+         else if (operation->type != WAL_DEPOSIT && accountTable.balance[row] < operation->amount)
+         {
+             statuses[i] = BATCH_INSUFFICIENT_FUNDS;
+         }
+         else if (operation->type != WAL_WITHDRAW && !moneyCreditFits(accountTable.balance[toRow], operation->amount))
+         {
+             statuses[i] = BATCH_BAD_AMOUNT; // The credit would overflow the balance
+         }
+         else
+         {
+             accountTable.balance[row] += operation->type == WAL_DEPOSIT ? operation->amount : -operation->amount;
+             markAccountDirty(row);
+             if (operation->type == WAL_TRANSFER)
+             {
+                 accountTable.balance[toRow] += operation->amount;
+                 markAccountDirty(toRow);
+             }
+             statuses[i] = BATCH_POSTED;
+             posted++;
+         }
+     }
+ 
+     // Operations queued on these stripes before the batch go first
+     mutexLock(&journalLock);
+     bool caughtUp = false;
+     while (!caughtUp)
+     {
+         drainJournalRings();
+         caughtUp = true;
+         for (int stripe = 0; stripe < ACCOUNT_LOCK_STRIPES && caughtUp; stripe++)
+         {
+             caughtUp = !held[stripe] || journalDrained[stripe] == accountStripes[stripe].sequence;
+         }
+     }
+ 
+     int groupRecords = wal.groupRecords;
+     double groupWindow = wal.groupWindow;
+     wal.groupRecords = INT_MAX;
+     wal.groupWindow = DBL_MAX;
+     for (int i = 0; i < count; i++)
+     {
+         if (statuses[i] != BATCH_POSTED)
+         {
+             continue;
+         }
+         const struct BatchOperation *operation = &operations[i];
+         struct WalMoneyPayload entry = {operation->accountNo, 0, takeTransactionId(), 0, operation->amount, now};
+         if (operation->type == WAL_TRANSFER)
+         {
+             entry.toAccountNo = operation->toAccountNo;
+             entry.toTransactionId = takeTransactionId();
+         }
+         walAppend(operation->type, &entry, sizeof(entry));
+         recordMoneyHistory(operation->type, &entry);
+     }
+     walFlush();
+     wal.groupRecords = groupRecords;
+     wal.groupWindow = groupWindow;
+     mutexUnlock(&journalLock);
+ 
+     for (int stripe = ACCOUNT_LOCK_STRIPES - 1; stripe >= 0; stripe--)
+     {
+         if (held[stripe])
+         {
+             mutexUnlock(&accountStripes[stripe].lock);
+         }
+     }
+     free(rows);
+     free(refs);
+     return posted;
+ }
+ 
+ // Parse one line of a posting file: "DEP <account> <amount>",
+ // "WDR <account> <amount>" or "XFER <from> <to> <amount>"
+ bool parsePostingLine(const char *line, struct BatchOperation *operation)
+ {
+     char command[8], first[32], second[32], third[32];
+     int fields = sscanf(line, "%7s %31s %31s %31s", command, first, second, third);
+     memset(operation, 0, sizeof(*operation));
+     if (fields == 3 && (strcmp(command, "DEP") == 0 || strcmp(command, "WDR") == 0))
+     {
+         operation->type = command[0] == 'D' ? WAL_DEPOSIT : WAL_WITHDRAW;
+         return sscanf(first, "%d", &operation->accountNo) == 1 && parseMoney(second, &operation->amount);
+     }
+     if (fields == 4 && strcmp(command, "XFER") == 0)
+     {
+         operation->type = WAL_TRANSFER;
+         return sscanf(first, "%d", &operation->accountNo) == 1 &&
+                sscanf(second, "%d", &operation->toAccountNo) == 1 &&
+                parseMoney(third, &operation->amount);
+     }
+     return false;
+ }
+ 
+ // Post one batch of a posting file and print each line's status
+ void postAndReport(const struct BatchOperation *operations, const long *lineNumbers, int count,
+                    unsigned char *statuses, long long *posted, long long *failed)
+ {
+     if (count == 0)
+     {
+         return;
+     }
+     int result = postBatch(operations, count, statuses);
+     for (int i = 0; i < count; i++)
+     {
+         printf("%ld %s\n", lineNumbers[i], batchStatusName(result < 0 ? BATCH_BAD_LINE : statuses[i]));
+     }
+     *posted += result < 0 ? 0 : result;
+     *failed += result < 0 ? count : count - result;
+ }
+ 
+ // Post a file of operations ("-" reads stdin) in batches of
+ // POSTING_BATCH_SIZE. Prints "<line> <status>" for every operation, then a
+ // summary. Blank lines and lines starting with '#' are skipped.
+ bool postBatchFile(const char *path)
+ {
+     FILE *file = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+     if (file == NULL)
+     {
+         fprintf(stderr, "Could not open %s\n", path);
+         return false;
+     }
+ 
+     struct BatchOperation *operations = (struct BatchOperation *)malloc(POSTING_BATCH_SIZE * sizeof(*operations));
+     long *lineNumbers = (long *)malloc(POSTING_BATCH_SIZE * sizeof(long));
+     unsigned char *statuses = (unsigned char *)malloc(POSTING_BATCH_SIZE);
+     if (operations == NULL || lineNumbers == NULL || statuses == NULL)
+     {
+         fprintf(stderr, "Not enough memory to post %s\n", path);
+         free(operations);
+         free(lineNumbers);
+         free(statuses);
+         if (file != stdin)
+         {
+             fclose(file);
+         }
+         return false;
+     }
+     setvbuf(stdout, NULL, _IOFBF, 1 << 16);
+ 
+     long long posted = 0, failed = 0;
+     long lineNumber = 0;
+     char line[256];
+     double start = monotonicNow();
+     bool more = true;
+     while (more)
+     {
+         int count = 0;
+         while (count < POSTING_BATCH_SIZE && (more = fgets(line, sizeof(line), file) != NULL))
+         {
+             lineNumber++;
+             const char *text = line + strspn(line, " \t");
+             if (*text == '\0' || *text == '\n' || *text == '#')
+             {
+                 continue;
+             }
+             if (!parsePostingLine(text, &operations[count]))
+             {
+                 // Results are reported in line order, so the batch so far goes first
+                 postAndReport(operations, lineNumbers, count, statuses, &posted, &failed);
+                 count = 0;
+                 printf("%ld %s\n", lineNumber, batchStatusName(BATCH_BAD_LINE));
+                 failed++;
+                 continue;
+             }
+             lineNumbers[count++] = lineNumber;
+         }
+         postAndReport(operations, lineNumbers, count, statuses, &posted, &failed);
+     }
+     double elapsed = monotonicNow() - start;
+ 
+     printf("posted=%lld failed=%lld seconds=%.3f operations_per_second=%.0f\n",
+            posted, failed, elapsed, elapsed > 0 ? (posted + failed) / elapsed : 0.0);
+     fflush(stdout);
+     free(operations);
+     free(lineNumbers);
+     free(statuses);
+     if (file != stdin)
+     {
+         fclose(file);
+     }
+     return true;
+ }
+ 
+ int transactionKindOf(const char *type)
+ {
+     if (strncmp(type, "transfer to", 11) == 0)
+     {
+         return TRANSACTION_TRANSFER_OUT;
+     }
+     if (strncmp(type, "receive from", 12) == 0)
+     {
+         return TRANSACTION_TRANSFER_IN;
+     }
+     if (strcmp(type, "withdraw") == 0)
+     {
+         return TRANSACTION_WITHDRAW;
+     }
+     return TRANSACTION_DEPOSIT;
+ }
+ 
+ void printTransactionRow(const struct Transaction *transaction, void *context)
+ {
+     (void)context;
+     char amountText[MONEY_TEXT_SIZE];
+     char dateText[TIMESTAMP_TEXT_SIZE], timeText[TIMESTAMP_TEXT_SIZE];
+     formatTimestamp(transaction->timestamp, dateText, timeText);
+     printf("%-8lld %-8d %-15s %s$%s%s %-12s %-8s\n",
+            transaction->transactionId,
+            transaction->accountNo,
+            transaction->type,
+            GREEN,
+            formatMoney(transaction->amount, amountText),
+            RESET,
+            dateText,
+            timeText);
+ }
+ 
+ void viewTransactions()
+ {
+     if (transactionStack == NULL)
+     {
+         printf("%sNo transactions to display.%s\n", YELLOW, RESET);
+         return;
+     }
+ 
+     printf("\n%s%s Transaction History %s\n", BG_GREEN, BLACK, RESET);
+     printf("%s%s%-8s %-8s %-15s %-10s %-12s %-8s %s\n", 
+            BG_CYAN, BLACK, "ID", "Account", "Type", "Amount", "Date", "Time", RESET);
+ 
+     for (struct TransactionNode *temp = transactionStack; temp != NULL; temp = temp->next)
+     {
+         printTransactionRow(&temp->data, NULL);
+     }
+ }
+ 
+ // Collect up to n of an account's latest transactions, newest first. Costs
+ // O(n) however large the bank's history is.
+ int recentAccountTransactions(int row, const struct Transaction **out, int n)
+ {
+     int found = 0;
+     for (struct TransactionHistory *chunk = accountTable.history[row]; chunk != NULL && found < n; chunk = chunk->older)
+     {
+         for (int i = chunk->count - 1; i >= 0 && found < n; i--)
+         {
+             out[found++] = &chunk->entries[i]->data;
+         }
+     }
+     return found;
+ }
+ 
+ void viewAccountTransactions(int accountNo)
+ {
+     if (transactionStack == NULL)
+     {
+         printf("%sNo transactions to display.%s\n", YELLOW, RESET);
+         return;
+     }
+     
+     int row = findAccount(accountNo);
+     if (row == -1)
+     {
+         printf("%sAccount not found.%s\n", RED, RESET);
+         return;
+     }
+ 
+     printf("\n%s%s Transaction History for Account %d - %s %s\n", 
+            BG_GREEN, BLACK, accountNo, accountProfile(row)->name, RESET);
+     printf("%s%s%-8s %-15s %-10s %-12s %-8s %s\n", 
+            BG_CYAN, BLACK, "ID", "Type", "Amount", "Date", "Time", RESET);
+ 
+     // Walk the account's own chain rather than the whole bank's history
+     bool found = false;
+     char amountText[MONEY_TEXT_SIZE];
+     char dateText[TIMESTAMP_TEXT_SIZE], timeText[TIMESTAMP_TEXT_SIZE];
+     for (struct TransactionHistory *chunk = accountTable.history[row]; chunk != NULL; chunk = chunk->older)
+     {
+         for (int i = chunk->count - 1; i >= 0; i--)
+         {
+             const struct Transaction *transaction = &chunk->entries[i]->data;
+             formatTimestamp(transaction->timestamp, dateText, timeText);
+             printf("%-8lld %-15s %s$%s%s %-12s %-8s\n",
+                    transaction->transactionId,
+                    transaction->type,
+                    GREEN,
+                    formatMoney(transaction->amount, amountText),
+                    RESET,
+                    dateText,
+                    timeText);
+             found = true;
+         }
+     }
+     
+     if (!found)
+     {
+         printf("%sNo transactions found for this account.%s\n", YELLOW, RESET);
+     }
+ }
+ 
+ // Transactions from the start of one local day to the end of another
+ void viewTransactionsBetween(int fromYear, int fromMonth, int fromDay, int toYear, int toMonth, int toDay)
+ {
+     Timestamp from = timestampFromDate(fromYear, fromMonth, fromDay);
+     Timestamp to = timestampFromDate(toYear, toMonth, toDay + 1);
+ 
+     printf("\n%s%s Transactions %04d-%02d-%02d to %04d-%02d-%02d %s\n",
+            BG_GREEN, BLACK, fromYear, fromMonth, fromDay, toYear, toMonth, toDay, RESET);
+     printf("%s%s%-8s %-8s %-15s %-10s %-12s %-8s %s\n",
+            BG_CYAN, BLACK, "ID", "Account", "Type", "Amount", "Date", "Time", RESET);
+     if (forEachTransactionBetween(from, to, printTransactionRow, NULL) == 0)
+     {
+         printf("%sNo transactions in this period.%s\n", YELLOW, RESET);
+     }
+ }
+ 
+ // Money in and out over a statement period
+ struct StatementTotals
+ {
+     Money credits;
+     Money debits;
+     bool print;
+ };
+ 
+ void addToStatement(const struct Transaction *transaction, void *context)
+ {
+     struct StatementTotals *totals = (struct StatementTotals *)context;
+     int kind = transactionKindOf(transaction->type);
+     if (kind == TRANSACTION_DEPOSIT || kind == TRANSACTION_TRANSFER_IN)
+     {
+         totals->credits += transaction->amount;
+     }
+     else
+     {
+         totals->debits += transaction->amount;
+     }
+ 
+     if (totals->print)
+     {
+         char amountText[MONEY_TEXT_SIZE];
+         char dateText[TIMESTAMP_TEXT_SIZE], timeText[TIMESTAMP_TEXT_SIZE];
+         formatTimestamp(transaction->timestamp, dateText, timeText);
+         printf("%-8lld %-15s %s$%s%s %-12s %-8s\n",
+                transaction->transactionId,
+                transaction->type,
+                GREEN,
+                formatMoney(transaction->amount, amountText),
+                RESET,
+                dateText,
+                timeText);
+     }
+ }
+ 
+ // Statement for one calendar month. The balances at either end are worked
+ // back from the current balance using only the transactions since then.
+ void viewAccountStatement(int accountNo, int year, int month)
+ {
+     int row = findAccount(accountNo);
+     if (row == -1)
+     {
+         printf("%sAccount not found.%s\n", RED, RESET);
+         return;
+     }
+     if (month < 1 || month > 12)
+     {
+         printf("%sInvalid month.%s\n", RED, RESET);
+         return;
+     }
+ 
+     Timestamp from = timestampFromDate(year, month, 1);
+     Timestamp to = timestampFromDate(year, month + 1, 1);
+     struct StatementTotals later = {0, 0, false};
+     forEachAccountTransactionBetween(row, to, LLONG_MAX, addToStatement, &later);
+ 
+     printf("\n%s%s Statement for Account %d - %s, %04d-%02d %s\n",
+            BG_GREEN, BLACK, accountNo, accountProfile(row)->name, year, month, RESET);
+     printf("%s%s%-8s %-15s %-10s %-12s %-8s %s\n",
+            BG_CYAN, BLACK, "ID", "Type", "Amount", "Date", "Time", RESET);
+     struct StatementTotals period = {0, 0, true};
+     if (forEachAccountTransactionBetween(row, from, to, addToStatement, &period) == 0)
+     {
+         printf("%sNo transactions in this month.%s\n", YELLOW, RESET);
+     }
+ 
+     Money closing = accountTable.balance[row] - later.credits + later.debits;
+     Money opening = closing - period.credits + period.debits;
+     char text[MONEY_TEXT_SIZE];
+     printf("%sOpening balance:%s $%s\n", CYAN, RESET, formatMoney(opening, text));
+     printf("%sMoney in:%s        $%s\n", CYAN, RESET, formatMoney(period.credits, text));
+     printf("%sMoney out:%s       $%s\n", CYAN, RESET, formatMoney(period.debits, text));
+     printf("%sClosing balance:%s $%s\n", CYAN, RESET, formatMoney(closing, text));
+ }
+ 
+ void viewTransactionById(long long transactionId)
+ {
+     const struct Transaction *transaction = findTransaction(transactionId);
+     if (transaction == NULL)
+     {
+         printf("%sTransaction not found.%s\n", RED, RESET);
+         return;
+     }
+ 
+     char amountText[MONEY_TEXT_SIZE];
+     char dateText[TIMESTAMP_TEXT_SIZE], timeText[TIMESTAMP_TEXT_SIZE];
+     formatTimestamp(transaction->timestamp, dateText, timeText);
+     printf("\n%s%s Transaction %lld %s\n", BG_GREEN, BLACK, transactionId, RESET);
+     printf("%sAccount: %d%s\n", CYAN, transaction->accountNo, RESET);
+     printf("%sType: %s%s\n", CYAN, transaction->type, RESET);
+     printf("%sAmount: %s$%s%s\n", CYAN, GREEN, formatMoney(transaction->amount, amountText), RESET);
+     printf("%sDate: %s %s%s\n", CYAN, dateText, timeText, RESET);
+ }
+ 
+ // Reverse the newest transaction; *undone gets it. Returns false if there
+ // was nothing to undo.
+ bool undoLast(struct Transaction *undone)
+ {
+     lockAllAccounts();
+     lockJournal();
+     bool any = transactionStack != NULL;
+     if (any)
+     {
+         // Logged after applying, since replay needs the number of entries popped
+         struct WalUndoPayload entry;
+         entry.popped = applyUndo(undone);
+         walAppend(WAL_UNDO, &entry, sizeof(entry));
+     }
+     unlockJournal();
+     unlockAllAccounts();
+     return any;
+ }
+ 
+ bool undoLastTransaction()
+ {
+     struct Transaction lastTrans;
+     if (!undoLast(&lastTrans))
+     {
+         return false;
+     }
+ 
+     if (findAccount(lastTrans.accountNo) == -1)
+     {
+         return false;
+     }
+ 
+     char amountText[MONEY_TEXT_SIZE];
+     printf("%sLast transaction undone: %s of $%s for account %d%s\n",
+            GREEN, lastTrans.type, formatMoney(lastTrans.amount, amountText), lastTrans.accountNo, RESET);
+     return true;
+ }
+ 
+ // Aggregation kernels over contiguous columns. They are kept as plain
+ // branch-free loops so the compiler can vectorize them.
+ Money sumMoney(const Money *values, int count)
+ {
+     Money total = 0;
+     for (int i = 0; i < count; i++)
+     {
+         total += values[i];
+     }
+     return total;
+ }
+ 
+ void sumMoneyBySign(const Money *values, int count, Money *credit, Money *overdrawn)
+ {
+     Money positive = 0;
+     Money negative = 0;
+     for (int i = 0; i < count; i++)
+     {
+         Money signMask = values[i] >> 63; // All ones for negative values
+         positive += values[i] & ~signMask;
+         negative += values[i] & signMask;
+     }
+     *credit = positive;
+     *overdrawn = negative;
+ }
+ 
+ void sumMoneyByKind(const unsigned char *kinds, const Money *amounts, int count, Money totals[TRANSACTION_KIND_COUNT])
+ {
+     // One masked pass per kind vectorizes where a scatter into totals[] would not
+     for (int k = 0; k < TRANSACTION_KIND_COUNT; k++)
+     {
+         Money total = 0;
+         for (int i = 0; i < count; i++)
+         {
+             total += amounts[i] & -(Money)(kinds[i] == k);
+         }
+         totals[k] = total;
+     }
+ }
+ 
+ void viewReconciliationReport()
+ {
+     // Balances are summed straight off the table's column; transactions are
+     // gathered into columns first
+     int accountCount = accountTable.count;
+     const Money *balances = accountTable.balance;
+     int transactionCount = transactionPool.liveCount;
+     Money *amounts = (Money *)malloc(sizeof(Money) * (transactionCount + 1));
+     unsigned char *kinds = (unsigned char *)malloc(transactionCount + 1);
+     if (amounts == NULL || kinds == NULL)
+     {
+         printf("%sNot enough memory for the reconciliation report.%s\n", RED, RESET);
+         free(amounts);
+         free(kinds);
+         return;
+     }
+ 
+     int n = 0;
+     for (struct TransactionNode *node = transactionStack; node != NULL; node = node->next)
+     {
+         amounts[n] = node->data.amount;
+         kinds[n] = (unsigned char)transactionKindOf(node->data.type);
+         n++;
+     }
+ 
+     Money total = sumMoney(balances, accountCount);
+     Money credit, overdrawn;
+     sumMoneyBySign(balances, accountCount, &credit, &overdrawn);
+     Money byKind[TRANSACTION_KIND_COUNT];
+     sumMoneyByKind(kinds, amounts, transactionCount, byKind);
+ 
+     char text[MONEY_TEXT_SIZE];
+     printf("\n%s%s End-of-Day Reconciliation %s\n", BG_GREEN, BLACK, RESET);
+     printf("%sAccounts:%s                %d\n", CYAN, RESET, accountCount);
+     printf("%sCustomer balances:%s       $%s\n", CYAN, RESET, formatMoney(total, text));
+     printf("%s  In credit:%s             $%s\n", CYAN, RESET, formatMoney(credit, text));
+     printf("%s  Overdrawn:%s             $%s\n", CYAN, RESET, formatMoney(overdrawn, text));
+     printf("%sTransactions:%s            %d\n", CYAN, RESET, transactionCount);
+     printf("%sDeposits:%s                $%s\n", CYAN, RESET, formatMoney(byKind[TRANSACTION_DEPOSIT], text));
+     printf("%sWithdrawals:%s             $%s\n", CYAN, RESET, formatMoney(byKind[TRANSACTION_WITHDRAW], text));
+     printf("%sTransfers out:%s           $%s\n", CYAN, RESET, formatMoney(byKind[TRANSACTION_TRANSFER_OUT], text));
+     printf("%sTransfers in:%s            $%s\n", CYAN, RESET, formatMoney(byKind[TRANSACTION_TRANSFER_IN], text));
+     printf("%sNet cash flow:%s           $%s\n", CYAN, RESET,
+            formatMoney(byKind[TRANSACTION_DEPOSIT] - byKind[TRANSACTION_WITHDRAW], text));
+ 
+     if (byKind[TRANSACTION_TRANSFER_OUT] == byKind[TRANSACTION_TRANSFER_IN])
+     {
+         printf("%sTransfers balance.%s\n", GREEN, RESET);
+     }
+     else
+     {
+         printf("%sTransfers do not balance!%s\n", RED, RESET);
+     }
+ 
+     free(amounts);
+     free(kinds);
+ }
+ /***************************************************
+ * SECTION 5: CUSTOMER SERVICE FUNCTIONS
+ ***************************************************/
+
+int getNextRequestId()
+{
+    return ++lastRequestId;
+}
+
+// Returns the new request's ID, or -1 if the account doesn't exist or the
+// request couldn't be queued
+int submitServiceRequest(int accountNo, char *requestType, char *description, int priority)
+{
+    if (findAccount(accountNo) == -1)
+    {
+        return -1;
+    }
+
+    struct ServiceRequest request;
+    request.requestId = getNextRequestId();
+    request.accountNo = accountNo;
+    strcpy(request.requestType, requestType);
+    strcpy(request.description, description);
+    request.isProcessed = false;
+    request.priority = priority;
+    request.submittedAt = timestampNow();
+    
+    if (!enqueueRequest(request))
+    {
+        return -1;
+    }
+    return request.requestId;
+}
+
+void processNextRequest()
+{
+    if (serviceQueue.count == 0)
+    {
+        printf("%sNo pending service requests.%s\n", YELLOW, RESET);
+        return;
+    }
+    
+    struct ServiceRequest request = dequeueRequest();
+    int row = findAccount(request.accountNo);
+    
+    printf("\n%s%s Processing Service Request %s\n", BG_GREEN, BLACK, RESET);
+    printf("%sRequest ID: %d%s\n", CYAN, request.requestId, RESET);
+    printf("%sAccount: %d - %s%s\n", CYAN, request.accountNo, 
+           row != -1 ? accountProfile(row)->name : "Unknown Account", RESET);
+    printf("%sType: %s%s\n", CYAN, request.requestType, RESET);
+    printf("%sPriority: %d/5%s\n", CYAN, request.priority, RESET);
+    printf("%sDescription: %s%s\n", CYAN, request.description, RESET);
+    char dateText[TIMESTAMP_TEXT_SIZE];
+    formatTimestamp(request.submittedAt, dateText, NULL);
+    printf("%sDate Submitted: %s%s\n", CYAN, dateText, RESET);
+    
+    printf("\n%sRequest has been marked as processed.%s\n", GREEN, RESET);
+}
+
+int compareRequestNodes(const void *a, const void *b)
+{
+    const struct RequestNode *x = *(const struct RequestNode *const *)a;
+    const struct RequestNode *y = *(const struct RequestNode *const *)b;
+    return requestBefore(x, y) ? -1 : requestBefore(y, x) ? 1 : 0;
+}
+
+// Lists the queue in the order it will be served
+void viewPendingRequests()
+{
+    if (serviceQueue.count == 0)
+    {
+        printf("%sNo pending service requests.%s\n", YELLOW, RESET);
+        return;
+    }
+    
+    struct RequestNode **ordered = (struct RequestNode **)malloc(serviceQueue.count * sizeof(*ordered));
+    if (ordered == NULL)
+    {
+        printf("%sNot enough memory to list the requests.%s\n", RED, RESET);
+        return;
+    }
+    memcpy(ordered, serviceQueue.heap, serviceQueue.count * sizeof(*ordered));
+    qsort(ordered, serviceQueue.count, sizeof(*ordered), compareRequestNodes);
+    
+    printf("\n%s%s Pending Service Requests %s\n", BG_GREEN, BLACK, RESET);
+    printf("%s%s%-5s %-8s %-15s %-15s %-12s %s\n", 
+           BG_CYAN, BLACK, "ID", "Account", "Type", "Priority", "Date", RESET);
+    
+    char dateText[TIMESTAMP_TEXT_SIZE];
+    for (int i = 0; i < serviceQueue.count; i++)
+    {
+        const struct RequestNode *node = ordered[i];
+        formatTimestamp(node->submittedAt, dateText, NULL);
+        printf("%-5d %-8d %-15s %-15d %-12s\n",
+               node->requestId,
+               node->accountNo,
+               node->text,
+               node->priority,
+               dateText);
+    }
+    free(ordered);
+}
+
+void cancelServiceRequest(int requestId)
+{
+    struct ServiceRequest cancelled;
+    if (!cancelRequest(requestId, &cancelled))
+    {
+        printf("%sNo pending request with ID %d.%s\n", RED, requestId, RESET);
+        return;
+    }
+    printf("%sRequest %d (%s for account %d) has been cancelled.%s\n",
+           GREEN, cancelled.requestId, cancelled.requestType, cancelled.accountNo, RESET);
+}
+
+void changeRequestPriority(int requestId, int priority)
+{
+    if (!reprioritizeRequest(requestId, priority))
+    {
+        printf("%sNo pending request with ID %d.%s\n", RED, requestId, RESET);
+        return;
+    }
+    printf("%sRequest %d now has priority %d/5.%s\n", GREEN, requestId, priority, RESET);
+}
+
+// Request Pool Operations
+// Put a strand on the back of a worker's deque
+void pushStrand(struct RequestWorker *worker, int strand)
+{
+    mutexLock(&worker->lock);
+    worker->deque[(worker->first + worker->count++) % servicePool.dequeCapacity] = strand;
+    mutexUnlock(&worker->lock);
+}
+
+// Next strand for a worker: the front of its own deque, or else the back of
+// another worker's. Returns -1 if every deque is empty.
+int takeStrand(struct RequestWorker *worker)
+{
+    int strand = -1;
+    mutexLock(&worker->lock);
+    if (worker->count > 0)
+    {
+        strand = worker->deque[worker->first];
+        worker->first = (worker->first + 1) % servicePool.dequeCapacity;
+        worker->count--;
+    }
+    mutexUnlock(&worker->lock);
+
+    for (int i = 1; i < servicePool.workerCount && strand == -1; i++)
+    {
+        struct RequestWorker *victim = &servicePool.workers[(worker->index + i) % servicePool.workerCount];
+        mutexLock(&victim->lock);
+        if (victim->count > 0)
+        {
+            strand = victim->deque[(victim->first + --victim->count) % servicePool.dequeCapacity];
+            worker->stolen++;
+        }
+        mutexUnlock(&victim->lock);
+    }
+    return strand;
+}
+
+// Hand a request to the strand of its account, scheduling the strand on
+// the worker its account hashes to if it was idle
+bool dispatchRequest(const struct ServiceRequest *request)
+{
+    mutexLock(&servicePool.strandLock);
+    int strand = idIndexFind(&servicePool.strandIndex, request->accountNo);
+    if (strand == -1)
+    {
+        if (servicePool.strandCount == servicePool.strandCapacity)
+        {
+            int capacity = servicePool.strandCapacity == 0 ? 64 : servicePool.strandCapacity * 2;
+            struct RequestStrand *strands = (struct RequestStrand *)realloc(servicePool.strands, capacity * sizeof(*strands));
+            if (strands == NULL)
+            {
+                mutexUnlock(&servicePool.strandLock);
+                return false;
+            }
+            servicePool.strands = strands;
+            servicePool.strandCapacity = capacity;
+        }
+        strand = servicePool.strandCount;
+        if (!idIndexInsert(&servicePool.strandIndex, request->accountNo, strand))
+        {
+            mutexUnlock(&servicePool.strandLock);
+            return false;
+        }
+        servicePool.strands[servicePool.strandCount++] = (struct RequestStrand){request->accountNo, false, NULL, NULL};
+    }
+
+    struct RequestTask *task = (struct RequestTask *)poolAlloc(&requestTaskPool);
+    if (task == NULL)
+    {
+        mutexUnlock(&servicePool.strandLock);
+        return false;
+    }
+    task->request = *request;
+    task->dispatchedAt = monotonicNow();
+    task->next = NULL;
+    struct RequestStrand *s = &servicePool.strands[strand];
+    if (s->tail != NULL)
+    {
+        s->tail->next = task;
+    }
+    else
+    {
+        s->head = task;
+    }
+    s->tail = task;
+    atomic_fetch_add(&servicePool.inFlight, 1);
+
+    if (!s->scheduled)
+    {
+        s->scheduled = true;
+        pushStrand(&servicePool.workers[hashId(request->accountNo) % servicePool.workerCount], strand);
+    }
+    mutexUnlock(&servicePool.strandLock);
+    return true;
+}
+
+void *runRequestWorker(void *arg)
+{
+    struct RequestWorker *worker = (struct RequestWorker *)arg;
+    while (true)
+    {
+        int strand = takeStrand(worker);
+        if (strand == -1)
+        {
+            if (!atomic_load(&servicePool.dispatching) && atomic_load(&servicePool.inFlight) == 0)
+            {
+                break;
+            }
+            yieldThread();
+            continue;
+        }
+
+        // One request per turn, so a busy account doesn't hold a worker
+        mutexLock(&servicePool.strandLock);
+        struct RequestStrand *s = &servicePool.strands[strand];
+        struct RequestTask *task = s->head;
+        s->head = task->next;
+        if (s->head == NULL)
+        {
+            s->tail = NULL;
+        }
+        mutexUnlock(&servicePool.strandLock);
+
+        double started = monotonicNow();
+        worker->waits[worker->processed] = started - task->dispatchedAt;
+        servicePool.handler(&task->request, worker->index, servicePool.context);
+        worker->busySeconds += monotonicNow() - started;
+        worker->processed++;
+
+        // The strand is still scheduled, so no one else has touched its
+        // head; requeue it behind the strands already waiting, or retire it
+        mutexLock(&servicePool.strandLock);
+        poolFree(&requestTaskPool, task);
+        s = &servicePool.strands[strand];
+        if (s->head != NULL)
+        {
+            pushStrand(worker, strand);
+        }
+        else
+        {
+            s->scheduled = false;
+        }
+        mutexUnlock(&servicePool.strandLock);
+        atomic_fetch_sub(&servicePool.inFlight, 1);
+    }
+    return NULL;
+}
+
+// Process every queued service request on workerCount threads, in priority
+// order as far as the workers keep up, and each account's requests one at a
+// time in that order. Fills stats if it isn't NULL. Returns false if the
+// pool couldn't be started; any requests not handed out stay queued.
+bool processRequestsInPool(int workerCount, RequestHandler handler, void *context, struct RequestPoolStats *stats)
+{
+    if (workerCount < 1)
+    {
+        workerCount = 1;
+    }
+    if (workerCount > REQUEST_POOL_MAX_WORKERS)
+    {
+        workerCount = REQUEST_POOL_MAX_WORKERS;
+    }
+    int total = serviceQueue.count;
+    int window = REQUEST_POOL_WINDOW * workerCount;
+
+    memset(&servicePool, 0, sizeof(servicePool));
+    servicePool.workerCount = workerCount;
+    servicePool.dequeCapacity = window;
+    servicePool.handler = handler;
+    servicePool.context = context;
+    mutexInit(&servicePool.strandLock);
+    atomic_store(&servicePool.dispatching, true);
+
+    bool ready = true;
+    for (int i = 0; i < workerCount; i++)
+    {
+        struct RequestWorker *worker = &servicePool.workers[i];
+        mutexInit(&worker->lock);
+        worker->index = i;
+        worker->deque = (int *)malloc(window * sizeof(int));
+        worker->waits = (double *)malloc((total + 1) * sizeof(double));
+        ready = ready && worker->deque != NULL && worker->waits != NULL;
+    }
+
+    int started = 0;
+    while (ready && started < workerCount)
+    {
+        struct RequestWorker *worker = &servicePool.workers[started];
+        worker->start = (struct ThreadStart){runRequestWorker, worker};
+        if (!startThread(&worker->thread, &worker->start))
+        {
+            break;
+        }
+        started++;
+    }
+
+    double start = monotonicNow();
+    int maxInFlight = 0;
+    while (started > 0 && serviceQueue.count > 0)
+    {
+        int inFlight = atomic_load(&servicePool.inFlight);
+        if (inFlight >= window)
+        {
+            yieldThread();
+            continue;
+        }
+        maxInFlight = inFlight + 1 > maxInFlight ? inFlight + 1 : maxInFlight;
+        struct ServiceRequest request = dequeueRequest();
+        if (!dispatchRequest(&request))
+        {
+            enqueueRequest(request);
+            break;
+        }
+    }
+    atomic_store(&servicePool.dispatching, false);
+    for (int i = 0; i < started; i++)
+    {
+        joinThread(servicePool.workers[i].thread);
+    }
+    double seconds = monotonicNow() - start;
+
+    if (stats != NULL)
+    {
+        memset(stats, 0, sizeof(*stats));
+        stats->workers = started;
+        stats->startDepth = total;
+        stats->maxInFlight = maxInFlight;
+        stats->seconds = seconds;
+        for (int i = 0; i < started; i++)
+        {
+            stats->processed += servicePool.workers[i].processed;
+            stats->workerProcessed[i] = servicePool.workers[i].processed;
+            stats->workerStolen[i] = servicePool.workers[i].stolen;
+            stats->workerBusy[i] = servicePool.workers[i].busySeconds;
+        }
+        double *waits = stats->processed > 0 ? (double *)malloc(stats->processed * sizeof(double)) : NULL;
+        if (waits != NULL)
+        {
+            long long count = 0;
+            for (int i = 0; i < started; i++)
+            {
+                memcpy(waits + count, servicePool.workers[i].waits, servicePool.workers[i].processed * sizeof(double));
+                count += servicePool.workers[i].processed;
+            }
+            qsort(waits, count, sizeof(double), compareLatencies);
+            stats->waitP50 = latencyPercentile(waits, count, 50);
+            stats->waitP99 = latencyPercentile(waits, count, 99);
+            stats->waitMax = waits[count - 1];
+            free(waits);
+        }
+    }
+
+    for (int i = 0; i < workerCount; i++)
+    {
+        free(servicePool.workers[i].deque);
+        free(servicePool.workers[i].waits);
+    }
+    free(servicePool.strands);
+    idIndexClear(&servicePool.strandIndex);
+    poolReset(&requestTaskPool);
+    return started > 0;
+}
+
+void printRequestPoolStats(const struct RequestPoolStats *stats)
+{
+    printf("%d workers processed %lld of %d queued requests in %.3f s (%.0f/s)\n",
+           stats->workers, stats->processed, stats->startDepth, stats->seconds,
+           stats->seconds > 0 ? stats->processed / stats->seconds : 0.0);
+    printf("Most in flight: %d; wait in pool p50 %.1f us, p99 %.1f us, max %.1f us\n",
+           stats->maxInFlight, stats->waitP50 * 1e6, stats->waitP99 * 1e6, stats->waitMax * 1e6);
+    printf("%-8s %-10s %-10s %-10s %-8s\n", "Worker", "Processed", "Per sec", "Stolen", "Busy");
+    for (int i = 0; i < stats->workers; i++)
+    {
+        printf("%-8d %-10lld %-10.0f %-10lld %-7.0f%%\n", i, stats->workerProcessed[i],
+               stats->seconds > 0 ? stats->workerProcessed[i] / stats->seconds : 0.0,
+               stats->workerStolen[i], stats->seconds > 0 ? 100.0 * stats->workerBusy[i] / stats->seconds : 0.0);
+    }
+}
+
+void printProcessedRequest(const struct ServiceRequest *request, int worker, void *context)
+{
+    (void)context;
+    printf("%sWorker %d: request %d for account %d (%s, priority %d) processed.%s\n",
+           CYAN, worker, request->requestId, request->accountNo, request->requestType, request->priority, RESET);
+}
+
+void processAllRequests(int workerCount)
+{
+    if (serviceQueue.count == 0)
+    {
+        printf("%sNo pending service requests.%s\n", YELLOW, RESET);
+        return;
+    }
+    struct RequestPoolStats stats;
+    if (!processRequestsInPool(workerCount, printProcessedRequest, NULL, &stats))
+    {
+        printf("%sCould not start the worker pool.%s\n", RED, RESET);
+        return;
+    }
+    printf("\n");
+    printRequestPoolStats(&stats);
+}
+
+/***************************************************
+ * SECTION 6: BRANCH MANAGEMENT FUNCTIONS
+ ***************************************************/
+
+void viewAllBranches()
+{
+    if (branchCount == 0)
+    {
+        printf("%sNo branches available.%s\n", YELLOW, RESET);
+        return;
+    }
+
+    printf("\n%s%s Bank Branches %s\n", BG_GREEN, BLACK, RESET);
+    printf("%s%s%-5s %-15s %-20s %-15s %-15s %s\n", 
+           BG_CYAN, BLACK, "ID", "Name", "Location", "Manager", "Phone", RESET);
+
+    for (int i = 0; i < branchCount; i++)
+    {
+        printf("%-5d %-15s %-20s %-15s %-15s\n",
+               branchGraph[i].data.branchId,
+               branchGraph[i].data.branchName,
+               branchGraph[i].data.location,
+               branchGraph[i].data.managerName,
+               branchGraph[i].data.phoneNumber);
+    }
+}
+
+void viewBranchConnections(int branchId)
+{
+    int index = findBranchIndex(branchId);
+    if (index == -1)
+    {
+        printf("%sBranch not found.%s\n", RED, RESET);
+        return;
+    }
+
+    printf("\n%s%s Connections for Branch: %s %s\n", 
+           BG_GREEN, BLACK, branchGraph[index].data.branchName, RESET);
+    printf("%s%s%-5s %-15s %-10s %s\n", 
+           BG_CYAN, BLACK, "ID", "Name", "Distance", RESET);
+
+    struct EdgeList *edge = branchGraph[index].connections;
+    if (edge == NULL)
+    {
+        printf("%sNo connections for this branch.%s\n", YELLOW, RESET);
+        return;
+    }
+
+    while (edge != NULL)
+    {
+        int targetIndex = findBranchIndex(edge->branchId);
+        if (targetIndex != -1)
+        {
+            printf("%-5d %-15s %-10.2f\n",
+                   branchGraph[targetIndex].data.branchId,
+                   branchGraph[targetIndex].data.branchName,
+                   edge->distance);
+        }
+        edge = edge->next;
+    }
+}
+
+// Build the route hierarchy so routes on a large network don't search it
+// end to end. It is saved with the branches and dropped by any change to
+// them until built again.
+void prepareBranchRoutes()
+{
+    if (branchCount == 0)
+    {
+        printf("%sNo branches available.%s\n", YELLOW, RESET);
+        return;
+    }
+    double start = monotonicNow();
+    if (!buildRouteHierarchy())
+    {
+        printf("%sNot enough memory to prepare routes; they will be searched directly.%s\n", RED, RESET);
+        return;
+    }
+    printf("%sRoutes prepared for %d branches in %.1f seconds (%d links).%s\n", GREEN, branchCount,
+           monotonicNow() - start, routeHierarchy.upCount + routeHierarchy.downCount, RESET);
+    if (branchCount <= ROUTE_MATRIX_MAX_BRANCHES)
+    {
+        printf("%sNetworks this small answer routes from the route matrix; the hierarchy is kept for when it grows.%s\n",
+               YELLOW, RESET);
+    }
+}
+
+/***************************************************
+ * SECTION 7: UI FUNCTIONS
+ ***************************************************/
+
+void clearScreen()
+{
+    #ifdef _WIN32
+        system("cls");
+    #else
+        system("clear");
+    #endif
+}
+
+void displayBanner()
+{
+    printf("\n%s%s =============================================== %s\n", BG_BLUE, WHITE, RESET);
+    printf("%s%s                                               %s\n", BG_BLUE, WHITE, RESET);
+    printf("%s%s      ENHANCED BANK MANAGEMENT SYSTEM          %s\n", BG_BLUE, WHITE, RESET);
+    printf("%s%s                                               %s\n", BG_BLUE, WHITE, RESET);
+    printf("%s%s =============================================== %s\n", BG_BLUE, WHITE, RESET);
+    
+    // Display logged-in user
+    if (strlen(currentUser.username) > 0)
+    {
+        printf("\n%sLogged in as:%s %s%s%s (%s)%s\n", 
+               CYAN, RESET, BOLD, currentUser.username, RESET,
+               currentUser.isAdmin ? "Administrator" : "Regular User", RESET);
+    }
+}
+
+void pauseExecution()
+{
+    printf("\n%sPress Enter to continue...%s", YELLOW, RESET);
+    while (getchar() != '\n'); // Clear input buffer
+    getchar(); // Wait for Enter
+}
+
+void displayAdminMenu()
+{
+    clearScreen();
+    displayBanner();
+    
+    printf("\n%s%s ADMIN MENU %s\n", BG_CYAN, BLACK, RESET);
+    printf("%s 1. Account Management %s\n", YELLOW, RESET);
+    printf("%s 2. Transaction Management %s\n", YELLOW, RESET);
+    printf("%s 3. Service Request Management %s\n", YELLOW, RESET);
+    printf("%s 4. Branch Management %s\n", YELLOW, RESET);
+    printf("%s 5. User Management %s\n", YELLOW, RESET);
+    printf("%s 6. Save/Load Data %s\n", YELLOW, RESET);
+    printf("%s 7. Logout %s\n", YELLOW, RESET);
+    printf("%s 8. Exit %s\n", RED, RESET);
+    printf("\n%sEnter your choice: %s", GREEN, RESET);
+}
+
+void displayUserMenu()
+{
+    clearScreen();
+    displayBanner();
+    
+    printf("\n%s%s USER MENU %s\n", BG_CYAN, BLACK, RESET);
+    printf("%s 1. View Account Details %s\n", YELLOW, RESET);
+    printf("%s 2. Make a Transaction %s\n", YELLOW, RESET);
+    printf("%s 3. Submit Service Request %s\n", YELLOW, RESET);
+    printf("%s 4. View Branch Information %s\n", YELLOW, RESET);
+    printf("%s 5. Logout %s\n", YELLOW, RESET);
+    printf("%s 6. Exit %s\n", RED, RESET);
+    printf("\n%sEnter your choice: %s", GREEN, RESET);
+}
+
+void displayAccountMenu()
+{
+    clearScreen();
+    displayBanner();
+    
+    printf("\n%s%s ACCOUNT MANAGEMENT %s\n", BG_CYAN, BLACK, RESET);
+    printf("%s 1. Create New Account %s\n", YELLOW, RESET);
+    printf("%s 2. View All Accounts %s\n", YELLOW, RESET);
+    printf("%s 3. Search Account by Number %s\n", YELLOW, RESET);
+    printf("%s 4. Update Account Details %s\n", YELLOW, RESET);
+    printf("%s 5. Delete Account %s\n", YELLOW, RESET);
+    printf("%s 6. Return to Main Menu %s\n", YELLOW, RESET);
+    printf("\n%sEnter your choice: %s", GREEN, RESET);
+}
+
+void displayTransactionMenu()
+{
+    clearScreen();
+    displayBanner();
+    
+    printf("\n%s%s TRANSACTION MANAGEMENT %s\n", BG_CYAN, BLACK, RESET);
+    printf("%s 1. Deposit %s\n", YELLOW, RESET);
+    printf("%s 2. Withdraw %s\n", YELLOW, RESET);
+    printf("%s 3. Transfer %s\n", YELLOW, RESET);
+    printf("%s 4. View All Transactions %s\n", YELLOW, RESET);
+    printf("%s 5. View Account Transactions %s\n", YELLOW, RESET);
+    printf("%s 6. Undo Last Transaction %s\n", YELLOW, RESET);
+    printf("%s 7. End-of-Day Reconciliation %s\n", YELLOW, RESET);
+    printf("%s 8. Find Transaction by ID %s\n", YELLOW, RESET);
+    printf("%s 9. View Transactions Between Dates %s\n", YELLOW, RESET);
+    printf("%s 10. Monthly Account Statement %s\n", YELLOW, RESET);
+    printf("%s 11. Return to Main Menu %s\n", YELLOW, RESET);
+    printf("\n%sEnter your choice: %s", GREEN, RESET);
+}
+
+void displayServiceMenu()
+{
+    clearScreen();
+    displayBanner();
+    
+    printf("\n%s%s SERVICE REQUEST MANAGEMENT %s\n", BG_CYAN, BLACK, RESET);
+    printf("%s 1. Submit New Request %s\n", YELLOW, RESET);
+    printf("%s 2. View All Pending Requests %s\n", YELLOW, RESET);
+    printf("%s 3. Process Next Request %s\n", YELLOW, RESET);
+    printf("%s 4. Process All Requests %s\n", YELLOW, RESET);
+    printf("%s 5. Cancel a Request %s\n", YELLOW, RESET);
+    printf("%s 6. Change a Request's Priority %s\n", YELLOW, RESET);
+    printf("%s 7. Return to Main Menu %s\n", YELLOW, RESET);
+    printf("\n%sEnter your choice: %s", GREEN, RESET);
+}
+
+void displayBranchMenu()
+{
+    clearScreen();
+    displayBanner();
+    
+    printf("\n%s%s BRANCH MANAGEMENT %s\n", BG_CYAN, BLACK, RESET);
+    printf("%s 1. Add New Branch %s\n", YELLOW, RESET);
+    printf("%s 2. View All Branches %s\n", YELLOW, RESET);
+    printf("%s 3. Add Branch Connection %s\n", YELLOW, RESET);
+    printf("%s 4. View Branch Connections %s\n", YELLOW, RESET);
+    printf("%s 5. Find Shortest Path Between Branches %s\n", YELLOW, RESET);
+    printf("%s 6. Prepare Routes for a Large Network %s\n", YELLOW, RESET);
+    printf("%s 7. Return to Main Menu %s\n", YELLOW, RESET);
+    printf("\n%sEnter your choice: %s", GREEN, RESET);
+}
+
+void displayUserManagementMenu()
+{
+    clearScreen();
+    displayBanner();
+    
+    printf("\n%s%s USER MANAGEMENT %s\n", BG_CYAN, BLACK, RESET);
+    printf("%s 1. Add New User %s\n", YELLOW, RESET);
+    printf("%s 2. View All Users %s\n", YELLOW, RESET);
+    printf("%s 3. Return to Main Menu %s\n", YELLOW, RESET);
+    printf("\n%sEnter your choice: %s", GREEN, RESET);
+}
+
+void displaySaveLoadMenu()
+{
+    clearScreen();
+    displayBanner();
+    
+    printf("\n%s%s DATA MANAGEMENT %s\n", BG_CYAN, BLACK, RESET);
+    printf("%s 1. Save All Data %s\n", YELLOW, RESET);
+    printf("%s 2. Load All Data %s\n", YELLOW, RESET);
+    printf("%s 3. View Memory Statistics %s\n", YELLOW, RESET);
+    printf("%s 4. Return to Main Menu %s\n", YELLOW, RESET);
+    printf("\n%sEnter your choice: %s", GREEN, RESET);
+}
+
+/***************************************************
+ * SECTION 8: ACCOUNT MANAGEMENT FUNCTIONS
+ ***************************************************/
+
+void viewAllAccounts()
+{
+    if (accountTable.count == 0)
+    {
+        printf("%sNo accounts to display.%s\n", YELLOW, RESET);
+        return;
+    }
+
+    printf("\n%s%s All Accounts %s\n", BG_GREEN, BLACK, RESET);
+    printf("%s%s%-5s %-15s %-10s %-20s %-15s %s\n", 
+           BG_CYAN, BLACK, "No", "Name", "Balance", "Address", "Phone", RESET);
+
+    char balanceText[MONEY_TEXT_SIZE];
+    for (int row = 0; row < accountTable.count; row++)
+    {
+        struct AccountProfile *profile = accountProfile(row);
+        printf("%-5d %-15s %s$%s%s %-20.20s %-15s\n",
+               accountTable.accountNo[row],
+               profile->name,
+               GREEN,
+               formatMoney(accountTable.balance[row], balanceText),
+               RESET,
+               profile->address,
+               profile->phoneNumber);
+    }
+}
+
+void searchAccount()
+{
+    int accountNo;
+    printf("\n%sEnter Account Number to search: %s", CYAN, RESET);
+    scanf("%d", &accountNo);
+    getchar(); // Clear input buffer
+    
+    int row = findAccount(accountNo);
+    if (row == -1)
+    {
+        printf("%sAccount not found.%s\n", RED, RESET);
+        return;
+    }
+    struct AccountProfile *account = accountProfile(row);
+    
+    printf("\n%s%s Account Details %s\n", BG_GREEN, BLACK, RESET);
+    printf("%sAccount Number: %d%s\n", CYAN, accountNo, RESET);
+    printf("%sName: %s%s\n", CYAN, account->name, RESET);
+    char balanceText[MONEY_TEXT_SIZE];
+    printf("%sBalance: %s$%s%s\n", CYAN, GREEN, formatMoney(accountTable.balance[row], balanceText), RESET);
+    printf("%sAddress: %s%s\n", CYAN, account->address, RESET);
+    printf("%sPhone: %s%s\n", CYAN, account->phoneNumber, RESET);
+    printf("%sEmail: %s%s\n", CYAN, account->email, RESET);
+    char dateText[TIMESTAMP_TEXT_SIZE], timeText[TIMESTAMP_TEXT_SIZE];
+    formatTimestamp(account->createdAt, dateText, NULL);
+    printf("%sDate Created: %s%s\n", CYAN, dateText, RESET);
+    
+    const struct Transaction *recent[5];
+    int recentCount = recentAccountTransactions(row, recent, 5);
+    if (recentCount > 0)
+    {
+        printf("%sRecent Transactions:%s\n", CYAN, RESET);
+        for (int i = 0; i < recentCount; i++)
+        {
+            formatTimestamp(recent[i]->timestamp, dateText, timeText);
+            printf("  %-12s %-8s %-15s $%s\n", dateText, timeText, recent[i]->type,
+                   formatMoney(recent[i]->amount, balanceText));
+        }
+    }
+}
+
+bool updateAccountDetails(int accountNo)
+{
+    int row = findAccount(accountNo);
+    if (row == -1)
+    {
+        return false;
+    }
+    struct AccountProfile *account = accountProfile(row);
+    
+    printf("\n%s%s Update Account Details %s\n", BG_GREEN, BLACK, RESET);
+    printf("%sCurrent Name: %s - Enter new name (or press Enter to keep): %s", CYAN, account->name, RESET);
+    
+    char input[100];
+    fgets(input, sizeof(input), stdin);
+    input[strcspn(input, "\n")] = 0; // Remove newline
+    
+    if (strlen(input) > 0)
+    {
+        strcpy(account->name, input);
+    }
+    
+    printf("%sCurrent Address: %s - Enter new address (or press Enter to keep): %s", CYAN, account->address, RESET);
+    fgets(input, sizeof(input), stdin);
+    input[strcspn(input, "\n")] = 0;
+    
+    if (strlen(input) > 0)
+    {
+        strcpy(account->address, input);
+    }
+    
+    printf("%sCurrent Phone: %s - Enter new phone (or press Enter to keep): %s", CYAN, account->phoneNumber, RESET);
+    fgets(input, sizeof(input), stdin);
+    input[strcspn(input, "\n")] = 0;
+    
+    if (strlen(input) > 0)
+    {
+        strcpy(account->phoneNumber, input);
+    }
+    
+    printf("%sCurrent Email: %s - Enter new email (or press Enter to keep): %s", CYAN, account->email, RESET);
+    fgets(input, sizeof(input), stdin);
+    input[strcspn(input, "\n")] = 0;
+    
+    if (strlen(input) > 0)
+    {
+        strcpy(account->email, input);
+    }
+    
+    // The record carries the balance, so every operation queued before it
+    // has to reach the journal first
+    lockAllAccounts();
+    lockJournal();
+    struct AccountRecord record;
+    makeAccountRecord(row, &record);
+    walAppend(WAL_ACCOUNT_UPDATE, &record, sizeof(record));
+    unlockJournal();
+    markAccountDirty(row);
+    unlockAllAccounts();
+    
+    printf("%sAccount details updated successfully!%s\n", GREEN, RESET);
+    return true;
+}
+
+bool deleteAccount(int accountNo)
+{
+    // Closing moves another account into the freed row
+    lockAllAccounts();
+    lockJournal();
+    int row = findAccount(accountNo);
+    if (row != -1)
+    {
+        walAppend(WAL_ACCOUNT_CLOSE, &accountNo, sizeof(accountNo));
+        removeAccountRow(row);
+    }
+    unlockJournal();
+    unlockAllAccounts();
+    return row != -1;
+}
+/***************************************************
+ * SECTION 9: BENCHMARKS
+ ***************************************************/
+
+// Baseline lookup: scan the account number column front to back
+int findAccountLinear(int accNo)
+{
+    for (int row = 0; row < accountTable.count; row++)
+    {
+        if (accountTable.accountNo[row] == accNo)
+        {
+            return row;
+        }
+    }
+    return -1;
+}
+
+// Compare indexed lookups against a linear scan
+void benchAccountLookup()
+{
+    int sizes[] = {10000, 100000, 1000000};
+    int sizeCount = sizeof(sizes) / sizeof(sizes[0]);
+    const int firstAccountNo = 100000;
+
+    printf("%-10s %-14s %-16s %-16s %-10s\n",
+           "Accounts", "Insert ns/op", "Scan ns/lookup", "Hash ns/lookup", "Speedup");
+
+    for (int s = 0; s < sizeCount; s++)
+    {
+        int n = sizes[s];
+        clearAccounts();
+
+        double start = monotonicNow();
+        for (int i = 0; i < n; i++)
+        {
+            addAccount(firstAccountNo + i, "Bench Customer", 10000, "1 Bench Street", "5550100", "bench@example.com");
+        }
+        double insertTime = monotonicNow() - start;
+
+        // Scale the scan lookups so each size does roughly the same amount of scanning
+        int listLookups = 200000000 / n;
+        int hashLookups = 2000000;
+        long found = 0;
+
+        start = monotonicNow();
+        for (int i = 0; i < listLookups; i++)
+        {
+            found += findAccountLinear(firstAccountNo + rand() % n) != -1;
+        }
+        double listTime = monotonicNow() - start;
+
+        start = monotonicNow();
+        for (int i = 0; i < hashLookups; i++)
+        {
+            found += findAccount(firstAccountNo + rand() % n) != -1;
+        }
+        double hashTime = monotonicNow() - start;
+
+        double listNs = listTime * 1e9 / listLookups;
+        double hashNs = hashTime * 1e9 / hashLookups;
+        printf("%-10d %-14.1f %-16.1f %-16.1f %.0fx\n",
+               n, insertTime * 1e9 / n, listNs, hashNs, listNs / hashNs);
+
+        if (found != listLookups + hashLookups)
+        {
+            printf("%sLookup mismatch: %ld found%s\n", RED, found, RESET);
+        }
+    }
+
+    clearAccounts();
+}
+
+// Transaction-heavy workload on the node pools, plus raw churn and teardown
+// comparisons against malloc/free
+void benchAllocator()
+{
+    const int accounts = 10000;
+    const int operations = 2000000;
+    const int firstAccountNo = 100000;
+
+    clearAccounts();
+    for (int i = 0; i < accounts; i++)
+    {
+        addAccount(firstAccountNo + i, "Bench Customer", 100000, "1 Bench Street", "5550100", "bench@example.com");
+    }
+
+    // Mixed deposits, withdrawals, transfers and undos
+    double start = monotonicNow();
+    for (int i = 0; i < operations; i++)
+    {
+        int accountNo = firstAccountNo + rand() % accounts;
+        switch (rand() % 8)
+        {
+            case 0: case 1: case 2:
+                deposit(accountNo, 1000);
+                break;
+            case 3: case 4:
+                withdraw(accountNo, 500);
+                break;
+            case 5: case 6:
+                transfer(accountNo, firstAccountNo + rand() % accounts, 100);
+                break;
+            default:
+                popTransaction();
+        }
+    }
+    double workloadTime = monotonicNow() - start;
+    printf("Workload: %d operations in %.3f s (%.0f ns/op)\n\n",
+           operations, workloadTime, workloadTime * 1e9 / operations);
+    printPoolStats();
+
+    // Push/pop churn: pool free list versus malloc/free
+    const int churnRounds = 200;
+    const int churnDepth = 10000;
+    struct Transaction transaction = {0};
+    void **nodes = (void **)malloc(sizeof(void *) * churnDepth);
+
+    start = monotonicNow();
+    for (int r = 0; r < churnRounds; r++)
+    {
+        for (int i = 0; i < churnDepth; i++)
+        {
+            pushTransaction(transaction);
+        }
+        for (int i = 0; i < churnDepth; i++)
+        {
+            popTransaction();
+        }
+    }
+    double poolChurn = monotonicNow() - start;
+
+    start = monotonicNow();
+    for (int r = 0; r < churnRounds; r++)
+    {
+        for (int i = 0; i < churnDepth; i++)
+        {
+            nodes[i] = malloc(sizeof(struct TransactionNode));
+        }
+        for (int i = churnDepth - 1; i >= 0; i--)
+        {
+            free(nodes[i]);
+        }
+    }
+    double mallocChurn = monotonicNow() - start;
+    free(nodes);
+
+    int churnOps = churnRounds * churnDepth * 2;
+    printf("\nChurn:    pool %.1f ns/op, malloc %.1f ns/op\n",
+           poolChurn * 1e9 / churnOps, mallocChurn * 1e9 / churnOps);
+
+    // Bulk teardown of the whole history: one reset versus a free() per node
+    int historySize = transactionPool.liveCount;
+    start = monotonicNow();
+    clearTransactions();
+    double resetTime = monotonicNow() - start;
+
+    struct TransactionNode *list = NULL;
+    for (int i = 0; i < historySize; i++)
+    {
+        struct TransactionNode *node = (struct TransactionNode *)malloc(sizeof(struct TransactionNode));
+        node->next = list;
+        list = node;
+    }
+    start = monotonicNow();
+    while (list != NULL)
+    {
+        struct TransactionNode *next = list->next;
+        free(list);
+        list = next;
+    }
+    double freeLoopTime = monotonicNow() - start;
+    printf("Teardown: %d nodes, reset %.3f ms, free loop %.3f ms\n",
+           historySize, resetTime * 1e3, freeLoopTime * 1e3);
+
+    clearAccounts();
+}
+
+// Full-book balance sweeps: the balance column against whole account records,
+// both as a contiguous array and linked in shuffled order like the old list
+void benchBalanceSweep()
+{
+    struct BenchRecordNode
+    {
+        struct AccountRecord data;
+        struct BenchRecordNode *next;
+    };
+
+    const int n = 1000000;
+    const int sweeps = 20;
+    const int firstAccountNo = 100000;
+
+    clearAccounts();
+    for (int i = 0; i < n; i++)
+    {
+        addAccount(firstAccountNo + i, "Bench Customer", rand() % 1000000, "1 Bench Street", "5550100", "bench@example.com");
+    }
+
+    struct AccountRecord *records = (struct AccountRecord *)calloc(n, sizeof(struct AccountRecord));
+    struct BenchRecordNode *nodes = (struct BenchRecordNode *)calloc(n, sizeof(struct BenchRecordNode));
+    int *order = (int *)malloc(n * sizeof(int));
+    if (records == NULL || nodes == NULL || order == NULL)
+    {
+        printf("%sNot enough memory for the sweep benchmark.%s\n", RED, RESET);
+        free(records);
+        free(nodes);
+        free(order);
+        return;
+    }
+
+    for (int i = 0; i < n; i++)
+    {
+        records[i].accountNo = accountTable.accountNo[i];
+        records[i].balance = accountTable.balance[i];
+        nodes[i].data = records[i];
+        order[i] = i;
+    }
+    for (int i = n - 1; i > 0; i--)
+    {
+        int j = rand() % (i + 1);
+        int swap = order[i];
+        order[i] = order[j];
+        order[j] = swap;
+    }
+    for (int i = 0; i < n - 1; i++)
+    {
+        nodes[order[i]].next = &nodes[order[i + 1]];
+    }
+    nodes[order[n - 1]].next = NULL;
+    struct BenchRecordNode *head = &nodes[order[0]];
+
+    Money columnTotal = 0, recordTotal = 0, linkedTotal = 0;
+
+    double start = monotonicNow();
+    for (int s = 0; s < sweeps; s++)
+    {
+        columnTotal += sumMoney(accountTable.balance, accountTable.count);
+    }
+    double columnTime = (monotonicNow() - start) / sweeps;
+
+    start = monotonicNow();
+    for (int s = 0; s < sweeps; s++)
+    {
+        for (int i = 0; i < n; i++)
+        {
+            recordTotal += records[i].balance;
+        }
+    }
+    double recordTime = (monotonicNow() - start) / sweeps;
+
+    start = monotonicNow();
+    for (int s = 0; s < sweeps; s++)
+    {
+        for (struct BenchRecordNode *node = head; node != NULL; node = node->next)
+        {
+            linkedTotal += node->data.balance;
+        }
+    }
+    double linkedTime = (monotonicNow() - start) / sweeps;
+
+    printf("Balance sweep over %d accounts (%d sweeps each)\n", n, sweeps);
+    printf("%-22s %-12s %-16s %-10s\n", "Layout", "ms/sweep", "M accounts/s", "Speedup");
+    printf("%-22s %-12.3f %-16.1f %-10s\n", "Balance column (SoA)", columnTime * 1e3, n / columnTime / 1e6, "1.0x");
+    printf("%-22s %-12.3f %-16.1f %.1fx\n", "Record array (AoS)", recordTime * 1e3, n / recordTime / 1e6, recordTime / columnTime);
+    printf("%-22s %-12.3f %-16.1f %.1fx\n", "Linked records", linkedTime * 1e3, n / linkedTime / 1e6, linkedTime / columnTime);
+
+    if (columnTotal != recordTotal || columnTotal != linkedTotal)
+    {
+        printf("%sSweep totals disagree!%s\n", RED, RESET);
+    }
+
+    free(records);
+    free(nodes);
+    free(order);
+    clearAccounts();
+}
+
+// File benchmarks run in a throwaway directory so real data files are never touched
+bool benchEnterScratchDir(char *previousDir, size_t size, char *scratchDir)
+{
+    strcpy(scratchDir, "/tmp/newbank-bench-XXXXXX");
+    if (getcwd(previousDir, size) == NULL || mkdtemp(scratchDir) == NULL || chdir(scratchDir) != 0)
+    {
+        printf("%sCould not create a scratch directory for the benchmark.%s\n", RED, RESET);
+        return false;
+    }
+    return true;
+}
+
+void benchLeaveScratchDir(const char *previousDir, const char *scratchDir)
+{
+    DIR *dir = opendir(".");
+    if (dir != NULL)
+    {
+        struct dirent *entry;
+        while ((entry = readdir(dir)) != NULL)
+        {
+            if (entry->d_name[0] != '.')
+            {
+                remove(entry->d_name);
+            }
+        }
+        closedir(dir);
+    }
+
+    if (chdir(previousDir) == 0)
+    {
+        rmdir(scratchDir);
+    }
+}
+
+// Save and reload a 1M-account book: the mapped single-pass loader against
+// reading one record at a time and inserting it through addAccount
+void benchStartup()
+{
+    const int n = 1000000;
+    const int firstAccountNo = 100000;
+    char previousDir[1024], scratchDir[64];
+    if (!benchEnterScratchDir(previousDir, sizeof(previousDir), scratchDir))
+    {
+        return;
+    }
+
+    clearAccounts();
+    for (int i = 0; i < n; i++)
+    {
+        addAccount(firstAccountNo + i, "Bench Customer", rand() % 1000000, "1 Bench Street", "5550100", "bench@example.com");
+    }
+    Money expected = sumMoney(accountTable.balance, accountTable.count);
+
+    double start = monotonicNow();
+    saveAccountsToFile();
+    double saveTime = monotonicNow() - start;
+
+    start = monotonicNow();
+    loadAccountsFromFile();
+    double loadTime = monotonicNow() - start;
+    bool loadedAll = accountTable.count == n && sumMoney(accountTable.balance, accountTable.count) == expected;
+
+    // Baseline: fread per record and addAccount per account, as before
+    clearAccounts();
+    start = monotonicNow();
+    FILE *file = fopen("accounts.dat", "rb");
+    if (file != NULL)
+    {
+        struct AccountsFileHeader header;
+        struct AccountRecord record;
+        if (fread(&header, sizeof(header), 1, file) == 1)
+        {
+            while (fread(&record, sizeof(record), 1, file) == 1)
+            {
+                addAccount(record.accountNo, record.profile.name, record.balance,
+                           record.profile.address, record.profile.phoneNumber, record.profile.email);
+            }
+        }
+        fclose(file);
+    }
+    double freadTime = monotonicNow() - start;
+
+    printf("%d accounts, %.1f MB file\n", n,
+           (sizeof(struct AccountsFileHeader) + (double)n * sizeof(struct AccountRecord)) / 1e6);
+    printf("Save:                 %.3f s\n", saveTime);
+    printf("Mapped load:          %.3f s%s\n", loadTime, loadedAll ? "" : " (MISMATCH)");
+    printf("fread + addAccount:   %.3f s\n", freadTime);
+
+    clearAccounts();
+    benchLeaveScratchDir(previousDir, scratchDir);
+}
+
+// Deposits and transfers against a journaled bank at several group commit
+// sizes, then a reload that has to replay the journal to get back the state
+void benchJournal()
+{
+    const int n = 10000;
+    const int ops = 20000;
+    const int firstAccountNo = 100000;
+    const int groupSizes[] = {1, 8, 64, 512};
+    char previousDir[1024], scratchDir[64];
+    if (!benchEnterScratchDir(previousDir, sizeof(previousDir), scratchDir))
+    {
+        return;
+    }
+
+    clearAccounts();
+    clearTransactions();
+    for (int i = 0; i < n; i++)
+    {
+        addAccount(firstAccountNo + i, "Bench Customer", 1000000, "1 Bench Street", "5550100", "bench@example.com");
+    }
+
+    printf("%d accounts, %d operations per run (2/3 deposits, 1/3 transfers)\n", n, ops);
+    printf("%-8s %14s %10s %16s\n", "Group", "Operations/s", "fsyncs", "Journal bytes/op");
+    for (size_t g = 0; g < sizeof(groupSizes) / sizeof(groupSizes[0]); g++)
+    {
+        // Each run starts from a checkpoint so the journal holds only its own records
+        saveAccountsToFile();
+        saveTransactionsToFile();
+        walConfigure(groupSizes[g], 1.0);
+        walOpen(0);
+        long long commitsBefore = wal.commits;
+
+        double start = monotonicNow();
+        for (int i = 0; i < ops; i++)
+        {
+            int accountNo = firstAccountNo + rand() % n;
+            if (i % 3 == 2)
+            {
+                transfer(accountNo, firstAccountNo + rand() % n, 1 + rand() % 100);
+            }
+            else
+            {
+                deposit(accountNo, 1 + rand() % 10000);
+            }
+        }
+        walFlush();
+        double elapsed = monotonicNow() - start;
+
+        long journalSize = ftell(wal.file);
+        walClose();
+        printf("%-8d %14.0f %10lld %16.1f\n", groupSizes[g], ops / elapsed,
+               wal.commits - commitsBefore, (double)(journalSize - (long)sizeof(struct DataFileHeader)) / ops);
+    }
+
+    // Reload the last checkpoint and replay the last run's journal on top
+    Money expected = sumMoney(accountTable.balance, accountTable.count);
+    double start = monotonicNow();
+    loadAllData();
+    double replayTime = monotonicNow() - start;
+    walClose();
+    bool matched = accountTable.count == n && sumMoney(accountTable.balance, accountTable.count) == expected;
+    printf("Reload with replay: %.3f s%s\n", replayTime, matched ? "" : " (MISMATCH)");
+
+    clearAccounts();
+    clearTransactions();
+    benchLeaveScratchDir(previousDir, scratchDir);
+}
+
+// Full rewrite of a 1M-account book against checkpoints that touch only the
+// accounts changed since the previous one
+void benchCheckpoint()
+{
+    const int n = 1000000;
+    const int firstAccountNo = 100000;
+    const int changeCounts[] = {10, 1000, 100000};
+    char previousDir[1024], scratchDir[64];
+    if (!benchEnterScratchDir(previousDir, sizeof(previousDir), scratchDir))
+    {
+        return;
+    }
+
+    clearAccounts();
+    for (int i = 0; i < n; i++)
+    {
+        addAccount(firstAccountNo + i, "Bench Customer", 10000, "1 Bench Street", "5550100", "bench@example.com");
+    }
+
+    double start = monotonicNow();
+    saveAccountsToFile();
+    double fullTime = monotonicNow() - start;
+    printf("%d accounts, full rewrite of %.1f MB: %.3f s\n", n,
+           (sizeof(struct AccountsFileHeader) + (double)n * sizeof(struct AccountRecord)) / 1e6, fullTime);
+
+    printf("%-10s %12s %12s\n", "Changed", "Checkpoint", "Written");
+    for (size_t c = 0; c < sizeof(changeCounts) / sizeof(changeCounts[0]); c++)
+    {
+        for (int i = 0; i < changeCounts[c]; i++)
+        {
+            deposit(firstAccountNo + rand() % n, 1 + rand() % 10000);
+        }
+        int dirty = accountsFile.dirtyCount;
+
+        start = monotonicNow();
+        checkpointAccounts();
+        double checkpointTime = monotonicNow() - start;
+        printf("%-10d %10.4f s %9.2f MB\n", changeCounts[c], checkpointTime,
+               (double)dirty * sizeof(struct AccountDeltaEntry) * 2 / 1e6);
+    }
+
+    // The file written piecemeal has to load back to the same book
+    Money expected = sumMoney(accountTable.balance, accountTable.count);
+    loadAccountsFromFile();
+    bool matched = accountTable.count == n && sumMoney(accountTable.balance, accountTable.count) == expected;
+    printf("Reload after checkpoints: %s\n", matched ? "balances match" : "MISMATCH");
+
+    clearAccounts();
+    clearTransactions();
+    benchLeaveScratchDir(previousDir, scratchDir);
+}
+
+// Save and reload a 2M-entry history: the chunked loader against reading
+// one record per fread, then the cost of saving a small addition to it
+void benchHistoryLoad()
+{
+    const int n = 2000000;
+    const int added = 1000;
+    char previousDir[1024], scratchDir[64];
+    if (!benchEnterScratchDir(previousDir, sizeof(previousDir), scratchDir))
+    {
+        return;
+    }
+
+    clearTransactions();
+    struct Transaction transaction = {0};
+    strcpy(transaction.type, "deposit");
+    transaction.timestamp = timestampNow();
+    Money expected = 0;
+    for (int i = 0; i < n; i++)
+    {
+        transaction.transactionId = i;
+        transaction.accountNo = 100000 + rand() % 100000;
+        transaction.amount = 1 + rand() % 100000;
+        expected += transaction.amount;
+        pushTransaction(transaction);
+    }
+
+    double start = monotonicNow();
+    saveTransactionsToFile();
+    double saveTime = monotonicNow() - start;
+
+    start = monotonicNow();
+    loadTransactionsFromFile();
+    double loadTime = monotonicNow() - start;
+
+    Money total = 0;
+    bool ordered = true;
+    int expectedId = n - 1;
+    for (struct TransactionNode *node = transactionStack; node != NULL; node = node->next)
+    {
+        total += node->data.amount;
+        ordered = ordered && node->data.transactionId == expectedId--;
+    }
+    bool matched = transactionCount == n && total == expected && ordered;
+
+    // Baseline: one fread and push per record
+    clearTransactions();
+    start = monotonicNow();
+    FILE *file = fopen("transactions.dat", "rb");
+    if (file != NULL)
+    {
+        fseek(file, sizeof(struct TransactionsFileHeader), SEEK_SET);
+        while (fread(&transaction, sizeof(transaction), 1, file) == 1)
+        {
+            pushTransaction(transaction);
+        }
+        fclose(file);
+    }
+    double freadTime = monotonicNow() - start;
+
+    loadTransactionsFromFile();
+    for (int i = 0; i < added; i++)
+    {
+        transaction.transactionId = n + i;
+        pushTransaction(transaction);
+    }
+    start = monotonicNow();
+    saveTransactionsToFile();
+    double appendTime = monotonicNow() - start;
+
+    printf("%d transactions, %.1f MB file\n", n, (double)n * sizeof(struct Transaction) / 1e6);
+    printf("Full save:            %.3f s\n", saveTime);
+    printf("Chunked load:         %.3f s (%.0f records/s)%s\n", loadTime, n / loadTime, matched ? "" : " (MISMATCH)");
+    printf("fread per record:     %.3f s (%.0f records/s)\n", freadTime, n / freadTime);
+    printf("Save of %d more:    %.4f s\n", added, appendTime);
+
+    clearTransactions();
+    benchLeaveScratchDir(previousDir, scratchDir);
+}
+
+// Per-account statements over a 2M-entry history: filtering the global
+// stack against walking the account's own chain, plus a last-10 lookup
+void benchStatements()
+{
+    const int n = 100000;
+    const int historySize = 2000000;
+    const int firstAccountNo = 100000;
+    const int scanStatements = 20;
+    const int indexStatements = 200000;
+
+    clearAccounts();
+    clearTransactions();
+    for (int i = 0; i < n; i++)
+    {
+        addAccount(firstAccountNo + i, "Bench Customer", 0, "1 Bench Street", "5550100", "bench@example.com");
+    }
+    struct Transaction transaction = {0};
+    strcpy(transaction.type, "deposit");
+    for (int i = 0; i < historySize; i++)
+    {
+        transaction.transactionId = i;
+        transaction.accountNo = firstAccountNo + rand() % n;
+        transaction.amount = 1 + rand() % 10000;
+        pushTransaction(transaction);
+    }
+
+    // Baseline: filter every transaction in the bank for one account
+    Money scanTotal = 0;
+    double start = monotonicNow();
+    for (int s = 0; s < scanStatements; s++)
+    {
+        int accountNo = firstAccountNo + (s * 7919) % n;
+        for (struct TransactionNode *node = transactionStack; node != NULL; node = node->next)
+        {
+            if (node->data.accountNo == accountNo)
+            {
+                scanTotal += node->data.amount;
+            }
+        }
+    }
+    double scanTime = (monotonicNow() - start) / scanStatements;
+
+    // The first scanStatements accounts are the ones the scan covered
+    Money indexTotal = 0;
+    Money runningTotal = 0;
+    start = monotonicNow();
+    for (int s = 0; s < indexStatements; s++)
+    {
+        int row = findAccount(firstAccountNo + (s * 7919) % n);
+        for (struct TransactionHistory *chunk = accountTable.history[row]; chunk != NULL; chunk = chunk->older)
+        {
+            for (int i = 0; i < chunk->count; i++)
+            {
+                runningTotal += chunk->entries[i]->data.amount;
+            }
+        }
+        if (s == scanStatements - 1)
+        {
+            indexTotal = runningTotal;
+        }
+    }
+    double indexTime = (monotonicNow() - start) / indexStatements;
+
+    const struct Transaction *recent[10];
+    long found = 0;
+    start = monotonicNow();
+    for (int s = 0; s < indexStatements; s++)
+    {
+        found += recentAccountTransactions(findAccount(firstAccountNo + rand() % n), recent, 10);
+    }
+    double recentTime = (monotonicNow() - start) / indexStatements;
+
+    printf("%d accounts, %d transactions (%d per account on average)\n", n, historySize, historySize / n);
+    printf("Statement, stack scan:   %10.1f us\n", scanTime * 1e6);
+    printf("Statement, account chain:%10.3f us%s\n", indexTime * 1e6, indexTotal == scanTotal ? "" : " (MISMATCH)");
+    printf("Last 10 transactions:    %10.3f us (%ld found)\n", recentTime * 1e6, found);
+
+    clearTransactions();
+    clearAccounts();
+}
+
+// Transaction IDs: handing them out in blocks against a shared counter per
+// ID, then finding a transaction by ID through the index against a scan
+void benchTransactionIds()
+{
+    const int ids = 10000000;
+    const int historySize = 2000000;
+    const int scanLookups = 20;
+    const int indexLookups = 2000000;
+
+    // The old scheme, for comparison: how many distinct IDs it produces
+    char *seen = (char *)calloc(11000, 1);
+    int distinct = 0;
+    for (int i = 0; i < historySize && seen != NULL; i++)
+    {
+        int id = rand() % 10000 + 1000;
+        distinct += !seen[id];
+        seen[id] = 1;
+    }
+    free(seen);
+
+    long long check = 0;
+    double start = monotonicNow();
+    for (int i = 0; i < ids; i++)
+    {
+        check += takeTransactionId();
+    }
+    double blockTime = monotonicNow() - start;
+
+    start = monotonicNow();
+    for (int i = 0; i < ids; i++)
+    {
+        check += atomic_fetch_add(&transactionIdSequence, 1);
+    }
+    double sharedTime = monotonicNow() - start;
+
+    clearTransactions();
+    struct Transaction transaction = {0};
+    strcpy(transaction.type, "deposit");
+    long long firstId = 0;
+    for (int i = 0; i < historySize; i++)
+    {
+        transaction.transactionId = takeTransactionId();
+        transaction.accountNo = 100000 + rand() % 100000;
+        transaction.amount = 1 + rand() % 100000;
+        if (i == 0)
+        {
+            firstId = transaction.transactionId;
+        }
+        pushTransaction(transaction);
+    }
+    long long idRange = transaction.transactionId - firstId + 1;
+
+    long found = 0;
+    start = monotonicNow();
+    for (int i = 0; i < scanLookups; i++)
+    {
+        long long id = firstId + rand() % idRange;
+        for (struct TransactionNode *node = transactionStack; node != NULL; node = node->next)
+        {
+            if (node->data.transactionId == id)
+            {
+                found++;
+                break;
+            }
+        }
+    }
+    double scanTime = (monotonicNow() - start) / scanLookups;
+
+    start = monotonicNow();
+    for (int i = 0; i < indexLookups; i++)
+    {
+        found += findTransaction(firstId + rand() % idRange) != NULL;
+    }
+    double indexTime = (monotonicNow() - start) / indexLookups;
+
+    printf("rand() %% 10000 + 1000 over %d transactions: %d distinct IDs\n", historySize, distinct);
+    printf("ID from block of %d:     %8.2f ns\n", TRANSACTION_ID_BLOCK, blockTime * 1e9 / ids);
+    printf("ID from shared counter:  %8.2f ns\n", sharedTime * 1e9 / ids);
+    printf("Lookup by scan:          %8.1f us\n", scanTime * 1e6);
+    printf("Lookup by ID index:      %8.3f us (%ld of %d found)\n", indexTime * 1e6, found, scanLookups + indexLookups);
+
+    if (check <= 0 || found != scanLookups + indexLookups)
+    {
+        printf("%sID sequence or index mismatch!%s\n", RED, RESET);
+    }
+
+    clearTransactions();
+}
+
+// Cost of timestamping on the deposit path, against the localtime and
+// sprintf stamping each operation used to do, and of formatting for display
+void benchTimestamps()
+{
+    const int n = 10000;
+    const int ops = 2000000;
+    const int firstAccountNo = 100000;
+
+    clearAccounts();
+    clearTransactions();
+    for (int i = 0; i < n; i++)
+    {
+        addAccount(firstAccountNo + i, "Bench Customer", 100000, "1 Bench Street", "5550100", "bench@example.com");
+    }
+
+    double start = monotonicNow();
+    for (int i = 0; i < ops; i++)
+    {
+        deposit(firstAccountNo + (int)(i * 7919LL % n), 100);
+    }
+    double depositTime = (monotonicNow() - start) / ops;
+
+    // The stamping every deposit did before timestamps
+    struct TransactionRecordV4 stamped = {0};
+    start = monotonicNow();
+    for (int i = 0; i < ops; i++)
+    {
+        time_t now = time(NULL);
+        struct tm *t = localtime(&now);
+        formatCalendarDate(t, stamped.date);
+        sprintf(stamped.time, "%02d:%02d", t->tm_hour, t->tm_min);
+    }
+    double textStampTime = (monotonicNow() - start) / ops;
+
+    Timestamp latest = 0;
+    start = monotonicNow();
+    for (int i = 0; i < ops; i++)
+    {
+        latest = timestampNow();
+    }
+    double binaryStampTime = (monotonicNow() - start) / ops;
+
+    // Formatting a month of history newest first, as a statement lists it
+    const Timestamp step = 30 * 86400 * MICROS_PER_SECOND / ops;
+    char dateText[TIMESTAMP_TEXT_SIZE], timeText[TIMESTAMP_TEXT_SIZE];
+    start = monotonicNow();
+    for (int i = 0; i < ops; i++)
+    {
+        formatTimestamp(latest - i * step, dateText, timeText);
+    }
+    double cachedFormatTime = (monotonicNow() - start) / ops;
+
+    start = monotonicNow();
+    for (int i = 0; i < ops; i++)
+    {
+        time_t when = timestampSeconds(latest - i * step);
+        struct tm *t = localtime(&when);
+        formatCalendarDate(t, dateText);
+        sprintf(timeText, "%02d:%02d", t->tm_hour, t->tm_min);
+    }
+    double localtimeFormatTime = (monotonicNow() - start) / ops;
+
+    printf("%d deposits over %d accounts\n", ops, n);
+    printf("Deposit:                       %8.1f ns/op\n", depositTime * 1e9);
+    printf("Stamp with localtime+sprintf:  %8.1f ns/op\n", textStampTime * 1e9);
+    printf("Stamp with timestampNow:       %8.1f ns/op\n", binaryStampTime * 1e9);
+    printf("Format, per-day cache:         %8.1f ns/op\n", cachedFormatTime * 1e9);
+    printf("Format, localtime+sprintf:     %8.1f ns/op\n", localtimeFormatTime * 1e9);
+
+    clearTransactions();
+    clearAccounts();
+}
+
+void sumRangeAmounts(const struct Transaction *transaction, void *context)
+{
+    *(Money *)context += transaction->amount;
+}
+
+// Date-bounded queries over three years of history: one month of the whole
+// bank and monthly account statements, filtering everything against reading
+// only the timeline segments and history chunks that overlap the month
+void benchTimeRanges()
+{
+    const int n = 10000;
+    const int historySize = 2000000;
+    const int firstAccountNo = 100000;
+    const int months = 36;
+    const int scanQueries = 10;
+    const int rangeQueries = 1000;
+    const int scanStatements = 20;
+    const int rangeStatements = 200000;
+
+    clearAccounts();
+    clearTransactions();
+    for (int i = 0; i < n; i++)
+    {
+        addAccount(firstAccountNo + i, "Bench Customer", 0, "1 Bench Street", "5550100", "bench@example.com");
+    }
+
+    // Spread the history evenly from January 2021 to the end of 2023
+    Timestamp monthStart[months + 1];
+    for (int m = 0; m <= months; m++)
+    {
+        monthStart[m] = timestampFromDate(2021, m + 1, 1);
+    }
+    Timestamp first = monthStart[0];
+    Timestamp step = (monthStart[months] - first) / historySize;
+    struct Transaction transaction = {0};
+    strcpy(transaction.type, "deposit");
+    for (int i = 0; i < historySize; i++)
+    {
+        transaction.transactionId = i;
+        transaction.accountNo = firstAccountNo + rand() % n;
+        transaction.amount = 1 + rand() % 10000;
+        transaction.timestamp = first + i * step;
+        pushTransaction(transaction);
+    }
+
+    // One month of the whole bank
+    Money scanTotal = 0;
+    double start = monotonicNow();
+    for (int q = 0; q < scanQueries; q++)
+    {
+        int month = (q * 7) % months;
+        Timestamp from = monthStart[month];
+        Timestamp to = monthStart[month + 1];
+        for (struct TransactionNode *node = transactionStack; node != NULL; node = node->next)
+        {
+            if (node->data.timestamp >= from && node->data.timestamp < to)
+            {
+                scanTotal += node->data.amount;
+            }
+        }
+    }
+    double scanTime = (monotonicNow() - start) / scanQueries;
+
+    Money rangeTotal = 0;
+    Money runningTotal = 0;
+    start = monotonicNow();
+    for (int q = 0; q < rangeQueries; q++)
+    {
+        int month = (q * 7) % months;
+        forEachTransactionBetween(monthStart[month], monthStart[month + 1], sumRangeAmounts, &runningTotal);
+        if (q == scanQueries - 1)
+        {
+            rangeTotal = runningTotal;
+        }
+    }
+    double rangeTime = (monotonicNow() - start) / rangeQueries;
+
+    // Monthly statements: the account's whole chain against its month only
+    Money chainTotal = 0;
+    start = monotonicNow();
+    for (int s = 0; s < scanStatements; s++)
+    {
+        int row = findAccount(firstAccountNo + (s * 7919) % n);
+        int month = (s * 7) % months;
+        Timestamp from = monthStart[month];
+        Timestamp to = monthStart[month + 1];
+        for (struct TransactionHistory *chunk = accountTable.history[row]; chunk != NULL; chunk = chunk->older)
+        {
+            for (int i = 0; i < chunk->count; i++)
+            {
+                const struct Transaction *entry = &chunk->entries[i]->data;
+                if (entry->timestamp >= from && entry->timestamp < to)
+                {
+                    chainTotal += entry->amount;
+                }
+            }
+        }
+    }
+    double chainTime = (monotonicNow() - start) / scanStatements;
+
+    Money statementTotal = 0;
+    runningTotal = 0;
+    start = monotonicNow();
+    for (int s = 0; s < rangeStatements; s++)
+    {
+        int row = findAccount(firstAccountNo + (s * 7919) % n);
+        int month = (s * 7) % months;
+        forEachAccountTransactionBetween(row, monthStart[month], monthStart[month + 1], sumRangeAmounts, &runningTotal);
+        if (s == scanStatements - 1)
+        {
+            statementTotal = runningTotal;
+        }
+    }
+    double statementTime = (monotonicNow() - start) / rangeStatements;
+
+    // The usual run: last month's statement, near the head of every chain
+    start = monotonicNow();
+    for (int s = 0; s < rangeStatements; s++)
+    {
+        int row = findAccount(firstAccountNo + (s * 7919) % n);
+        forEachAccountTransactionBetween(row, monthStart[months - 1], monthStart[months], sumRangeAmounts, &runningTotal);
+    }
+    double lastMonthTime = (monotonicNow() - start) / rangeStatements;
+
+    printf("%d accounts, %d transactions over %d months\n", n, historySize, months);
+    printf("Bank month, stack scan:        %10.1f us\n", scanTime * 1e6);
+    printf("Bank month, timeline segments: %10.1f us%s\n", rangeTime * 1e6, rangeTotal == scanTotal ? "" : " (MISMATCH)");
+    printf("Statement, whole chain:        %10.3f us\n", chainTime * 1e6);
+    printf("Statement, chunk bounds:       %10.3f us%s\n", statementTime * 1e6, statementTotal == chainTotal ? "" : " (MISMATCH)");
+    printf("Last month's statement:        %10.3f us\n", lastMonthTime * 1e6);
+
+    clearTransactions();
+    clearAccounts();
+}
+
+// A payroll-sized run posted one call at a time and as one batch, with the
+// journal open. Both must leave the same balances; the batch's journal must
+// replay to them too.
+void benchBatchPosting()
+{
+    const int n = 100000;
+    const int ops = 50000;
+    const int firstAccountNo = 100000;
+    char previousDir[1024], scratchDir[64];
+    if (!benchEnterScratchDir(previousDir, sizeof(previousDir), scratchDir))
+    {
+        return;
+    }
+
+    clearAccounts();
+    clearTransactions();
+    for (int i = 0; i < n; i++)
+    {
+        addAccount(firstAccountNo + i, "Bench Customer", 100000, "1 Bench Street", "5550100", "bench@example.com");
+    }
+    struct BatchOperation *operations = (struct BatchOperation *)malloc(ops * sizeof(*operations));
+    unsigned char *statuses = (unsigned char *)malloc(ops);
+    Money *initial = (Money *)malloc(n * sizeof(Money));
+    Money *oneByOne = (Money *)malloc(n * sizeof(Money));
+    if (operations == NULL || statuses == NULL || initial == NULL || oneByOne == NULL)
+    {
+        printf("Not enough memory for the benchmark.\n");
+        free(operations);
+        free(statuses);
+        free(initial);
+        free(oneByOne);
+        clearAccounts();
+        benchLeaveScratchDir(previousDir, scratchDir);
+        return;
+    }
+    for (int i = 0; i < ops; i++)
+    {
+        operations[i].type = i % 3 == 2 ? WAL_TRANSFER : i % 7 == 6 ? WAL_WITHDRAW : WAL_DEPOSIT;
+        operations[i].accountNo = firstAccountNo + rand() % n;
+        operations[i].toAccountNo = firstAccountNo + rand() % n;
+        operations[i].amount = 1 + rand() % 200000;
+    }
+    memcpy(initial, accountTable.balance, n * sizeof(Money));
+    saveAccountsToFile();
+    saveTransactionsToFile();
+
+    walConfigure(64, 0.002);
+    walOpen(0);
+    long long commitsBefore = wal.commits;
+    int singlePosted = 0;
+    double start = monotonicNow();
+    for (int i = 0; i < ops; i++)
+    {
+        const struct BatchOperation *operation = &operations[i];
+        bool done = operation->type == WAL_DEPOSIT    ? deposit(operation->accountNo, operation->amount)
+                    : operation->type == WAL_WITHDRAW ? withdraw(operation->accountNo, operation->amount)
+                                                      : transfer(operation->accountNo, operation->toAccountNo, operation->amount);
+        singlePosted += done;
+    }
+    walFlush();
+    double singleTime = monotonicNow() - start;
+    long long singleCommits = wal.commits - commitsBefore;
+    walClose();
+    memcpy(oneByOne, accountTable.balance, n * sizeof(Money));
+
+    // Same operations as a batch, from the same starting balances
+    memcpy(accountTable.balance, initial, n * sizeof(Money));
+    clearTransactions();
+    walOpen(0);
+    commitsBefore = wal.commits;
+    start = monotonicNow();
+    int batchPosted = postBatch(operations, ops, statuses);
+    double batchTime = monotonicNow() - start;
+    long long batchCommits = wal.commits - commitsBefore;
+    walClose();
+    bool matched = batchPosted == singlePosted && memcmp(oneByOne, accountTable.balance, n * sizeof(Money)) == 0;
+
+    loadAllData();
+    walClose();
+    bool replayed = accountTable.count == n && memcmp(oneByOne, accountTable.balance, n * sizeof(Money)) == 0;
+
+    printf("%d accounts, %d operations (%d posted)\n", n, ops, batchPosted);
+    printf("%-12s %14s %8s\n", "", "Operations/s", "fsyncs");
+    printf("%-12s %14.0f %8lld\n", "One by one", ops / singleTime, singleCommits);
+    printf("%-12s %14.0f %8lld%s\n", "Batch", ops / batchTime, batchCommits, matched ? "" : " (MISMATCH)");
+    printf("Journal replay of the batch%s\n", replayed ? " matches" : ": MISMATCH");
+
+    free(operations);
+    free(statuses);
+    free(initial);
+    free(oneByOne);
+    clearAccounts();
+    clearTransactions();
+    benchLeaveScratchDir(previousDir, scratchDir);
+}
+
+// One thread of the concurrent transfer benchmark
+struct TransferWorker
+{
+    unsigned long long seed;
+    int operations;
+    int accounts;
+    int firstAccountNo;
+    Mutex *globalLock; // Taken around every transfer for the baseline, or NULL
+    long long completed;
+};
+
+void *runTransferWorker(void *arg)
+{
+    struct TransferWorker *worker = (struct TransferWorker *)arg;
+    unsigned long long x = worker->seed;
+    for (int i = 0; i < worker->operations; i++)
+    {
+        // xorshift64; rand() isn't safe to share between threads
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        int from = worker->firstAccountNo + (int)(x % worker->accounts);
+        int to = worker->firstAccountNo + (int)((x >> 32) % worker->accounts);
+        if (worker->globalLock != NULL)
+        {
+            mutexLock(worker->globalLock);
+        }
+        if (transfer(from, to, 1 + (Money)(x >> 54)))
+        {
+            worker->completed++;
+        }
+        if (worker->globalLock != NULL)
+        {
+            mutexUnlock(worker->globalLock);
+        }
+    }
+    releaseJournalRing();
+    return NULL;
+}
+
+// Uniform-random transfers from 1, 2, 4... threads, against the same
+// threads serialized by one global lock, with the journal drained by its own
+// thread. Money must be conserved and every transfer must leave both of its
+// history entries.
+void benchConcurrentTransfers()
+{
+    const int n = 100000;
+    const int firstAccountNo = 100000;
+    const int operations = 1000000;
+    Thread threads[64];
+    struct TransferWorker workers[64];
+    struct ThreadStart starts[64];
+    const int maxThreads = (int)(sizeof(threads) / sizeof(threads[0]));
+    int processors = processorCount();
+    int threadLimit = processors * 2 < 8 ? 8 : processors * 2;
+    if (threadLimit > maxThreads)
+    {
+        threadLimit = maxThreads;
+    }
+
+    clearAccounts();
+    clearTransactions();
+    for (int i = 0; i < n; i++)
+    {
+        addAccount(firstAccountNo + i, "Bench Customer", 1000000, "1 Bench Street", "5550100", "bench@example.com");
+    }
+    Money expectedTotal = sumMoney(accountTable.balance, accountTable.count);
+
+    Mutex globalLock;
+    mutexInit(&globalLock);
+    startJournalDrainer();
+    double singleThreadRate = 0;
+    printf("%d accounts, %d transfers per run, %d processors\n", n, operations, processors);
+    printf("Threads   striped ops/s   speedup   global lock ops/s\n");
+    for (int threadCount = 1; threadCount <= threadLimit; threadCount *= 2)
+    {
+        double rates[2];
+        bool consistent = true;
+        for (int mode = 0; mode < 2; mode++)
+        {
+            lockAllAccounts();
+            lockJournal();
+            clearTransactions();
+            unlockJournal();
+            unlockAllAccounts();
+            for (int t = 0; t < threadCount; t++)
+            {
+                workers[t].seed = 0x9E3779B97F4A7C15ULL * (t + 1) + threadCount;
+                workers[t].operations = operations / threadCount;
+                workers[t].accounts = n;
+                workers[t].firstAccountNo = firstAccountNo;
+                workers[t].globalLock = mode == 1 ? &globalLock : NULL;
+                workers[t].completed = 0;
+                starts[t].run = runTransferWorker;
+                starts[t].arg = &workers[t];
+            }
+
+            double start = monotonicNow();
+            int started = 0;
+            while (started < threadCount && startThread(&threads[started], &starts[started]))
+            {
+                started++;
+            }
+            for (int t = 0; t < started; t++)
+            {
+                joinThread(threads[t]);
+            }
+            double elapsed = monotonicNow() - start;
+
+            long long completed = 0;
+            for (int t = 0; t < started; t++)
+            {
+                completed += workers[t].completed;
+            }
+            rates[mode] = started * (double)(operations / threadCount) / elapsed;
+            lockAllAccounts();
+            lockJournal();
+            consistent = consistent && started == threadCount &&
+                         sumMoney(accountTable.balance, accountTable.count) == expectedTotal &&
+                         transactionCount == 2 * completed;
+            unlockJournal();
+            unlockAllAccounts();
+        }
+        if (threadCount == 1)
+        {
+            singleThreadRate = rates[0];
+        }
+        printf("%7d %15.0f %8.2fx %19.0f%s\n", threadCount, rates[0], rates[0] / singleThreadRate, rates[1],
+               consistent ? "" : " (MISMATCH)");
+    }
+    stopJournalDrainer();
+
+    clearTransactions();
+    clearAccounts();
+}
+
+// Index of the request a linear scan would serve next, as a plain list
+// honouring priority would have to find it
+int scanNextRequest(const struct RequestNode *requests, int count)
+{
+    int best = 0;
+    for (int i = 1; i < count; i++)
+    {
+        if (requestBefore(&requests[i], &requests[best]))
+        {
+            best = i;
+        }
+    }
+    return best;
+}
+
+// Service requests submitted over the last day with random priorities,
+// some cancelled and some reprioritized, then served. The heap's order is
+// checked against a linear scan over the same requests.
+void benchRequestQueue()
+{
+    const int n = 200000;
+    const int changes = n / 10;
+    const int scanned = 2000;
+    struct RequestNode *plain = (struct RequestNode *)malloc(n * sizeof(*plain));
+    int *ids = (int *)malloc(n * sizeof(int));
+    if (plain == NULL || ids == NULL)
+    {
+        printf("Not enough memory for the benchmark.\n");
+        free(plain);
+        free(ids);
+        return;
+    }
+
+    clearRequests();
+    Timestamp now = timestampNow();
+    struct ServiceRequest request = {0};
+    strcpy(request.requestType, "Bench");
+    double start = monotonicNow();
+    for (int i = 0; i < n; i++)
+    {
+        request.requestId = 1 + i;
+        request.accountNo = 100000 + i;
+        request.priority = 1 + rand() % 5;
+        request.submittedAt = now - (Timestamp)(rand() % 86400) * MICROS_PER_SECOND;
+        enqueueRequest(request);
+        plain[i] = (struct RequestNode){requestRank(request.priority, request.submittedAt), request.submittedAt,
+                                        request.requestId, request.accountNo, request.priority, NULL};
+        ids[i] = request.requestId;
+    }
+    double enqueueTime = monotonicNow() - start;
+
+    // Cancel and reprioritize distinct requests, picked by shuffling the IDs
+    for (int i = 0; i < 2 * changes; i++)
+    {
+        int j = i + rand() % (n - i);
+        int id = ids[j];
+        ids[j] = ids[i];
+        ids[i] = id;
+    }
+    start = monotonicNow();
+    struct ServiceRequest cancelled;
+    for (int i = 0; i < changes; i++)
+    {
+        cancelRequest(ids[i], &cancelled);
+    }
+    double cancelTime = monotonicNow() - start;
+    start = monotonicNow();
+    for (int i = changes; i < 2 * changes; i++)
+    {
+        reprioritizeRequest(ids[i], 1 + rand() % 5);
+    }
+    double reprioritizeTime = monotonicNow() - start;
+
+    // Apply the same changes to the plain list
+    int plainCount = n;
+    for (int i = 0; i < plainCount; i++)
+    {
+        int pos = idIndexFind(&serviceQueue.positions, plain[i].requestId);
+        if (pos == -1)
+        {
+            plain[i--] = plain[--plainCount];
+            continue;
+        }
+        plain[i].priority = serviceQueue.heap[pos]->priority;
+        plain[i].rank = serviceQueue.heap[pos]->rank;
+    }
+
+    int remaining = serviceQueue.count;
+    bool ordered = remaining == plainCount;
+    start = monotonicNow();
+    struct ServiceRequest previous = dequeueRequest();
+    ids[0] = previous.requestId;
+    for (int i = 1; i < remaining; i++)
+    {
+        struct ServiceRequest next = dequeueRequest();
+        ids[i] = next.requestId; // Order served, for the scan to match
+        struct RequestNode a = {requestRank(previous.priority, previous.submittedAt), 0, previous.requestId};
+        struct RequestNode b = {requestRank(next.priority, next.submittedAt), 0, next.requestId};
+        ordered = ordered && requestBefore(&a, &b);
+        previous = next;
+    }
+    double dequeueTime = monotonicNow() - start;
+
+    // The scan is quadratic; time only the first requests it serves
+    bool matched = true;
+    start = monotonicNow();
+    for (int i = 0; i < scanned && plainCount > 0; i++)
+    {
+        int best = scanNextRequest(plain, plainCount);
+        matched = matched && plain[best].requestId == ids[i];
+        plain[best] = plain[--plainCount];
+    }
+    double scanTime = monotonicNow() - start;
+
+    printf("%d requests, %d cancelled, %d reprioritized\n", n, changes, changes);
+    printf("%-22s %12s\n", "", "us/op");
+    printf("%-22s %12.3f\n", "Enqueue", enqueueTime * 1e6 / n);
+    printf("%-22s %12.3f\n", "Cancel by ID", cancelTime * 1e6 / changes);
+    printf("%-22s %12.3f\n", "Reprioritize by ID", reprioritizeTime * 1e6 / changes);
+    printf("%-22s %12.3f%s\n", "Dequeue (heap)", dequeueTime * 1e6 / remaining, ordered ? "" : " (MISMATCH)");
+    printf("%-22s %12.3f%s\n", "Dequeue (linear scan)", scanTime * 1e6 / scanned, matched ? "" : " (MISMATCH)");
+
+    free(plain);
+    free(ids);
+    clearRequests();
+}
+
+// Checks the request pool's ordering and simulates work per request
+struct PoolBenchContext
+{
+    int *lastRequestId; // Per account, indexed from accountNo 0
+    atomic_llong outOfOrder;
+    int spin;
+};
+
+void benchPoolHandler(const struct ServiceRequest *request, int worker, void *context)
+{
+    (void)worker;
+    struct PoolBenchContext *bench = (struct PoolBenchContext *)context;
+    // Same priority and increasing submission times: each account's
+    // requests must arrive in ID order
+    if (request->requestId <= bench->lastRequestId[request->accountNo])
+    {
+        atomic_fetch_add(&bench->outOfOrder, 1);
+    }
+    bench->lastRequestId[request->accountNo] = request->requestId;
+    volatile unsigned int x = (unsigned int)request->requestId;
+    for (int i = 0; i < bench->spin; i++)
+    {
+        x = x * 1103515245u + 12345u;
+    }
+}
+
+// A complaint spike after an outage: requests over a few thousand accounts,
+// a tenth of them from one account, each taking a few microseconds, served
+// by 1, 2, 4... workers
+void benchRequestPool()
+{
+    const int n = 200000;
+    const int accounts = 5000;
+    struct PoolBenchContext bench;
+    bench.lastRequestId = (int *)malloc(accounts * sizeof(int));
+    if (bench.lastRequestId == NULL)
+    {
+        printf("Not enough memory for the benchmark.\n");
+        return;
+    }
+    bench.spin = 2000;
+
+    int processors = processorCount();
+    printf("%d requests over %d accounts, %d processor(s)\n", n, accounts, processors);
+    printf("%-8s %12s %10s %10s %10s %10s\n", "Workers", "Requests/s", "Wait p50", "Wait p99", "Stolen", "Order");
+    for (int workers = 1; workers <= 2 * processors && workers <= REQUEST_POOL_MAX_WORKERS; workers *= 2)
+    {
+        clearRequests();
+        struct ServiceRequest request = {0};
+        strcpy(request.requestType, "Outage");
+        request.priority = 3;
+        Timestamp now = timestampNow();
+        for (int i = 0; i < n; i++)
+        {
+            request.requestId = 1 + i;
+            request.accountNo = i % 10 == 0 ? 0 : rand() % accounts;
+            request.submittedAt = now + i;
+            enqueueRequest(request);
+        }
+        memset(bench.lastRequestId, 0, accounts * sizeof(int));
+        atomic_store(&bench.outOfOrder, 0);
+
+        struct RequestPoolStats stats;
+        processRequestsInPool(workers, benchPoolHandler, &bench, &stats);
+        long long stolen = 0;
+        for (int i = 0; i < stats.workers; i++)
+        {
+            stolen += stats.workerStolen[i];
+        }
+        bool complete = stats.processed == n && serviceQueue.count == 0;
+        printf("%-8d %12.0f %8.1fus %8.1fus %10lld %10s\n", workers, stats.processed / stats.seconds,
+               stats.waitP50 * 1e6, stats.waitP99 * 1e6, stolen,
+               atomic_load(&bench.outOfOrder) == 0 && complete ? "kept" : "MISMATCH");
+    }
+    free(bench.lastRequestId);
+    clearRequests();
+}
+
+// The route search before the heap: pick the nearest unsettled branch by
+// scanning them all. Kept to check benchRoutes against.
+float scanRouteDistance(int startIndex, int endIndex, float *distance, bool *visited)
+{
+    for (int i = 0; i < branchRoutes.branchCount; i++)
+    {
+        distance[i] = FLT_MAX;
+        visited[i] = false;
+    }
+    distance[startIndex] = 0.0;
+    for (int count = 0; count < branchRoutes.branchCount; count++)
+    {
+        int current = -1;
+        for (int i = 0; i < branchRoutes.branchCount; i++)
+        {
+            if (!visited[i] && (current == -1 || distance[i] < distance[current]))
+            {
+                current = i;
+            }
+        }
+        if (current == -1 || distance[current] == FLT_MAX || current == endIndex)
+        {
+            break;
+        }
+        visited[current] = true;
+        for (int e = branchRoutes.offsets[current]; e < branchRoutes.offsets[current + 1]; e++)
+        {
+            float newDist = distance[current] + branchRoutes.distances[e];
+            if (!visited[branchRoutes.targets[e]] && newDist < distance[branchRoutes.targets[e]])
+            {
+                distance[branchRoutes.targets[e]] = newDist;
+            }
+        }
+    }
+    return distance[endIndex];
+}
+
+// Build a road-like network of n branches and ATMs: a jittered grid, each
+// site linked both ways to its right and lower neighbours, with a few
+// longer links. IDs are spread out so they don't match indices.
+void buildBenchNetwork(int n)
+{
+    clearBranches();
+    int side = 1;
+    while (side * side < n)
+    {
+        side++;
+    }
+    for (int i = 0; i < n; i++)
+    {
+        addBranch(100000 + i * 7, "Bench", "Grid", "Manager", "0000000000", 1);
+    }
+    for (int i = 0; i < n; i++)
+    {
+        int id = 100000 + i * 7;
+        if ((i + 1) % side != 0 && i + 1 < n)
+        {
+            float d = 1.0f + (rand() % 100) / 100.0f;
+            addConnection(id, id + 7, d);
+            addConnection(id + 7, id, d);
+        }
+        if (i + side < n)
+        {
+            float d = 1.0f + (rand() % 100) / 100.0f;
+            addConnection(id, id + side * 7, d);
+            addConnection(id + side * 7, id, d);
+        }
+        if (rand() % 50 == 0)
+        {
+            int other = rand() % n;
+            addConnection(id, 100000 + other * 7, (float)(abs(other - i) % side + abs(other - i) / side) * 1.5f);
+        }
+    }
+}
+
+// Route distances summed in different orders can differ by rounding
+bool sameDistance(float a, float b)
+{
+    float gap = a > b ? a - b : b - a;
+    return gap <= 1e-4f * (a > 1.0f ? a : 1.0f);
+}
+
+// Whether a route's hops are links of the network and add up to its
+// distance
+bool routeAddsUp(const int *path, int pathLength, int startIndex, int endIndex, float distance)
+{
+    if (pathLength == 0 || path[0] != startIndex || path[pathLength - 1] != endIndex)
+    {
+        return false;
+    }
+    float total = 0.0f;
+    for (int i = 0; i + 1 < pathLength; i++)
+    {
+        float hop = FLT_MAX;
+        for (int e = branchRoutes.offsets[path[i]]; e < branchRoutes.offsets[path[i] + 1]; e++)
+        {
+            if (branchRoutes.targets[e] == path[i + 1] && branchRoutes.distances[e] < hop)
+            {
+                hop = branchRoutes.distances[e];
+            }
+        }
+        if (hop == FLT_MAX)
+        {
+            return false;
+        }
+        total += hop;
+    }
+    return sameDistance(total, distance);
+}
+
+// Route searches on networks of 10 to 100,000 branches: building the
+// network, compiling it, and heap Dijkstra queries between random branches,
+// checked against the linear scan where that is affordable
+void benchRoutes()
+{
+    const int sizes[] = {10, 100, 1000, 10000, 100000};
+    const int queries = 1000;
+    routeMatrix.enabled = false; // Time the searches themselves
+    printf("%-10s %10s %12s %12s %12s %12s %10s\n", "Branches", "Edges", "Build us/br", "Compile ms",
+           "Query us", "Scan us", "Check");
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+    {
+        int n = sizes[s];
+        double start = monotonicNow();
+        buildBenchNetwork(n);
+        double buildTime = monotonicNow() - start;
+        if (branchCount != n)
+        {
+            printf("Not enough memory for the benchmark.\n");
+            break;
+        }
+
+        start = monotonicNow();
+        buildBranchRoutes();
+        double compileTime = monotonicNow() - start;
+
+        int *pairs = (int *)malloc(2 * queries * sizeof(int));
+        float *found = (float *)malloc(queries * sizeof(float));
+        float *scanDistance = (float *)malloc(n * sizeof(float));
+        bool *scanVisited = (bool *)malloc(n * sizeof(bool));
+        if (pairs == NULL || found == NULL || scanDistance == NULL || scanVisited == NULL)
+        {
+            printf("Not enough memory for the benchmark.\n");
+            free(pairs);
+            free(found);
+            free(scanDistance);
+            free(scanVisited);
+            break;
+        }
+        for (int q = 0; q < 2 * queries; q++)
+        {
+            pairs[q] = rand() % n;
+        }
+
+        bool matched = true;
+        start = monotonicNow();
+        for (int q = 0; q < queries; q++)
+        {
+            const int *path;
+            int pathLength;
+            found[q] = shortestPath(pairs[2 * q], pairs[2 * q + 1], &path, &pathLength);
+            matched = matched && (found[q] == FLT_MAX ||
+                                  routeAddsUp(path, pathLength, pairs[2 * q], pairs[2 * q + 1], found[q]));
+        }
+        double queryTime = monotonicNow() - start;
+
+        // The scan is quadratic in the branch count; keep it to about a
+        // second
+        int scanned = n <= 1000 ? queries : n <= 10000 ? 10 : 0;
+        start = monotonicNow();
+        for (int q = 0; q < scanned; q++)
+        {
+            matched = matched && scanRouteDistance(pairs[2 * q], pairs[2 * q + 1], scanDistance, scanVisited) == found[q];
+        }
+        double scanTime = monotonicNow() - start;
+
+        char scanText[32] = "-";
+        if (scanned > 0)
+        {
+            snprintf(scanText, sizeof(scanText), "%.2f", scanTime * 1e6 / scanned);
+        }
+        printf("%-10d %10d %12.3f %12.3f %12.2f %12s %10s\n", n, branchRoutes.edgeCount, buildTime * 1e6 / n,
+               compileTime * 1e3, queryTime * 1e6 / queries, scanText, matched ? "ok" : "MISMATCH");
+        free(pairs);
+        free(found);
+        free(scanDistance);
+        free(scanVisited);
+    }
+    routeMatrix.enabled = true;
+    clearBranches();
+}
+
+// The route matrix on networks up to its size limit: filling it, lookups
+// against Dijkstra, and keeping it current as links are added against
+// filling it again, checked against Dijkstra afterwards
+void benchRouteMatrix()
+{
+    const int sizes[] = {100, 500, 2000};
+    const int queries = 2000;
+    const int added = 200;
+    printf("%d processor(s)\n", processorCount());
+    printf("%-10s %10s %10s %12s %12s %12s %12s %10s\n", "Branches", "Fill ms", "Fill MB", "Lookup us",
+           "Dijkstra us", "Add link us", "Refill ms", "Check");
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+    {
+        int n = sizes[s];
+        buildBenchNetwork(n);
+        buildBranchRoutes();
+        int *pairs = (int *)malloc(2 * queries * sizeof(int));
+        if (branchCount != n || pairs == NULL)
+        {
+            printf("Not enough memory for the benchmark.\n");
+            free(pairs);
+            break;
+        }
+        for (int q = 0; q < 2 * queries; q++)
+        {
+            pairs[q] = rand() % n;
+        }
+
+        double start = monotonicNow();
+        bool matched = buildRouteMatrix(processorCount());
+        double fillTime = monotonicNow() - start;
+
+        const int *path;
+        int pathLength;
+        start = monotonicNow();
+        for (int q = 0; q < queries; q++)
+        {
+            shortestPath(pairs[2 * q], pairs[2 * q + 1], &path, &pathLength);
+        }
+        double lookupTime = monotonicNow() - start;
+        routeMatrix.enabled = false;
+        start = monotonicNow();
+        for (int q = 0; q < queries; q++)
+        {
+            shortestPath(pairs[2 * q], pairs[2 * q + 1], &path, &pathLength);
+        }
+        double dijkstraTime = monotonicNow() - start;
+        routeMatrix.enabled = true;
+
+        // New links between random sites, a third of them shortcuts
+        start = monotonicNow();
+        for (int k = 0; k < added; k++)
+        {
+            int from = rand() % n;
+            int to = rand() % n;
+            addConnection(branchGraph[from].data.branchId, branchGraph[to].data.branchId,
+                          k % 3 == 0 ? 0.5f : 1.0f + (float)(rand() % 2000) / 10.0f);
+        }
+        double addTime = monotonicNow() - start;
+        buildBranchRoutes();
+
+        // The matrix kept current must agree with Dijkstra
+        for (int q = 0; q < queries && matched; q++)
+        {
+            float expected = searchRoute(&routeSearch, pairs[2 * q], pairs[2 * q + 1], &pathLength);
+            float distance = shortestPath(pairs[2 * q], pairs[2 * q + 1], &path, &pathLength);
+            matched = expected == FLT_MAX ? distance == FLT_MAX
+                                          : sameDistance(distance, expected) &&
+                                            routeAddsUp(path, pathLength, pairs[2 * q], pairs[2 * q + 1], distance);
+        }
+
+        start = monotonicNow();
+        buildRouteMatrix(processorCount());
+        double refillTime = monotonicNow() - start;
+
+        printf("%-10d %10.2f %10.1f %12.3f %12.2f %12.2f %12.2f %10s\n", n, fillTime * 1e3,
+               (double)n * n * (sizeof(float) + sizeof(int)) / (1024.0 * 1024.0), lookupTime * 1e6 / queries,
+               dijkstraTime * 1e6 / queries, addTime * 1e6 / added, refillTime * 1e3, matched ? "ok" : "MISMATCH");
+        free(pairs);
+    }
+    clearBranches();
+}
+
+// Build a national network of n branches and ATMs: towns of 100 sites on
+// a local street grid, laid out on a grid of their own. Neighbouring towns
+// are joined by a highway between their centres and a slower road between
+// facing edges.
+void buildBenchRoadNetwork(int n)
+{
+    const int side = 10; // Sites along a town's streets
+    const int perTown = side * side;
+    clearBranches();
+    int towns = (n + perTown - 1) / perTown;
+    int townSide = 1;
+    while (townSide * townSide < towns)
+    {
+        townSide++;
+    }
+    for (int i = 0; i < n; i++)
+    {
+        addBranch(100000 + i * 7, "Bench", "Town", "Manager", "0000000000", 1);
+    }
+    for (int i = 0; i < n; i++)
+    {
+        int id = 100000 + i * 7;
+        int site = i % perTown;
+        if (site % side + 1 < side && i + 1 < n)
+        {
+            float d = 1.0f + (rand() % 100) / 100.0f;
+            addConnection(id, id + 7, d);
+            addConnection(id + 7, id, d);
+        }
+        if (site + side < perTown && i + side < n)
+        {
+            float d = 1.0f + (rand() % 100) / 100.0f;
+            addConnection(id, id + side * 7, d);
+            addConnection(id + side * 7, id, d);
+        }
+    }
+    for (int town = 0; town < towns; town++)
+    {
+        int neighbours[2] = {town % townSide + 1 < townSide ? town + 1 : -1, town + townSide};
+        for (int j = 0; j < 2; j++)
+        {
+            int other = neighbours[j];
+            // Centres, then the facing edge sites: east and west, or south and north
+            int ends[2][2] = {{town * perTown + perTown / 2 + side / 2, other * perTown + perTown / 2 + side / 2},
+                              {town * perTown + (j == 0 ? (side / 2) * side + side - 1 : (side - 1) * side + side / 2),
+                               other * perTown + (j == 0 ? (side / 2) * side : side / 2)}};
+            for (int k = 0; k < 2 && other != -1 && other < towns; k++)
+            {
+                if (ends[k][0] < n && ends[k][1] < n)
+                {
+                    float d = k == 0 ? side * 0.8f : 1.5f;
+                    addConnection(100000 + ends[k][0] * 7, 100000 + ends[k][1] * 7, d);
+                    addConnection(100000 + ends[k][1] * 7, 100000 + ends[k][0] * 7, d);
+                }
+            }
+        }
+    }
+}
+
+// Route hierarchies on networks of 1,000 to 100,000 branches: building
+// one, and queries against Dijkstra between the same random branches
+void benchRouteHierarchy()
+{
+    const int sizes[] = {1000, 10000, 100000};
+    const int queries = 1000;
+    printf("%-10s %10s %10s %10s %12s %12s %10s\n", "Branches", "Edges", "Shortcuts", "Build ms", "Query us",
+           "Dijkstra us", "Check");
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+    {
+        int n = sizes[s];
+        buildBenchRoadNetwork(n);
+        buildBranchRoutes();
+        int *pairs = (int *)malloc(2 * queries * sizeof(int));
+        float *found = (float *)malloc(queries * sizeof(float));
+        double start = monotonicNow();
+        bool matched = pairs != NULL && found != NULL && buildRouteHierarchy();
+        double buildTime = monotonicNow() - start;
+        if (!matched)
+        {
+            printf("Not enough memory for the benchmark.\n");
+            free(pairs);
+            free(found);
+            break;
+        }
+        int shortcuts = 0;
+        for (int e = 0; e < routeHierarchy.upCount; e++)
+        {
+            shortcuts += routeHierarchy.upArcs[e].middle != -1;
+        }
+        for (int e = 0; e < routeHierarchy.downCount; e++)
+        {
+            shortcuts += routeHierarchy.downArcs[e].middle != -1;
+        }
+        for (int q = 0; q < 2 * queries; q++)
+        {
+            pairs[q] = rand() % n;
+        }
+
+        int pathLength;
+        start = monotonicNow();
+        for (int q = 0; q < queries; q++)
+        {
+            matched = hierarchyRoute(&hierarchySearch, pairs[2 * q], pairs[2 * q + 1], &found[q], &pathLength) &&
+                      (found[q] == FLT_MAX ||
+                       routeAddsUp(hierarchySearch.path, pathLength, pairs[2 * q], pairs[2 * q + 1], found[q])) &&
+                      matched;
+        }
+        double queryTime = monotonicNow() - start;
+
+        start = monotonicNow();
+        for (int q = 0; q < queries; q++)
+        {
+            float expected = searchRoute(&routeSearch, pairs[2 * q], pairs[2 * q + 1], &pathLength);
+            matched = matched && (expected == FLT_MAX ? found[q] == FLT_MAX : sameDistance(found[q], expected));
+        }
+        double dijkstraTime = monotonicNow() - start;
+
+        printf("%-10d %10d %10d %10.1f %12.2f %12.2f %10s\n", n, branchRoutes.edgeCount, shortcuts, buildTime * 1e3,
+               queryTime * 1e6 / queries, dijkstraTime * 1e6 / queries, matched ? "ok" : "MISMATCH");
+        free(pairs);
+        free(found);
+    }
+    clearBranches();
+}
+
+// A day's cash runs on a 20,000-branch network: routes from 50 depots to
+// 40 branches each, one at a time and as a batch on 1, 2, 4... threads
+void benchRoutePlanning()
+{
+    const int n = 20000;
+    const int depots = 50;
+    const int stops = 40;
+    const int count = depots * stops;
+    buildBenchRoadNetwork(n);
+    buildBranchRoutes();
+    struct RouteQuery *queries = (struct RouteQuery *)malloc(count * sizeof(struct RouteQuery));
+    float *expected = (float *)malloc(count * sizeof(float));
+    if (queries == NULL || expected == NULL)
+    {
+        printf("Not enough memory for the benchmark.\n");
+        free(queries);
+        free(expected);
+        return;
+    }
+    for (int d = 0; d < depots; d++)
+    {
+        int depot = rand() % n;
+        for (int i = 0; i < stops; i++)
+        {
+            // Interleaved, as a scheduler would submit them
+            queries[i * depots + d].startIndex = depot;
+            queries[i * depots + d].endIndex = rand() % n;
+        }
+    }
+
+    int processors = processorCount();
+    printf("%d routes from %d depots over %d branches, %d processor(s)\n", count, depots, n, processors);
+    printf("%-10s %12s %10s %10s\n", "Workers", "Routes/s", "Speedup", "Check");
+    const int *path;
+    int pathLength;
+    double start = monotonicNow();
+    for (int q = 0; q < count; q++)
+    {
+        expected[q] = shortestPath(queries[q].startIndex, queries[q].endIndex, &path, &pathLength);
+    }
+    double singleTime = monotonicNow() - start;
+    printf("%-10s %12.0f %10s %10s\n", "One each", count / singleTime, "1.0x", "-");
+
+    for (int workers = 1; workers <= 2 * processors && workers <= ROUTE_BATCH_MAX_WORKERS; workers *= 2)
+    {
+        struct RouteBatch batch;
+        start = monotonicNow();
+        bool matched = planRoutes(&batch, queries, count, workers);
+        double batchTime = monotonicNow() - start;
+        for (int q = 0; q < count && matched; q++)
+        {
+            struct RouteQuery *route = &queries[q];
+            matched = expected[q] == FLT_MAX ? route->distance == FLT_MAX
+                                             : sameDistance(route->distance, expected[q]) &&
+                                                   routeAddsUp(route->path, route->pathLength, route->startIndex,
+                                                               route->endIndex, route->distance);
+        }
+        printf("%-10d %12.0f %9.1fx %10s\n", workers, count / batchTime, singleTime / batchTime,
+               matched ? "ok" : "MISMATCH");
+        freeRouteBatch(&batch);
+    }
+    free(queries);
+    free(expected);
+    clearBranches();
+}
+
+int runBenchmark(const char *name)
+{
+    if (strcmp(name, "lookup") == 0)
+    {
+        benchAccountLookup();
+        return 0;
+    }
+    if (strcmp(name, "alloc") == 0)
+    {
+        benchAllocator();
+        return 0;
+    }
+    if (strcmp(name, "sweep") == 0)
+    {
+        benchBalanceSweep();
+        return 0;
+    }
+    if (strcmp(name, "startup") == 0)
+    {
+        benchStartup();
+        return 0;
+    }
+    if (strcmp(name, "wal") == 0)
+    {
+        benchJournal();
+        return 0;
+    }
+    if (strcmp(name, "checkpoint") == 0)
+    {
+        benchCheckpoint();
+        return 0;
+    }
+    if (strcmp(name, "history") == 0)
+    {
+        benchHistoryLoad();
+        return 0;
+    }
+    if (strcmp(name, "statement") == 0)
+    {
+        benchStatements();
+        return 0;
+    }
+    if (strcmp(name, "txid") == 0)
+    {
+        benchTransactionIds();
+        return 0;
+    }
+    if (strcmp(name, "stamp") == 0)
+    {
+        benchTimestamps();
+        return 0;
+    }
+    if (strcmp(name, "range") == 0)
+    {
+        benchTimeRanges();
+        return 0;
+    }
+    if (strcmp(name, "concurrent") == 0)
+    {
+        benchConcurrentTransfers();
+        return 0;
+    }
+    if (strcmp(name, "batch") == 0)
+    {
+        benchBatchPosting();
+        return 0;
+    }
+    if (strcmp(name, "requests") == 0)
+    {
+        benchRequestQueue();
+        return 0;
+    }
+    if (strcmp(name, "pool") == 0)
+    {
+        benchRequestPool();
+        return 0;
+    }
+    if (strcmp(name, "routes") == 0)
+    {
+        benchRoutes();
+        return 0;
+    }
+    if (strcmp(name, "matrix") == 0)
+    {
+        benchRouteMatrix();
+        return 0;
+    }
+    if (strcmp(name, "plan") == 0)
+    {
+        benchRoutePlanning();
+        return 0;
+    }
+    if (strcmp(name, "hierarchy") == 0)
+    {
+        benchRouteHierarchy();
+        return 0;
+    }
+
+    printf("Unknown benchmark '%s'. Available: lookup, alloc, sweep, startup, wal, checkpoint, history, statement, txid, stamp, range, concurrent, batch, requests, pool, routes, matrix, hierarchy, plan\n", name);
+    return 1;
+}
+
+/***************************************************
+ * SECTION 10: SCRIPTED COMMANDS
+ ***************************************************/
+
+// Send stdout to another descriptor, so loading's status messages stay out
+// of machine-readable output. Returns the old descriptor for restoreStdout.
+int redirectStdout(int fd)
+{
+    fflush(stdout);
+#ifdef _WIN32
+    int saved = _dup(_fileno(stdout));
+    if (saved != -1)
+    {
+        _dup2(fd, _fileno(stdout));
+    }
+#else
+    int saved = dup(fileno(stdout));
+    if (saved != -1)
+    {
+        dup2(fd, fileno(stdout));
+    }
+#endif
+    return saved;
+}
+
+void restoreStdout(int saved)
+{
+    if (saved == -1)
+    {
+        return;
+    }
+    fflush(stdout);
+#ifdef _WIN32
+    _dup2(saved, _fileno(stdout));
+    _close(saved);
+#else
+    dup2(saved, fileno(stdout));
+    close(saved);
+#endif
+}
+
+// Why a deposit, withdrawal or transfer was turned down, worked out after
+// the fact; only meaningful while nothing else changes the accounts
+const char *moneyFailureReason(int accountNo, int toAccountNo, Money amount)
+{
+    if (!moneyAmountValid(amount))
+    {
+        return batchStatusName(BATCH_BAD_AMOUNT);
+    }
+    int row = findAccount(accountNo);
+    if (row == -1 || findAccount(toAccountNo) == -1)
+    {
+        return batchStatusName(BATCH_NO_ACCOUNT);
+    }
+    // Covered but still turned down: the credit would overflow the balance
+    if (accountTable.balance[row] >= amount)
+    {
+        return batchStatusName(BATCH_BAD_AMOUNT);
+    }
+    return batchStatusName(BATCH_INSUFFICIENT_FUNDS);
+}
+
+// Run one line of the command protocol and write the reply: "OK" and any
+// results, or "ERR" and a reason.
+//   DEP <account> <amount>        OK <balance>
+//   WDR <account> <amount>        OK <balance>
+//   XFER <from> <to> <amount>     OK <from balance> <to balance>
+//   BAL <account>                 OK <balance>
+//   PATH <from> <to>              OK <distance> <branch>...
+//   UNDO                          OK <account> <amount>
+//   SYNC                          OK once the journal is on disk
+//   SAVE                          OK once every data file is written
+void runCommand(const char *line, char *reply, size_t size)
+{
+    char command[8], first[32], second[32], third[32];
+    int fields = sscanf(line, "%7s %31s %31s %31s", command, first, second, third);
+    int accountNo, toAccountNo;
+    Money amount;
+    char text[MONEY_TEXT_SIZE], toText[MONEY_TEXT_SIZE];
+
+    if (fields == 3 && (strcmp(command, "DEP") == 0 || strcmp(command, "WDR") == 0) &&
+        sscanf(first, "%d", &accountNo) == 1 && parseMoney(second, &amount))
+    {
+        bool done = command[0] == 'D' ? deposit(accountNo, amount) : withdraw(accountNo, amount);
+        if (done)
+        {
+            snprintf(reply, size, "OK %s", formatMoney(accountTable.balance[findAccount(accountNo)], text));
+        }
+        else
+        {
+            snprintf(reply, size, "ERR %s", moneyFailureReason(accountNo, accountNo, amount));
+        }
+    }
+    else if (fields == 4 && strcmp(command, "XFER") == 0 && sscanf(first, "%d", &accountNo) == 1 &&
+             sscanf(second, "%d", &toAccountNo) == 1 && parseMoney(third, &amount))
+    {
+        if (transfer(accountNo, toAccountNo, amount))
+        {
+            snprintf(reply, size, "OK %s %s", formatMoney(accountTable.balance[findAccount(accountNo)], text),
+                     formatMoney(accountTable.balance[findAccount(toAccountNo)], toText));
+        }
+        else
+        {
+            snprintf(reply, size, "ERR %s", moneyFailureReason(accountNo, toAccountNo, amount));
+        }
+    }
+    else if (fields == 2 && strcmp(command, "BAL") == 0 && sscanf(first, "%d", &accountNo) == 1)
+    {
+        int row = findAccount(accountNo);
+        if (row == -1)
+        {
+            snprintf(reply, size, "ERR %s", batchStatusName(BATCH_NO_ACCOUNT));
+        }
+        else
+        {
+            snprintf(reply, size, "OK %s", formatMoney(accountTable.balance[row], text));
+        }
+    }
+    else if (fields == 3 && strcmp(command, "PATH") == 0 && sscanf(first, "%d", &accountNo) == 1 &&
+             sscanf(second, "%d", &toAccountNo) == 1)
+    {
+        int startIndex = findBranchIndex(accountNo);
+        int endIndex = findBranchIndex(toAccountNo);
+        const int *path = NULL;
+        int pathLength = 0;
+        float distance = startIndex == -1 || endIndex == -1 ? FLT_MAX : shortestPath(startIndex, endIndex, &path, &pathLength);
+        if (startIndex == -1 || endIndex == -1)
+        {
+            snprintf(reply, size, "ERR NO_BRANCH");
+        }
+        else if (distance == FLT_MAX)
+        {
+            snprintf(reply, size, "ERR NO_PATH");
+        }
+        else
+        {
+            int used = snprintf(reply, size, "OK %.2f", distance);
+            for (int i = 0; i < pathLength && used > 0 && (size_t)used < size; i++)
+            {
+                used += snprintf(reply + used, size - used, " %d", branchGraph[path[i]].data.branchId);
+            }
+        }
+    }
+    else if (fields == 1 && strcmp(command, "UNDO") == 0)
+    {
+        struct Transaction undone;
+        if (undoLast(&undone))
+        {
+            snprintf(reply, size, "OK %d %s", undone.accountNo, formatMoney(undone.amount, text));
+        }
+        else
+        {
+            snprintf(reply, size, "ERR NOTHING_TO_UNDO");
+        }
+    }
+    else if (fields == 1 && strcmp(command, "SYNC") == 0)
+    {
+        mutexLock(&journalLock);
+        drainJournalRings();
+        bool synced = walFlush();
+        mutexUnlock(&journalLock);
+        snprintf(reply, size, synced ? "OK" : "ERR SYNC_FAILED");
+    }
+    else if (fields == 1 && strcmp(command, "SAVE") == 0)
+    {
+        snprintf(reply, size, writeAllData() ? "OK" : "ERR SAVE_FAILED");
+    }
+    else
+    {
+        snprintf(reply, size, "ERR %s", batchStatusName(BATCH_BAD_LINE));
+    }
+}
+
+// Run a command file ("-" reads stdin) without the menus. Each command
+// gets a "<line> <reply>" line on stdout. Output is buffered and written
+// out when SYNC is run and at the end. Blank lines and lines starting with
+// '#' are skipped.
+bool runCommandFile(const char *path)
+{
+    FILE *file = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+    if (file == NULL)
+    {
+        fprintf(stderr, "Could not open %s\n", path);
+        return false;
+    }
+    setvbuf(stdout, NULL, _IOFBF, 1 << 16);
+
+    char line[256], reply[512];
+    long lineNumber = 0;
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        lineNumber++;
+        const char *text = line + strspn(line, " \t");
+        if (*text == '\0' || *text == '\n' || *text == '#')
+        {
+            continue;
+        }
+        runCommand(text, reply, sizeof(reply));
+        printf("%ld %s\n", lineNumber, reply);
+        if (strncmp(text, "SYNC", 4) == 0)
+        {
+            fflush(stdout);
+        }
+    }
+    fflush(stdout);
+
+    if (file != stdin)
+    {
+        fclose(file);
+    }
+    return true;
+}
+
+/***************************************************
+ * SECTION 11: NETWORK SERVER
+ ***************************************************/
+
+#ifdef __linux__
+
+volatile sig_atomic_t serverStopping = 0;
+
+void stopServer(int signalNumber)
+{
+    (void)signalNumber;
+    serverStopping = 1;
+}
+
+void putU32(unsigned char *p, unsigned int value)
+{
+    p[0] = (unsigned char)(value >> 24);
+    p[1] = (unsigned char)(value >> 16);
+    p[2] = (unsigned char)(value >> 8);
+    p[3] = (unsigned char)value;
+}
+
+unsigned int getU32(const unsigned char *p)
+{
+    return (unsigned int)p[0] << 24 | (unsigned int)p[1] << 16 | (unsigned int)p[2] << 8 | p[3];
+}
+
+void putU64(unsigned char *p, unsigned long long value)
+{
+    putU32(p, (unsigned int)(value >> 32));
+    putU32(p + 4, (unsigned int)value);
+}
+
+unsigned long long getU64(const unsigned char *p)
+{
+    return (unsigned long long)getU32(p) << 32 | getU32(p + 4);
+}
+
+const unsigned char *frameTake(struct FrameReader *reader, size_t size)
+{
+    static const unsigned char zeros[8] = {0};
+    if (!reader->ok || reader->left < size)
+    {
+        reader->ok = false;
+        return zeros;
+    }
+    const unsigned char *p = reader->p;
+    reader->p += size;
+    reader->left -= size;
+    return p;
+}
+
+unsigned int frameU8(struct FrameReader *reader)
+{
+    return *frameTake(reader, 1);
+}
+
+unsigned int frameU32(struct FrameReader *reader)
+{
+    return getU32(frameTake(reader, 4));
+}
+
+unsigned long long frameU64(struct FrameReader *reader)
+{
+    return getU64(frameTake(reader, 8));
+}
+
+// Text that doesn't fit in size bytes, terminator included, clears ok
+void frameText(struct FrameReader *reader, char *text, size_t size)
+{
+    size_t length = frameU8(reader);
+    if (length >= size)
+    {
+        reader->ok = false;
+    }
+    const unsigned char *p = frameTake(reader, reader->ok ? length : 0);
+    if (!reader->ok)
+    {
+        text[0] = '\0';
+        return;
+    }
+    memcpy(text, p, length);
+    text[length] = '\0';
+}
+
+// Room for size more bytes at the end of a byte buffer
+unsigned char *bufferReserve(unsigned char **buffer, size_t *used, size_t *capacity, size_t size)
+{
+    if (*used + size > *capacity)
+    {
+        size_t newCapacity = *capacity > 0 ? *capacity : 4096;
+        while (newCapacity < *used + size)
+        {
+            newCapacity *= 2;
+        }
+        unsigned char *grown = (unsigned char *)realloc(*buffer, newCapacity);
+        if (grown == NULL)
+        {
+            return NULL;
+        }
+        *buffer = grown;
+        *capacity = newCapacity;
+    }
+    unsigned char *p = *buffer + *used;
+    *used += size;
+    return p;
+}
+
+unsigned char *replyTake(struct FrameWriter *writer, size_t size)
+{
+    static unsigned char scratch[8];
+    struct ServerConnection *c = writer->connection;
+    unsigned char *p = writer->ok ? bufferReserve(&c->out, &c->outUsed, &c->outCapacity, size) : NULL;
+    if (p == NULL)
+    {
+        writer->ok = false;
+        return scratch;
+    }
+    return p;
+}
+
+void replyU8(struct FrameWriter *writer, unsigned int value)
+{
+    *replyTake(writer, 1) = (unsigned char)value;
+}
+
+void replyU32(struct FrameWriter *writer, unsigned int value)
+{
+    putU32(replyTake(writer, 4), value);
+}
+
+void replyU64(struct FrameWriter *writer, unsigned long long value)
+{
+    putU64(replyTake(writer, 8), value);
+}
+
+void replyText(struct FrameWriter *writer, const char *text)
+{
+    size_t length = strlen(text);
+    if (length > 255)
+    {
+        length = 255;
+    }
+    replyU8(writer, (unsigned int)length);
+    struct ServerConnection *c = writer->connection;
+    unsigned char *p = writer->ok ? bufferReserve(&c->out, &c->outUsed, &c->outCapacity, length) : NULL;
+    if (p == NULL)
+    {
+        writer->ok = false;
+        return;
+    }
+    memcpy(p, text, length);
+}
+
+// Start a reply: length (filled in by replyEnd), opcode, tag and status
+struct FrameWriter replyBegin(struct ServerConnection *connection, unsigned int op, unsigned int tag, int status)
+{
+    struct FrameWriter writer = {connection, connection->outUsed, true};
+    replyU32(&writer, 0);
+    replyU8(&writer, op);
+    replyU32(&writer, tag);
+    replyU8(&writer, (unsigned int)status);
+    return writer;
+}
+
+// Returns false if there was no memory for the reply, which drops the
+// connection
+bool replyEnd(struct FrameWriter *writer)
+{
+    struct ServerConnection *c = writer->connection;
+    if (!writer->ok)
+    {
+        c->outUsed = writer->start;
+        return false;
+    }
+    putU32(c->out + writer->start, (unsigned int)(c->outUsed - writer->start - 4));
+    return true;
+}
+
+// Why a deposit, withdrawal or transfer was turned down
+int serverMoneyStatus(int accountNo, int toAccountNo, Money amount)
+{
+    if (!moneyAmountValid(amount))
+    {
+        return SERVER_BAD_AMOUNT;
+    }
+    int row = findAccount(accountNo);
+    if (row == -1 || findAccount(toAccountNo) == -1)
+    {
+        return SERVER_NO_ACCOUNT;
+    }
+    // Covered but still turned down: the credit would overflow the balance
+    if (accountTable.balance[row] >= amount)
+    {
+        return SERVER_BAD_AMOUNT;
+    }
+    return SERVER_INSUFFICIENT_FUNDS;
+}
+
+Money lockedBalance(int accountNo)
+{
+    lockAccount(accountNo);
+    int row = findAccount(accountNo);
+    Money balance = row != -1 ? accountTable.balance[row] : 0;
+    unlockAccount(accountNo);
+    return balance;
+}
+
+// Handle one request and append its reply. Money operations go through
+// deposit, withdraw and transfer, which take the account locks and queue
+// the journal record; the reply is held until the round's commit.
+bool handleServerRequest(struct ServerConnection *connection, const unsigned char *body, size_t size)
+{
+    struct FrameReader reader = {body, size, true};
+    unsigned int op = frameU8(&reader);
+    unsigned int tag = frameU32(&reader);
+    struct FrameWriter writer;
+
+    if (op == SERVER_LOGIN)
+    {
+        char username[sizeof(users[0].username)], password[sizeof(users[0].password)];
+        frameText(&reader, username, sizeof(username));
+        frameText(&reader, password, sizeof(password));
+        int user = reader.ok ? findUser(username, password) : -1;
+        if (user != -1)
+        {
+            connection->loggedIn = true;
+            connection->isAdmin = users[user].isAdmin;
+        }
+        writer = replyBegin(connection, op, tag, !reader.ok ? SERVER_BAD_REQUEST : user == -1 ? SERVER_BAD_LOGIN : SERVER_OK);
+        if (user != -1)
+        {
+            replyU8(&writer, connection->isAdmin);
+        }
+        return replyEnd(&writer);
+    }
+    if (!connection->loggedIn)
+    {
+        writer = replyBegin(connection, op, tag, SERVER_NOT_LOGGED_IN);
+        return replyEnd(&writer);
+    }
+
+    switch (op)
+    {
+    case SERVER_DEPOSIT:
+    case SERVER_WITHDRAW:
+    {
+        int accountNo = (int)frameU32(&reader);
+        Money amount = (Money)frameU64(&reader);
+        if (!reader.ok)
+        {
+            break;
+        }
+        bool done = op == SERVER_DEPOSIT ? deposit(accountNo, amount) : withdraw(accountNo, amount);
+        writer = replyBegin(connection, op, tag, done ? SERVER_OK : serverMoneyStatus(accountNo, accountNo, amount));
+        if (done)
+        {
+            replyU64(&writer, (unsigned long long)lockedBalance(accountNo));
+        }
+        return replyEnd(&writer);
+    }
+    case SERVER_TRANSFER:
+    {
+        int fromAccountNo = (int)frameU32(&reader);
+        int toAccountNo = (int)frameU32(&reader);
+        Money amount = (Money)frameU64(&reader);
+        if (!reader.ok)
+        {
+            break;
+        }
+        bool done = transfer(fromAccountNo, toAccountNo, amount);
+        writer = replyBegin(connection, op, tag, done ? SERVER_OK : serverMoneyStatus(fromAccountNo, toAccountNo, amount));
+        if (done)
+        {
+            replyU64(&writer, (unsigned long long)lockedBalance(fromAccountNo));
+            replyU64(&writer, (unsigned long long)lockedBalance(toAccountNo));
+        }
+        return replyEnd(&writer);
+    }
+    case SERVER_LOOKUP:
+    {
+        int accountNo = (int)frameU32(&reader);
+        if (!reader.ok)
+        {
+            break;
+        }
+        lockAccount(accountNo);
+        int row = findAccount(accountNo);
+        writer = replyBegin(connection, op, tag, row != -1 ? SERVER_OK : SERVER_NO_ACCOUNT);
+        if (row != -1)
+        {
+            replyU64(&writer, (unsigned long long)accountTable.balance[row]);
+            replyText(&writer, accountProfile(row)->name);
+        }
+        unlockAccount(accountNo);
+        return replyEnd(&writer);
+    }
+    case SERVER_SERVICE_REQUEST:
+    {
+        struct ServiceRequest request;
+        int accountNo = (int)frameU32(&reader);
+        int priority = (int)frameU8(&reader);
+        frameText(&reader, request.requestType, sizeof(request.requestType));
+        frameText(&reader, request.description, sizeof(request.description));
+        if (!reader.ok || priority < 1 || priority > 5)
+        {
+            break;
+        }
+        // The service queue has no lock of its own; the event loop is its
+        // only user while serving
+        int requestId = submitServiceRequest(accountNo, request.requestType, request.description, priority);
+        writer = replyBegin(connection, op, tag, requestId != -1 ? SERVER_OK : SERVER_NO_ACCOUNT);
+        if (requestId != -1)
+        {
+            replyU32(&writer, (unsigned int)requestId);
+        }
+        return replyEnd(&writer);
+    }
+    case SERVER_SHORTEST_PATH:
+    {
+        int startIndex = findBranchIndex((int)frameU32(&reader));
+        int endIndex = findBranchIndex((int)frameU32(&reader));
+        if (!reader.ok)
+        {
+            break;
+        }
+        const int *path = NULL;
+        int pathLength = 0;
+        float distance = startIndex == -1 || endIndex == -1 ? FLT_MAX : shortestPath(startIndex, endIndex, &path, &pathLength);
+        writer = replyBegin(connection, op, tag,
+                            startIndex == -1 || endIndex == -1 ? SERVER_NO_BRANCH : distance == FLT_MAX ? SERVER_NO_PATH : SERVER_OK);
+        if (distance != FLT_MAX)
+        {
+            unsigned int bits;
+            memcpy(&bits, &distance, sizeof(bits));
+            replyU32(&writer, bits);
+            replyU32(&writer, (unsigned int)pathLength);
+            for (int i = 0; i < pathLength; i++)
+            {
+                replyU32(&writer, (unsigned int)branchGraph[path[i]].data.branchId);
+            }
+        }
+        return replyEnd(&writer);
+    }
+    case SERVER_ROUTE_BATCH:
+    {
+        unsigned int count = frameU32(&reader);
+        if (!reader.ok || count > reader.left / 8)
+        {
+            break;
+        }
+        struct RouteQuery *queries = (struct RouteQuery *)malloc((count + 1) * sizeof(struct RouteQuery));
+        if (queries == NULL)
+        {
+            return false;
+        }
+        for (unsigned int q = 0; q < count; q++)
+        {
+            queries[q].startIndex = findBranchIndex((int)frameU32(&reader));
+            queries[q].endIndex = findBranchIndex((int)frameU32(&reader));
+        }
+        struct RouteBatch batch;
+        if (!planRoutes(&batch, queries, (int)count, processorCount()))
+        {
+            free(queries);
+            return false;
+        }
+        writer = replyBegin(connection, op, tag, SERVER_OK);
+        for (unsigned int q = 0; q < count; q++)
+        {
+            struct RouteQuery *route = &queries[q];
+            replyU8(&writer, route->startIndex == -1 || route->endIndex == -1 ? SERVER_NO_BRANCH
+                             : route->distance == FLT_MAX                    ? SERVER_NO_PATH
+                                                                             : SERVER_OK);
+            if (route->distance != FLT_MAX)
+            {
+                unsigned int bits;
+                memcpy(&bits, &route->distance, sizeof(bits));
+                replyU32(&writer, bits);
+                replyU32(&writer, (unsigned int)route->pathLength);
+                for (int i = 0; i < route->pathLength; i++)
+                {
+                    replyU32(&writer, (unsigned int)branchGraph[route->path[i]].data.branchId);
+                }
+            }
+        }
+        freeRouteBatch(&batch);
+        free(queries);
+        return replyEnd(&writer);
+    }
+    }
+
+    writer = replyBegin(connection, op, tag, SERVER_BAD_REQUEST);
+    return replyEnd(&writer);
+}
+
+// Read what the socket has and handle every whole frame. Returns false if
+// the connection should be dropped without waiting for its replies.
+bool serverRead(struct ServerConnection *connection)
+{
+    // Make room for a full read, without counting it as used yet
+    if (bufferReserve(&connection->in, &connection->inUsed, &connection->inCapacity, 65536) == NULL)
+    {
+        return false;
+    }
+    connection->inUsed -= 65536;
+    ssize_t got = read(connection->fd, connection->in + connection->inUsed, 65536);
+    if (got == 0)
+    {
+        connection->closing = true; // The client is done sending
+        return true;
+    }
+    if (got < 0)
+    {
+        return errno == EAGAIN || errno == EINTR;
+    }
+    connection->inUsed += (size_t)got;
+
+    size_t done = 0;
+    while (connection->inUsed - done >= 4)
+    {
+        unsigned int size = getU32(connection->in + done);
+        if (size < 5 || size > SERVER_MAX_FRAME)
+        {
+            return false;
+        }
+        if (connection->inUsed - done - 4 < size)
+        {
+            break;
+        }
+        if (!handleServerRequest(connection, connection->in + done + 4, size))
+        {
+            return false;
+        }
+        done += 4 + size;
+    }
+    memmove(connection->in, connection->in + done, connection->inUsed - done);
+    connection->inUsed -= done;
+    return true;
+}
+
+// Send as much of the waiting output as the socket takes
+bool serverWrite(struct ServerConnection *connection)
+{
+    while (connection->outSent < connection->outUsed)
+    {
+        ssize_t sent = send(connection->fd, connection->out + connection->outSent,
+                            connection->outUsed - connection->outSent, MSG_NOSIGNAL);
+        if (sent < 0)
+        {
+            return errno == EAGAIN || errno == EINTR;
+        }
+        connection->outSent += (size_t)sent;
+    }
+    connection->outUsed = 0;
+    connection->outSent = 0;
+    return true;
+}
+
+// Open address for the server (listening) or a client. An address with a
+// '/' is a Unix socket path; anything else is [host:]port over TCP.
+int openSocket(const char *address, bool listening)
+{
+    int fd;
+    if (strchr(address, '/') != NULL)
+    {
+        struct sockaddr_un local = {0};
+        local.sun_family = AF_UNIX;
+        if (strlen(address) >= sizeof(local.sun_path))
+        {
+            return -1;
+        }
+        strcpy(local.sun_path, address);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd == -1)
+        {
+            return -1;
+        }
+        if (listening)
+        {
+            unlink(address);
+        }
+        if ((listening ? bind(fd, (struct sockaddr *)&local, sizeof(local)) : connect(fd, (struct sockaddr *)&local, sizeof(local))) != 0)
+        {
+            close(fd);
+            return -1;
+        }
+    }
+    else
+    {
+        char host[256] = "";
+        const char *port = strrchr(address, ':');
+        if (port != NULL)
+        {
+            snprintf(host, sizeof(host), "%.*s", (int)(port - address), address);
+            port++;
+        }
+        else
+        {
+            port = address;
+        }
+
+        struct addrinfo hints = {0}, *found;
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_flags = listening ? AI_PASSIVE : 0;
+        if (getaddrinfo(host[0] != '\0' ? host : NULL, port, &hints, &found) != 0)
+        {
+            return -1;
+        }
+        fd = -1;
+        for (struct addrinfo *a = found; a != NULL && fd == -1; a = a->ai_next)
+        {
+            fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+            if (fd == -1)
+            {
+                continue;
+            }
+            int on = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+            if (listening)
+            {
+                setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+            }
+            if ((listening ? bind(fd, a->ai_addr, a->ai_addrlen) : connect(fd, a->ai_addr, a->ai_addrlen)) != 0)
+            {
+                close(fd);
+                fd = -1;
+            }
+        }
+        freeaddrinfo(found);
+        if (fd == -1)
+        {
+            return -1;
+        }
+    }
+
+    if (listening && listen(fd, SOMAXCONN) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+void setNonBlocking(int fd)
+{
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+void acceptConnections(int listener, int epollFd, long long *connectionCount)
+{
+    int fd;
+    while ((fd = accept(listener, NULL, NULL)) != -1)
+    {
+        setNonBlocking(fd);
+        int on = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on)); // Fails harmlessly on Unix sockets
+
+        struct ServerConnection *connection = (struct ServerConnection *)calloc(1, sizeof(*connection));
+        struct epoll_event event = {EPOLLIN, {.ptr = connection}};
+        if (connection == NULL || epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) != 0)
+        {
+            free(connection);
+            close(fd);
+            continue;
+        }
+        connection->fd = fd;
+        connection->interest = EPOLLIN;
+        (*connectionCount)++;
+    }
+}
+
+void closeConnection(struct ServerConnection *connection, long long *connectionCount)
+{
+    close(connection->fd); // Also takes it out of the epoll set
+    free(connection->in);
+    free(connection->out);
+    free(connection);
+    (*connectionCount)--;
+}
+
+// Serve clients until SIGINT or SIGTERM. Each wakeup handles every ready
+// connection's requests, then commits their journal records with one
+// fsync, and only then sends the replies, so a client never hears about
+// an operation that a crash could lose. If the commit fails, the round's
+// connections are closed without their replies and the server stops;
+// returns false.
+bool runServer(const char *address)
+{
+    int listener = openSocket(address, true);
+    if (listener == -1)
+    {
+        fprintf(stderr, "Could not listen on %s\n", address);
+        return false;
+    }
+    setNonBlocking(listener);
+    int epollFd = epoll_create1(0);
+    struct epoll_event listenEvent = {EPOLLIN, {.ptr = NULL}};
+    if (epollFd == -1 || epoll_ctl(epollFd, EPOLL_CTL_ADD, listener, &listenEvent) != 0)
+    {
+        fprintf(stderr, "Could not start the event loop\n");
+        close(listener);
+        return false;
+    }
+
+    signal(SIGINT, stopServer);
+    signal(SIGTERM, stopServer);
+    signal(SIGPIPE, SIG_IGN);
+    printf("Serving on %s\n", address);
+    fflush(stdout);
+
+    struct epoll_event events[SERVER_EVENT_BATCH];
+    long long connectionCount = 0;
+    bool failed = false;
+    while (!serverStopping)
+    {
+        int ready = epoll_wait(epollFd, events, SERVER_EVENT_BATCH, -1);
+        if (ready < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            break;
+        }
+
+        struct ServerConnection *listed = NULL;
+        for (int i = 0; i < ready; i++)
+        {
+            struct ServerConnection *connection = (struct ServerConnection *)events[i].data.ptr;
+            if (connection == NULL)
+            {
+                acceptConnections(listener, epollFd, &connectionCount);
+                continue;
+            }
+            if ((events[i].events & EPOLLIN) && !connection->closing && !serverRead(connection))
+            {
+                connection->closing = true;
+                connection->outUsed = connection->outSent = 0; // Drop it without replies
+            }
+            if (events[i].events & (EPOLLERR | EPOLLHUP))
+            {
+                connection->closing = true;
+            }
+            if (!connection->listed)
+            {
+                connection->listed = true;
+                connection->nextListed = listed;
+                listed = connection;
+            }
+        }
+
+        // One commit covers every operation of this round
+        mutexLock(&journalLock);
+        drainJournalRings();
+        bool committed = walFlush();
+        mutexUnlock(&journalLock);
+        if (!committed)
+        {
+            fprintf(stderr, "Could not commit the journal; stopping\n");
+            failed = true;
+            serverStopping = 1;
+        }
+
+        while (listed != NULL)
+        {
+            struct ServerConnection *connection = listed;
+            listed = connection->nextListed;
+            connection->listed = false;
+            if (!committed)
+            {
+                connection->closing = true;
+                connection->outUsed = connection->outSent = 0;
+            }
+
+            if (!serverWrite(connection) || (connection->closing && connection->outUsed == 0))
+            {
+                closeConnection(connection, &connectionCount);
+                continue;
+            }
+            // Stop reading a client that isn't taking its replies
+            size_t backlog = connection->outUsed - connection->outSent;
+            unsigned int interest = (connection->closing || backlog >= SERVER_OUTPUT_LIMIT ? 0 : EPOLLIN) |
+                                    (backlog > 0 ? EPOLLOUT : 0);
+            if (interest != connection->interest)
+            {
+                struct epoll_event event = {interest, {.ptr = connection}};
+                epoll_ctl(epollFd, EPOLL_CTL_MOD, connection->fd, &event);
+                connection->interest = interest;
+            }
+        }
+    }
+
+    printf("Stopping with %lld connection(s) open\n", connectionCount);
+    close(epollFd);
+    close(listener);
+    if (strchr(address, '/') != NULL)
+    {
+        unlink(address);
+    }
+    return !failed;
+}
+
+// Write one random request into the connection's output
+void queueLoadRequest(struct LoadConnection *c, int depth, int firstAccount, int accountCount)
+{
+    unsigned char *p = c->out + c->outUsed;
+    int accountNo = firstAccount + rand() % accountCount;
+    int choice = rand() % 10;
+    size_t size;
+    if (choice < 3)
+    {
+        p[4] = SERVER_DEPOSIT;
+    }
+    else if (choice < 5)
+    {
+        p[4] = SERVER_WITHDRAW;
+    }
+    else if (choice < 8)
+    {
+        p[4] = SERVER_TRANSFER;
+    }
+    else
+    {
+        p[4] = SERVER_LOOKUP;
+    }
+    putU32(p + 5, (unsigned int)c->sent);
+    putU32(p + 9, (unsigned int)accountNo);
+    if (p[4] == SERVER_LOOKUP)
+    {
+        size = 13;
+    }
+    else if (p[4] == SERVER_TRANSFER)
+    {
+        putU32(p + 13, (unsigned int)(firstAccount + rand() % accountCount));
+        putU64(p + 17, 100);
+        size = 25;
+    }
+    else
+    {
+        putU64(p + 13, 100);
+        size = 21;
+    }
+    putU32(p, (unsigned int)(size - 4));
+    c->outUsed += size;
+    c->sentAt[c->sent % depth] = monotonicNow();
+    c->sent++;
+}
+
+// Close the first opened connections of a load generator run and free
+// what it set up. Any of it may be missing if setting up failed.
+void closeLoadGenerator(struct LoadConnection *clients, int opened, double *latencies, int epollFd)
+{
+    for (int i = 0; i < opened; i++)
+    {
+        if (clients[i].fd != -1)
+        {
+            close(clients[i].fd);
+        }
+        free(clients[i].sentAt);
+    }
+    if (epollFd != -1)
+    {
+        close(epollFd);
+    }
+    free(latencies);
+    free(clients);
+}
+
+// Drive a running server from several connections at once and report the
+// throughput and latency percentiles. Logs in as the default user and
+// spreads deposits, withdrawals, transfers and lookups of 1.00 over
+// accountCount accounts from firstAccount.
+bool runLoadGenerator(const char *address, int connections, long long requests, int depth,
+                      int firstAccount, int accountCount)
+{
+    long long perConnection = requests / connections;
+    requests = perConnection * connections;
+    struct LoadConnection *clients = (struct LoadConnection *)calloc(connections, sizeof(*clients));
+    double *latencies = (double *)malloc(requests * sizeof(double));
+    int epollFd = epoll_create1(0);
+    if (clients == NULL || latencies == NULL || epollFd == -1 || requests == 0)
+    {
+        fprintf(stderr, "Could not set up the load generator\n");
+        closeLoadGenerator(clients, 0, latencies, epollFd);
+        return false;
+    }
+
+    // Connect and log in one at a time, before the clock starts
+    static const unsigned char loginFrame[] = {0, 0, 0, 18, SERVER_LOGIN, 0, 0, 0, 0,
+                                               4, 'u', 's', 'e', 'r', 7, 'u', 's', 'e', 'r', '1', '2', '3'};
+    for (int i = 0; i < connections; i++)
+    {
+        struct LoadConnection *c = &clients[i];
+        unsigned char reply[16];
+        size_t got = 0;
+        c->fd = openSocket(address, false);
+        c->sentAt = (double *)calloc(depth, sizeof(double));
+        if (c->fd == -1 || c->sentAt == NULL || send(c->fd, loginFrame, sizeof(loginFrame), MSG_NOSIGNAL) != (ssize_t)sizeof(loginFrame))
+        {
+            fprintf(stderr, "Could not connect to %s\n", address);
+            closeLoadGenerator(clients, i + 1, latencies, epollFd);
+            return false;
+        }
+        while (got < 4 || got < 4 + getU32(reply))
+        {
+            ssize_t n = read(c->fd, reply + got, sizeof(reply) - got);
+            if (n <= 0)
+            {
+                break;
+            }
+            got += (size_t)n;
+        }
+        if (got < 10 || reply[9] != SERVER_OK)
+        {
+            fprintf(stderr, "Login to %s failed\n", address);
+            closeLoadGenerator(clients, i + 1, latencies, epollFd);
+            return false;
+        }
+        setNonBlocking(c->fd);
+        struct epoll_event event = {EPOLLIN, {.ptr = c}};
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, c->fd, &event);
+    }
+
+    long long completed = 0, failed = 0;
+    bool stopped = false;
+    struct epoll_event events[SERVER_EVENT_BATCH];
+    double start = monotonicNow();
+    while (completed < requests && !stopped)
+    {
+        // Top every connection up to depth requests in flight
+        for (int i = 0; i < connections; i++)
+        {
+            struct LoadConnection *c = &clients[i];
+            while (c->sent < perConnection && c->sent - c->received < depth && c->outUsed + 25 <= sizeof(c->out))
+            {
+                queueLoadRequest(c, depth, firstAccount, accountCount);
+            }
+            while (c->outSent < c->outUsed)
+            {
+                ssize_t n = send(c->fd, c->out + c->outSent, c->outUsed - c->outSent, MSG_NOSIGNAL);
+                if (n <= 0)
+                {
+                    break;
+                }
+                c->outSent += (size_t)n;
+            }
+            if (c->outSent == c->outUsed)
+            {
+                c->outUsed = c->outSent = 0;
+            }
+        }
+
+        int ready = epoll_wait(epollFd, events, SERVER_EVENT_BATCH, 1000);
+        if (ready <= 0)
+        {
+            if (ready < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            fprintf(stderr, "The server stopped answering\n");
+            stopped = true;
+            break;
+        }
+        for (int i = 0; i < ready; i++)
+        {
+            struct LoadConnection *c = (struct LoadConnection *)events[i].data.ptr;
+            ssize_t n = read(c->fd, c->in + c->inUsed, sizeof(c->in) - c->inUsed);
+            if (n <= 0)
+            {
+                if (n == 0 || errno != EAGAIN)
+                {
+                    fprintf(stderr, "The server closed a connection\n");
+                    stopped = true;
+                }
+                continue;
+            }
+            c->inUsed += (size_t)n;
+
+            double now = monotonicNow();
+            size_t done = 0;
+            while (c->inUsed - done >= 4 && c->inUsed - done - 4 >= getU32(c->in + done))
+            {
+                const unsigned char *body = c->in + done + 4;
+                latencies[completed++] = now - c->sentAt[getU32(body + 1) % depth];
+                if (body[5] != SERVER_OK)
+                {
+                    failed++;
+                }
+                c->received++;
+                done += 4 + getU32(c->in + done);
+            }
+            memmove(c->in, c->in + done, c->inUsed - done);
+            c->inUsed -= done;
+        }
+    }
+    double seconds = monotonicNow() - start;
+
+    qsort(latencies, completed, sizeof(double), compareLatencies);
+    printf("%d connections, %d in flight each\n", connections, depth);
+    printf("%-10s %-10s %-10s %-10s %-10s %-10s %-10s %-10s\n",
+           "requests", "failed", "seconds", "req/s", "p50 us", "p90 us", "p99 us", "max us");
+    if (completed > 0)
+    {
+        printf("%-10lld %-10lld %-10.3f %-10.0f %-10.1f %-10.1f %-10.1f %-10.1f\n",
+               completed, failed, seconds, completed / seconds,
+               latencyPercentile(latencies, completed, 50) * 1e6,
+               latencyPercentile(latencies, completed, 90) * 1e6,
+               latencyPercentile(latencies, completed, 99) * 1e6,
+               latencies[completed - 1] * 1e6);
+    }
+    closeLoadGenerator(clients, connections, latencies, epollFd);
+    return !stopped;
+}
+
+#endif
+
+/***************************************************
+ * SECTION 12: MAIN AND MENU HANDLING FUNCTIONS
+ ***************************************************/
+
+// Handle account management menu
+void handleAccountMenu()
+{
+    int choice;
+    int accountNo;
+    char name[50], address[100], phone[15], email[50];
+    Money initialBalance;
+    bool created;
+    
+    do {
+        displayAccountMenu();
+        scanf("%d", &choice);
+        getchar(); // Clear input buffer
+        
+        switch (choice) {
+            case 1: // Create New Account
+                printf("\n%s%s Create New Account %s\n", BG_GREEN, BLACK, RESET);
+                
+                printf("%sEnter Account Number: %s", CYAN, RESET);
+                scanf("%d", &accountNo);
+                getchar(); // Clear input buffer
+                
+                printf("%sEnter Name: %s", CYAN, RESET);
+                fgets(name, sizeof(name), stdin);
+                name[strcspn(name, "\n")] = 0; // Remove newline
+                
+                printf("%sEnter Initial Balance: %s", CYAN, RESET);
+                scanMoney(&initialBalance);
+                getchar(); // Clear input buffer
+                
+                printf("%sEnter Address: %s", CYAN, RESET);
+                fgets(address, sizeof(address), stdin);
+                address[strcspn(address, "\n")] = 0;
+                
+                printf("%sEnter Phone Number: %s", CYAN, RESET);
+                fgets(phone, sizeof(phone), stdin);
+                phone[strcspn(phone, "\n")] = 0;
+                
+                printf("%sEnter Email: %s", CYAN, RESET);
+                fgets(email, sizeof(email), stdin);
+                email[strcspn(email, "\n")] = 0;
+                
+                lockAllAccounts();
+                created = addAccount(accountNo, name, initialBalance, address, phone, email);
+                unlockAllAccounts();
+                if (created) {
+                    printf("%sAccount created successfully!%s\n", GREEN, RESET);
+                } else {
+                    printf("%sAccount number already exists!%s\n", RED, RESET);
+                }
+                pauseExecution();
+                break;
+                
+            case 2: // View All Accounts
+                viewAllAccounts();
+                pauseExecution();
+                break;
+                
+            case 3: // Search Account by Number
+                searchAccount();
+                pauseExecution();
+                break;
+                
+            case 4: // Update Account Details
+                printf("\n%sEnter Account Number to update: %s", CYAN, RESET);
+                scanf("%d", &accountNo);
+                getchar(); // Clear input buffer
+                
+                if (!updateAccountDetails(accountNo)) {
+                    printf("%sAccount not found!%s\n", RED, RESET);
+                }
+                pauseExecution();
+                break;
+                
+            case 5: // Delete Account
+                printf("\n%sEnter Account Number to delete: %s", CYAN, RESET);
+                scanf("%d", &accountNo);
+                getchar(); // Clear input buffer
+                
+                if (deleteAccount(accountNo)) {
+                    printf("%sAccount deleted successfully!%s\n", GREEN, RESET);
+                } else {
+                    printf("%sAccount not found!%s\n", RED, RESET);
+                }
+                pauseExecution();
+                break;
+                
+            case 6: // Return to Main Menu
+                break;
+                
+            default:
+                printf("%sInvalid choice!%s\n", RED, RESET);
+                pauseExecution();
+        }
+    } while (choice != 6);
+}
+
+// Handle transaction menu
+void handleTransactionMenu()
+{
+    int choice;
+    int accountNo, toAccountNo;
+    long long transactionId;
+    int fromYear = 0, fromMonth = 0, fromDay = 0, toYear = 0, toMonth = 0, toDay = 0;
+    Money amount;
+    
+    do {
+        displayTransactionMenu();
+        scanf("%d", &choice);
+        getchar(); // Clear input buffer
+        
+        switch (choice) {
+            case 1: // Deposit
+                printf("\n%s%s Deposit %s\n", BG_GREEN, BLACK, RESET);
+                
+                printf("%sEnter Account Number: %s", CYAN, RESET);
+                scanf("%d", &accountNo);
+                getchar(); // Clear input buffer
+                
+                printf("%sEnter Amount to Deposit: %s", CYAN, RESET);
+                scanMoney(&amount);
+                getchar(); // Clear input buffer
+                
+                if (deposit(accountNo, amount)) {
+                    printf("%sDeposit successful!%s\n", GREEN, RESET);
+                } else {
+                    printf("%sAccount not found!%s\n", RED, RESET);
+                }
+                pauseExecution();
+                break;
+                
+            case 2: // Withdraw
+                printf("\n%s%s Withdraw %s\n", BG_GREEN, BLACK, RESET);
+                
+                printf("%sEnter Account Number: %s", CYAN, RESET);
+                scanf("%d", &accountNo);
+                getchar(); // Clear input buffer
+                
+                printf("%sEnter Amount to Withdraw: %s", CYAN, RESET);
+                scanMoney(&amount);
+                getchar(); // Clear input buffer
+                
+                if (withdraw(accountNo, amount)) {
+                    printf("%sWithdrawal successful!%s\n", GREEN, RESET);
+                } else {
+                    printf("%sAccount not found or insufficient balance!%s\n", RED, RESET);
+                }
+                pauseExecution();
+                break;
+                
+            case 3: // Transfer
+                printf("\n%s%s Transfer %s\n", BG_GREEN, BLACK, RESET);
+                
+                printf("%sEnter Source Account Number: %s", CYAN, RESET);
+                scanf("%d", &accountNo);
+                getchar(); // Clear input buffer
+                
+                printf("%sEnter Destination Account Number: %s", CYAN, RESET);
+                scanf("%d", &toAccountNo);
+                getchar(); // Clear input buffer
+                
+                printf("%sEnter Amount to Transfer: %s", CYAN, RESET);
+                scanMoney(&amount);
+                getchar(); // Clear input buffer
+                
+                if (transfer(accountNo, toAccountNo, amount)) {
+                    printf("%sTransfer successful!%s\n", GREEN, RESET);
+                } else {
+                    printf("%sTransaction failed! Check account numbers and balance.%s\n", RED, RESET);
+                }
+                pauseExecution();
+                break;
+                
+            case 4: // View All Transactions
+                viewTransactions();
+                pauseExecution();
+                break;
+                
+            case 5: // View Account Transactions
+                printf("\n%sEnter Account Number: %s", CYAN, RESET);
+                scanf("%d", &accountNo);
+                getchar(); // Clear input buffer
+                
+                viewAccountTransactions(accountNo);
+                pauseExecution();
+                break;
+                
+            case 6: // Undo Last Transaction
+                if (undoLastTransaction()) {
+                    printf("%sTransaction undone successfully!%s\n", GREEN, RESET);
+                } else {
+                    printf("%sNo transactions to undo or invalid transaction!%s\n", RED, RESET);
+                }
+                pauseExecution();
+                break;
+                
+            case 7: // End-of-Day Reconciliation
+                viewReconciliationReport();
+                pauseExecution();
+                break;
+                
+            case 8: // Find Transaction by ID
+                printf("\n%sEnter Transaction ID: %s", CYAN, RESET);
+                scanf("%lld", &transactionId);
+                getchar(); // Clear input buffer
+                
+                viewTransactionById(transactionId);
+                pauseExecution();
+                break;
+                
+            case 9: // View Transactions Between Dates
+                printf("\n%sEnter Start Date (YYYY-MM-DD): %s", CYAN, RESET);
+                scanf("%d-%d-%d", &fromYear, &fromMonth, &fromDay);
+                getchar(); // Clear input buffer
+                
+                printf("%sEnter End Date (YYYY-MM-DD): %s", CYAN, RESET);
+                scanf("%d-%d-%d", &toYear, &toMonth, &toDay);
+                getchar(); // Clear input buffer
+                
+                viewTransactionsBetween(fromYear, fromMonth, fromDay, toYear, toMonth, toDay);
+                pauseExecution();
+                break;
+                
+            case 10: // Monthly Account Statement
+                printf("\n%sEnter Account Number: %s", CYAN, RESET);
+                scanf("%d", &accountNo);
+                getchar(); // Clear input buffer
+                
+                printf("%sEnter Month (YYYY-MM): %s", CYAN, RESET);
+                scanf("%d-%d", &fromYear, &fromMonth);
+                getchar(); // Clear input buffer
+                
+                viewAccountStatement(accountNo, fromYear, fromMonth);
+                pauseExecution();
+                break;
+                
+            case 11: // Return to Main Menu
+                break;
+                
+            default:
+                printf("%sInvalid choice!%s\n", RED, RESET);
+                pauseExecution();
+        }
+    } while (choice != 11);
+}
+
+// Handle service request menu
+void handleServiceMenu()
+{
+    int choice;
+    int accountNo, priority, requestId, workers;
+    char requestType[50], description[200];
+    
+    do {
+        displayServiceMenu();
+        scanf("%d", &choice);
+        getchar(); // Clear input buffer
+        
+        switch (choice) {
+            case 1: // Submit New Request
+                printf("\n%s%s Submit Service Request %s\n", BG_GREEN, BLACK, RESET);
+                
+                printf("%sEnter Account Number: %s", CYAN, RESET);
+                scanf("%d", &accountNo);
+                getchar(); // Clear input buffer
+                
+                printf("%sEnter Request Type: %s", CYAN, RESET);
+                fgets(requestType, sizeof(requestType), stdin);
+                requestType[strcspn(requestType, "\n")] = 0; // Remove newline
+                
+                printf("%sEnter Description: %s", CYAN, RESET);
+                fgets(description, sizeof(description), stdin);
+                description[strcspn(description, "\n")] = 0;
+                
+                printf("%sEnter Priority (1-5, 5 being highest): %s", CYAN, RESET);
+                scanf("%d", &priority);
+                getchar(); // Clear input buffer
+                
+                if (priority < 1 || priority > 5) {
+                    printf("%sInvalid priority! Setting to default (3).%s\n", YELLOW, RESET);
+                    priority = 3;
+                }
+                
+                if (submitServiceRequest(accountNo, requestType, description, priority) != -1) {
+                    printf("%sService request submitted successfully!%s\n", GREEN, RESET);
+                } else {
+                    printf("%sAccount not found!%s\n", RED, RESET);
+                }
+                pauseExecution();
+                break;
+                
+            case 2: // View All Pending Requests
+                viewPendingRequests();
+                pauseExecution();
+                break;
+                
+            case 3: // Process Next Request
+                processNextRequest();
+                pauseExecution();
+                break;
+                
+            case 4: // Process All Requests
+                printf("%sEnter Number of Workers (0 for one per processor): %s", CYAN, RESET);
+                scanf("%d", &workers);
+                getchar(); // Clear input buffer
+                processAllRequests(workers > 0 ? workers : processorCount());
+                pauseExecution();
+                break;
+                
+            case 5: // Cancel a Request
+                printf("%sEnter Request ID: %s", CYAN, RESET);
+                scanf("%d", &requestId);
+                getchar(); // Clear input buffer
+                cancelServiceRequest(requestId);
+                pauseExecution();
+                break;
+                
+            case 6: // Change a Request's Priority
+                printf("%sEnter Request ID: %s", CYAN, RESET);
+                scanf("%d", &requestId);
+                getchar(); // Clear input buffer
+                
+                printf("%sEnter New Priority (1-5, 5 being highest): %s", CYAN, RESET);
+                scanf("%d", &priority);
+                getchar(); // Clear input buffer
+                
+                if (priority < 1 || priority > 5) {
+                    printf("%sInvalid priority!%s\n", RED, RESET);
+                } else {
+                    changeRequestPriority(requestId, priority);
+                }
+                pauseExecution();
+                break;
+                
+            case 7: // Return to Main Menu
+                break;
+                
+            default:
+                printf("%sInvalid choice!%s\n", RED, RESET);
+                pauseExecution();
+        }
+    } while (choice != 7);
+}
+
+// Handle branch management menu
+void handleBranchMenu()
+{
+    int choice;
+    int branchId, targetBranchId, employeeCount;
+    float distance;
+    char branchName[50], location[100], managerName[50], phoneNumber[15];
+    
+    do {
+        displayBranchMenu();
+        scanf("%d", &choice);
+        getchar(); // Clear input buffer
+        
+        switch (choice) {
+            case 1: // Add New Branch
+                printf("\n%s%s Add New Branch %s\n", BG_GREEN, BLACK, RESET);
+                
+                printf("%sEnter Branch ID: %s", CYAN, RESET);
+                scanf("%d", &branchId);
+                getchar(); // Clear input buffer
+                
+                printf("%sEnter Branch Name: %s", CYAN, RESET);
+                fgets(branchName, sizeof(branchName), stdin);
+                branchName[strcspn(branchName, "\n")] = 0; // Remove newline
+                
+                printf("%sEnter Location: %s", CYAN, RESET);
+                fgets(location, sizeof(location), stdin);
+                location[strcspn(location, "\n")] = 0;
+                
+                printf("%sEnter Manager Name: %s", CYAN, RESET);
+                fgets(managerName, sizeof(managerName), stdin);
+                managerName[strcspn(managerName, "\n")] = 0;
+                
+                printf("%sEnter Phone Number: %s", CYAN, RESET);
+                fgets(phoneNumber, sizeof(phoneNumber), stdin);
+                phoneNumber[strcspn(phoneNumber, "\n")] = 0;
+                
+                printf("%sEnter Employee Count: %s", CYAN, RESET);
+                scanf("%d", &employeeCount);
+                getchar(); // Clear input buffer
+                
+                if (addBranch(branchId, branchName, location, managerName, phoneNumber, employeeCount))
+                {
+                    printf("%sBranch added successfully!%s\n", GREEN, RESET);
+                }
+                else
+                {
+                    printf("%sBranch ID %d is already in use.%s\n", RED, branchId, RESET);
+                }
+                pauseExecution();
+                break;
+                
+            case 2: // View All Branches
+                viewAllBranches();
+                pauseExecution();
+                break;
+                
+            case 3: // Add Branch Connection
+                printf("\n%s%s Add Branch Connection %s\n", BG_GREEN, BLACK, RESET);
+                
+                printf("%sEnter Source Branch ID: %s", CYAN, RESET);
+                scanf("%d", &branchId);
+                getchar(); // Clear input buffer
+                
+                printf("%sEnter Target Branch ID: %s", CYAN, RESET);
+                scanf("%d", &targetBranchId);
+                getchar(); // Clear input buffer
+                
+                printf("%sEnter Distance (in km): %s", CYAN, RESET);
+                scanf("%f", &distance);
+                getchar(); // Clear input buffer
+                
+                if (addConnection(branchId, targetBranchId, distance))
+                {
+                    printf("%sConnection added successfully!%s\n", GREEN, RESET);
+                }
+                else if (!validLinkDistance(distance))
+                {
+                    printf("%sThe distance must be a number of zero or more.%s\n", RED, RESET);
+                }
+                else
+                {
+                    printf("%sCould not add the connection; branch ID %d was not found.%s\n", RED, branchId, RESET);
+                }
+                pauseExecution();
+                break;
+                
+            case 4: // View Branch Connections
+                printf("\n%sEnter Branch ID: %s", CYAN, RESET);
+                scanf("%d", &branchId);
+                getchar(); // Clear input buffer
+                
+                viewBranchConnections(branchId);
+                pauseExecution();
+                break;
+                
+            case 5: // Find Shortest Path Between Branches
+                printf("\n%s%s Find Shortest Path %s\n", BG_GREEN, BLACK, RESET);
+                
+                printf("%sEnter Start Branch ID: %s", CYAN, RESET);
+                scanf("%d", &branchId);
+                getchar(); // Clear input buffer
+                
+                printf("%sEnter Destination Branch ID: %s", CYAN, RESET);
+                scanf("%d", &targetBranchId);
+                getchar(); // Clear input buffer
+                
+                findShortestPath(branchId, targetBranchId);
+                pauseExecution();
+                break;
+                
+            case 6: // Prepare Routes for a Large Network
+                prepareBranchRoutes();
+                pauseExecution();
+                break;
+                
+            case 7: // Return to Main Menu
+                break;
+                
+            default:
+                printf("%sInvalid choice!%s\n", RED, RESET);
+                pauseExecution();
+        }
+    } while (choice != 7);
+}
+
+// Handle user management menu
+void handleUserManagementMenu()
+{
+    int choice;
+    char username[50], password[50];
+    int isAdmin;
+    
+    do {
+        displayUserManagementMenu();
+        scanf("%d", &choice);
+        getchar(); // Clear input buffer
+        
+        switch (choice) {
+            case 1: // Add New User
+                printf("\n%s%s Add New User %s\n", BG_GREEN, BLACK, RESET);
+                
+                printf("%sEnter Username: %s", CYAN, RESET);
+                fgets(username, sizeof(username), stdin);
+                username[strcspn(username, "\n")] = 0; // Remove newline
+                
+                printf("%sEnter Password: %s", CYAN, RESET);
+                fgets(password, sizeof(password), stdin);
+                password[strcspn(password, "\n")] = 0;
+                
+                printf("%sIs Admin (1 for Yes, 0 for No): %s", CYAN, RESET);
+                scanf("%d", &isAdmin);
+                getchar(); // Clear input buffer
+                
+                if (addUser(username, password, isAdmin == 1)) {
+                    printf("%sUser added successfully!%s\n", GREEN, RESET);
+                } else {
+                    printf("%sFailed to add user! Username might exist already.%s\n", RED, RESET);
+                }
+                pauseExecution();
+                break;
+                
+            case 2: // View All Users
+                printf("\n%s%s All Users %s\n", BG_GREEN, BLACK, RESET);
+                printf("%s%s%-20s %-15s %s\n", BG_CYAN, BLACK, "Username", "Role", RESET);
+                
+                for (int i = 0; i < userCount; i++) {
+                    printf("%-20s %-15s\n", 
+                          users[i].username, 
+                          users[i].isAdmin ? "Administrator" : "Regular User");
+                }
+                pauseExecution();
+                break;
+                
+            case 3: // Return to Main Menu
+                break;
+                
+            default:
+                printf("%sInvalid choice!%s\n", RED, RESET);
+                pauseExecution();
+        }
+    } while (choice != 3);
+}
+
+// Handle save/load menu
+void handleSaveLoadMenu()
+{
+    int choice;
+    
+    do {
+        displaySaveLoadMenu();
+        scanf("%d", &choice);
+        getchar(); // Clear input buffer
+        
+        switch (choice) {
+            case 1: // Save All Data
+                saveAllData();
+                pauseExecution();
+                break;
+                
+            case 2: // Load All Data
+                loadAllData();
+                printf("%sAll data loaded successfully!%s\n", GREEN, RESET);
+                pauseExecution();
+                break;
+                
+            case 3: // View Memory Statistics
+                printf("\n%s%s Node Pool Statistics %s\n", BG_GREEN, BLACK, RESET);
+                printPoolStats();
+                pauseExecution();
+                break;
+                
+            case 4: // Return to Main Menu
+                break;
+                
+            default:
+                printf("%sInvalid choice!%s\n", RED, RESET);
+                pauseExecution();
+        }
+    } while (choice != 4);
+}
+
+// Handle user account operations (regular user)
+void handleUserAccountOperations()
+{
+    int choice;
+    int accountNo, toAccountNo;
+    Money amount;
+    char requestType[50], description[200];
+    int priority;
+    
+    do {
+        displayUserMenu();
+        scanf("%d", &choice);
+        getchar(); // Clear input buffer
+        
+        switch (choice) {
+            case 1: // View Account Details
+                printf("\n%sEnter Your Account Number: %s", CYAN, RESET);
+                scanf("%d", &accountNo);
+                getchar(); // Clear input buffer
+                
+                searchAccount();
+                pauseExecution();
+                break;
+                
+            case 2: // Make a Transaction
+                printf("\n%s%s Transaction Options %s\n", BG_GREEN, BLACK, RESET);
+                printf("%s 1. Deposit %s\n", YELLOW, RESET);
+                printf("%s 2. Withdraw %s\n", YELLOW, RESET);
+                printf("%s 3. Transfer %s\n", YELLOW, RESET);
+                printf("\n%sEnter choice: %s", GREEN, RESET);
+                
+                int transChoice;
+                scanf("%d", &transChoice);
+                getchar(); // Clear input buffer
+                
+                switch (transChoice) {
+                    case 1: // Deposit
+                        printf("\n%sEnter Your Account Number: %s", CYAN, RESET);
+                        scanf("%d", &accountNo);
+                        getchar(); // Clear input buffer
+                        
+                        printf("%sEnter Amount to Deposit: %s", CYAN, RESET);
+                        scanMoney(&amount);
+                        getchar(); // Clear input buffer
+                        
+                        if (deposit(accountNo, amount)) {
+                            printf("%sDeposit successful!%s\n", GREEN, RESET);
+                        } else {
+                            printf("%sAccount not found!%s\n", RED, RESET);
+                        }
+                        break;
+                        
+                    case 2: // Withdraw
+                        printf("\n%sEnter Your Account Number: %s", CYAN, RESET);
+                        scanf("%d", &accountNo);
+                        getchar(); // Clear input buffer
+                        
+                        printf("%sEnter Amount to Withdraw: %s", CYAN, RESET);
+                        scanMoney(&amount);
+                        getchar(); // Clear input buffer
+                        
+                        if (withdraw(accountNo, amount)) {
+                            printf("%sWithdrawal successful!%s\n", GREEN, RESET);
+                        } else {
+                            printf("%sAccount not found or insufficient balance!%s\n", RED, RESET);
+                        }
+                        break;
+                        
+                    case 3: // Transfer
+                        printf("\n%sEnter Your Account Number: %s", CYAN, RESET);
+                        scanf("%d", &accountNo);
+                        getchar(); // Clear input buffer
+                        
+                        printf("%sEnter Destination Account Number: %s", CYAN, RESET);
+                        scanf("%d", &toAccountNo);
+                        getchar(); // Clear input buffer
+                        
+                        printf("%sEnter Amount to Transfer: %s", CYAN, RESET);
+                        scanMoney(&amount);
+                        getchar(); // Clear input buffer
+                        
+                        if (transfer(accountNo, toAccountNo, amount)) {
+                            printf("%sTransfer successful!%s\n", GREEN, RESET);
+                        } else {
+                            printf("%sTransaction failed! Check account numbers and balance.%s\n", RED, RESET);
+                        }
+                        break;
+                        
+                    default:
+                        printf("%sInvalid choice!%s\n", RED, RESET);
+                }
+                pauseExecution();
+                break;
+                
+            case 3: // Submit Service Request
+                printf("\n%s%s Submit Service Request %s\n", BG_GREEN, BLACK, RESET);
+                
+                printf("%sEnter Your Account Number: %s", CYAN, RESET);
+                scanf("%d", &accountNo);
+                getchar(); // Clear input buffer
+                
+                printf("%sEnter Request Type: %s", CYAN, RESET);
+                fgets(requestType, sizeof(requestType), stdin);
+                requestType[strcspn(requestType, "\n")] = 0; // Remove newline
+                
+                printf("%sEnter Description: %s", CYAN, RESET);
+                fgets(description, sizeof(description), stdin);
+                description[strcspn(description, "\n")] = 0;
+                
+                printf("%sEnter Priority (1-5, 5 being highest): %s", CYAN, RESET);
+                scanf("%d", &priority);
+                getchar(); // Clear input buffer
+                
+                if (priority < 1 || priority > 5) {
+                    printf("%sInvalid priority! Setting to default (3).%s\n", YELLOW, RESET);
+                    priority = 3;
+                }
+                
+                if (submitServiceRequest(accountNo, requestType, description, priority) != -1) {
+                    printf("%sService request submitted successfully!%s\n", GREEN, RESET);
+                } else {
+                    printf("%sAccount not found!%s\n", RED, RESET);
+                }
+                pauseExecution();
+                break;
+                
+            case 4: // View Branch Information
+                viewAllBranches();
+                
+                printf("\n%sDo you want to see branch connections? (1 for Yes, 0 for No): %s", CYAN, RESET);
+                int showConnections;
+                scanf("%d", &showConnections);
+                getchar(); // Clear input buffer
+                
+                if (showConnections) {
+                    printf("\n%sEnter Branch ID: %s", CYAN, RESET);
+                    scanf("%d", &accountNo); // Reusing accountNo variable for branch ID
+                    getchar(); // Clear input buffer
+                    
+                    viewBranchConnections(accountNo);
+                }
+                pauseExecution();
+                break;
+                
+            case 5: // Logout
+                printf("%sLogging out...%s\n", YELLOW, RESET);
+                // Clear current user info
+                strcpy(currentUser.username, "");
+                strcpy(currentUser.password, "");
+                currentUser.isAdmin = false;
+                break;
+                
+            case 6: // Exit
+                printf("%sThank you for using the Bank Management System!%s\n", GREEN, RESET);
+                saveAllData(); // Auto-save on exit
+                exit(0);
+                
+            default:
+                printf("%sInvalid choice!%s\n", RED, RESET);
+                pauseExecution();
+        }
+    } while (choice != 5 && choice != 6);
+}
+
+// Handle admin operations
+void handleAdminOperations()
+{
+    int choice;
+    
+    do {
+        displayAdminMenu();
+        scanf("%d", &choice);
+        getchar(); // Clear input buffer
+        
+        switch (choice) {
+            case 1: // Account Management
+                handleAccountMenu();
+                break;
+                
+            case 2: // Transaction Management
+                handleTransactionMenu();
+                break;
+                
+            case 3: // Service Request Management
+                handleServiceMenu();
+                break;
+                
+            case 4: // Branch Management
+                handleBranchMenu();
+                break;
+                
+            case 5: // User Management
+                handleUserManagementMenu();
+                break;
+                
+            case 6: // Save/Load Data
+                handleSaveLoadMenu();
+                break;
+                
+            case 7: // Logout
+                printf("%sLogging out...%s\n", YELLOW, RESET);
+                // Clear current user info
+                strcpy(currentUser.username, "");
+                strcpy(currentUser.password, "");
+                currentUser.isAdmin = false;
+                break;
+                
+            case 8: // Exit
+                printf("%sThank you for using the Bank Management System!%s\n", GREEN, RESET);
+                saveAllData(); // Auto-save on exit
+                exit(0);
+                
+            default:
+                printf("%sInvalid choice!%s\n", RED, RESET);
+                pauseExecution();
+        }
+    } while (choice != 7 && choice != 8);
+}
+
+// Main function
+int main(int argc, char *argv[])
+{
+    // Initialize the random number generator
+    srand(time(NULL));
+    initializeLocks();
+    
+    // Benchmarks run against an empty in-memory bank, before any data is loaded
+    if (argc >= 3 && strcmp(argv[1], "--bench") == 0) {
+        return runBenchmark(argv[2]);
+    }
+    
+    // Post a file of deposits, withdrawals and transfers and exit
+    if (argc >= 3 && strcmp(argv[1], "--post") == 0) {
+        walConfigure(POSTING_BATCH_SIZE, 1.0);
+        int savedStdout = redirectStdout(fileno(stderr));
+        loadAllData();
+        restoreStdout(savedStdout);
+        bool done = postBatchFile(argv[2]);
+        bool closed = walClose();
+        return done && closed ? 0 : 1;
+    }
+    
+    // Run a command file, or stdin, without the menus and exit
+    if (argc >= 2 && strcmp(argv[1], "--batch") == 0) {
+        int savedStdout = redirectStdout(fileno(stderr));
+        loadAllData();
+        restoreStdout(savedStdout);
+        bool done = runCommandFile(argc >= 3 ? argv[2] : "-");
+        bool closed = walClose();
+        return done && closed ? 0 : 1;
+    }
+    
+    // Serve clients over a socket until stopped
+    if (argc >= 3 && strcmp(argv[1], "--serve") == 0) {
+#ifdef __linux__
+        initializeUsers();
+        // Each event loop round commits its own group
+        walConfigure(POSTING_BATCH_SIZE, 1.0);
+        loadAllData();
+        bool done = runServer(argv[2]);
+        bool closed = walClose();
+        return done && closed ? 0 : 1;
+#else
+        fprintf(stderr, "Server mode needs Linux\n");
+        return 1;
+#endif
+    }
+    
+    // Load a running server: --load <address> [connections] [requests]
+    // [in flight per connection] [first account] [account count]
+    if (argc >= 3 && strcmp(argv[1], "--load") == 0) {
+#ifdef __linux__
+        int connections = argc >= 4 ? atoi(argv[3]) : 8;
+        long long requests = argc >= 5 ? atoll(argv[4]) : 200000;
+        int depth = argc >= 6 ? atoi(argv[5]) : 16;
+        int firstAccount = argc >= 7 ? atoi(argv[6]) : 1001;
+        int accountCount = argc >= 8 ? atoi(argv[7]) : 5;
+        if (connections < 1 || depth < 1 || accountCount < 1) {
+            fprintf(stderr, "Connections, depth and account count must be at least 1\n");
+            return 1;
+        }
+        return runLoadGenerator(argv[2], connections, requests, depth, firstAccount, accountCount) ? 0 : 1;
+#else
+        fprintf(stderr, "The load generator needs Linux\n");
+        return 1;
+#endif
+    }
+    
+    // Convert pre-cents data files in the working directory and exit
+    if (argc >= 2 && strcmp(argv[1], "--convert") == 0) {
+        convertLegacyDataFiles();
+        return 0;
+    }
+    
+    // Initialize users
+    initializeUsers();
+    
+    // Operations come one at a time from the menus, so commit each before
+    // reporting it done rather than waiting to fill a group
+    walConfigure(1, 0);
+    
+    // Load saved data and replay the journal
+    loadAllData();
+    
+    // Main program loop
+    while (1) {
+        clearScreen();
+        displayBanner();
+        
+        // Login if not already logged in
+        if (strlen(currentUser.username) == 0) {
+            char username[50], password[50];
+            bool isAdmin;
+            
+            printf("\n%s%s LOGIN %s\n", BG_CYAN, BLACK, RESET);
+            printf("%sUsername: %s", CYAN, RESET);
+            fgets(username, sizeof(username), stdin);
+            username[strcspn(username, "\n")] = 0; // Remove newline
+            
+            printf("%sPassword: %s", CYAN, RESET);
+            fgets(password, sizeof(password), stdin);
+            password[strcspn(password, "\n")] = 0;
+            
+            if (login(username, password, &isAdmin)) {
+                printf("%sLogin successful!%s\n", GREEN, RESET);
+                pauseExecution();
+                
+                if (isAdmin) {
+                    handleAdminOperations();
+                } else {
+                    handleUserAccountOperations();
+                }
+            } else {
+                printf("%sInvalid username or password!%s\n", RED, RESET);
+                pauseExecution();
+            }
+        } else {
+            // User is already logged in, direct to appropriate menu
+            if (currentUser.isAdmin) {
+                handleAdminOperations();
+            } else {
+                handleUserAccountOperations();
+            }
+        }
+    }
+    
+    return 0;
 }
\ No newline at end of file